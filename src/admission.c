@@ -0,0 +1,82 @@
+/**
+ * @file admission.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "admission.h"
+
+#define SHED_STR(x) #x
+#define SHED_XSTR(x) SHED_STR(x)
+
+static const char overloaded_response[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 20\r\n"
+    "Retry-After: " SHED_XSTR(SHED_RETRY_AFTER) "\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Service Unavailable\n";
+
+static unsigned long shed_counts[SHED_REASONS];
+
+/**
+ * @brief Decides whether the server can take on more work
+ *
+ * Details: The checks only read counters, so they are cheap enough to run for every connection and request.
+ *
+ * @param[in] config The server configuration holding the limits
+ * @param[in] pool The thread pool requests are queued in (NULL if requests are answered without it)
+ * @param[in] new_connection true for a connection that has just been accepted, false for a received request
+ * @return ADMIT, or the reason the work has to be shed
+ */
+shed_reason admission_check(Server_config *config, ThreadPool *pool, bool new_connection)
+{
+    if (new_connection && config->max_connections > 0 &&
+        __atomic_load_n(&num_clients, __ATOMIC_RELAXED) >= config->max_connections)
+        return SHED_CONNECTIONS;
+
+    if (pool == NULL || config->enable_mt == OFF)
+        return ADMIT;
+
+    if (config->max_queued > 0 && thread_pool_queued(pool) >= config->max_queued)
+        return SHED_QUEUE_DEPTH;
+
+    if (config->max_queue_wait_ms > 0 && thread_pool_queue_wait_ms(pool) >= config->max_queue_wait_ms)
+        return SHED_QUEUE_WAIT;
+
+    return ADMIT;
+}
+
+/**
+ * @brief Turns a client away with 503 Service Unavailable
+ *
+ * Details: Up to SHED_DRAIN_SIZE bytes the client has already sent are read and dropped first: closing a socket
+ *          with unread data resets the connection, and the client could lose the response. The response is sent
+ *          on a best effort basis and the caller closes the connection.
+ *
+ * @param[in] connfd The client's socket
+ * @param[in] reason Why the client is turned away (counted in the admission statistics)
+ */
+void send_overloaded(const int connfd, shed_reason reason)
+{
+    char drain[SHED_DRAIN_SIZE];
+
+    __atomic_add_fetch(&shed_counts[reason], 1, __ATOMIC_RELAXED);
+
+    if (recv(connfd, drain, sizeof(drain), MSG_DONTWAIT) == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return;     // the client is gone already
+
+    send(connfd, overloaded_response, sizeof(overloaded_response) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+/**
+ * @brief Reads the admission statistics
+ *
+ * @param[out] stats The number of requests shed so far, by reason
+ */
+void admission_get_stats(Admission_stats *stats)
+{
+    for (int i = 0; i < SHED_REASONS; i++)
+        stats->shed[i] = __atomic_load_n(&shed_counts[i], __ATOMIC_RELAXED);
+}
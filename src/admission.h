@@ -0,0 +1,51 @@
+/**
+ * @file admission.h
+ * @brief Admission control: turning work away with 503 Service Unavailable when the server is overloaded
+ * @authors
+ *
+ * Details:
+ * - Before a new connection is taken on, and before a received request is queued for a worker, the server checks
+ *   its budget: the number of open connections (-o), the number of requests waiting in the thread pool's queues
+ *   (-d) and how long they currently wait there (-w).
+ * - Work over budget is shed: a response prepared at compile time (503 with Retry-After: SHED_RETRY_AFTER) is
+ *   written straight to the socket by the thread that accepted or read it, and the connection is closed. Nothing
+ *   is allocated or queued for it, so shedding stays cheap however far behind the workers are.
+ * - Every shed request is counted by the reason it was shed for (see admission_get_stats()).
+ *
+ * Assumptions/Limitations:
+ * - A limit of 0 disables that check. The queue limits only apply while requests are answered by the thread pool
+ *   (-m on).
+ * - The response is written with a single non-blocking send(); if the socket cannot take it at once the client
+ *   only sees the connection close.
+ *
+ * @date 2026-10-17
+ */
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "server.h"
+
+#define SHED_RETRY_AFTER 1              /* seconds a client that was turned away is asked to wait */
+#define SHED_DRAIN_SIZE 4096            /* bytes of unread request read (and dropped) before the socket is closed */
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef enum {
+    ADMIT = -1,                         /* within budget */
+    SHED_CONNECTIONS,                   /* too many open connections */
+    SHED_QUEUE_DEPTH,                   /* too many requests waiting for a worker */
+    SHED_QUEUE_WAIT,                    /* requests wait too long for a worker */
+    SHED_REASONS
+} shed_reason;
+
+typedef struct {
+    unsigned long shed[SHED_REASONS];   /* requests turned away, by reason */
+} Admission_stats;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern shed_reason admission_check(Server_config *config, ThreadPool *pool, bool new_connection);
+extern void send_overloaded(const int connfd, shed_reason reason);
+extern void admission_get_stats(Admission_stats *stats);
+
+#endif
@@ -0,0 +1,280 @@
+/**
+ * @file affinity.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sched.h>
+#include "affinity.h"
+
+/**
+ * @brief Reads a single integer from a sysfs file of a CPU
+ *
+ * @return The value, or -1 if the file does not exist or holds no number
+ */
+static int read_cpu_value(int cpu, const char *file)
+{
+    char path[128];
+    int value = -1;
+
+    snprintf(path, sizeof(path), AFFINITY_SYSFS_CPU "/cpu%d/%s", cpu, file);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    if (fscanf(fp, "%d", &value) != 1)
+        value = -1;
+    fclose(fp);
+
+    return value;
+}
+
+/**
+ * @brief Finds the NUMA node of a CPU (the "nodeN" link in its sysfs directory)
+ *
+ * @param[in] cpu The CPU
+ * @return The node, or 0 on machines without NUMA information
+ */
+int affinity_node_of(int cpu)
+{
+    char path[128];
+    struct dirent *entry;
+    int node = 0;
+
+    snprintf(path, sizeof(path), AFFINITY_SYSFS_CPU "/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return 0;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit((unsigned char)entry->d_name[4]))
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+
+    return node;
+}
+
+/**
+ * @brief Adds a CPU to a placement unless it is already in it
+ *
+ * @return 0 on success, -1 if the placement is full
+ */
+static int add_cpu(Cpu_placement *placement, int cpu)
+{
+    for (int i = 0; i < placement->num_cpus; i++)
+    {
+        if (placement->cpus[i] == cpu)
+            return 0;
+    }
+    if (placement->num_cpus == AFFINITY_MAX_CPUS)
+        return -1;
+
+    placement->cpus[placement->num_cpus] = cpu;
+    placement->nodes[placement->num_cpus] = affinity_node_of(cpu);
+    placement->num_cpus++;
+    return 0;
+}
+
+/**
+ * @brief Places threads on the first hardware thread of every physical core, grouped by NUMA node
+ */
+static int parse_cores(Cpu_placement *placement, cpu_set_t *allowed)
+{
+    int packages[AFFINITY_MAX_CPUS], cores[AFFINITY_MAX_CPUS];
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && placement->num_cpus < AFFINITY_MAX_CPUS; cpu++)
+    {
+        if (!CPU_ISSET(cpu, allowed))
+            continue;
+
+        int package = read_cpu_value(cpu, "topology/physical_package_id");
+        int core = read_cpu_value(cpu, "topology/core_id");
+        int sibling = 0;
+        for (int i = 0; i < placement->num_cpus && core != -1; i++)
+            sibling |= packages[i] == package && cores[i] == core;
+        if (sibling)
+            continue;
+
+        packages[placement->num_cpus] = package;
+        cores[placement->num_cpus] = core;
+        add_cpu(placement, cpu);
+    }
+
+    /* stable insertion sort by node, so that consecutive CPUs (and therefore a shard's slice) share a node */
+    for (int i = 1; i < placement->num_cpus; i++)
+    {
+        int cpu = placement->cpus[i], node = placement->nodes[i], j = i;
+        for (; j > 0 && placement->nodes[j - 1] > node; j--)
+        {
+            placement->cpus[j] = placement->cpus[j - 1];
+            placement->nodes[j] = placement->nodes[j - 1];
+        }
+        placement->cpus[j] = cpu;
+        placement->nodes[j] = node;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Parses a CPU list such as "0-3,8,10-11"
+ */
+static int parse_list(Cpu_placement *placement, const char *spec, cpu_set_t *allowed)
+{
+    const char *p = spec;
+
+    while (*p != '\0')
+    {
+        char *end;
+        long first = strtol(p, &end, 10), last;
+        if (end == p || first < 0)
+            return -1;
+
+        last = first;
+        p = end;
+        if (*p == '-')
+        {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first)
+                return -1;
+            p = end;
+        }
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return -1;
+
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, allowed))
+            {
+                fprintf(stderr, "CPU %ld is not available to this process\n", cpu);
+                return -1;
+            }
+            if (add_cpu(placement, cpu) == -1)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Builds the placement of the server's threads from the -b option
+ *
+ * @param[in] spec "none", "cores" or a CPU list
+ * @param[out] placement The CPUs to pin threads to (none if spec is "none")
+ * @return 0 on success, -1 if spec is invalid or names a CPU the process may not use
+ */
+int affinity_parse(const char *spec, Cpu_placement *placement)
+{
+    cpu_set_t allowed;
+
+    placement->num_cpus = 0;
+    if (spec == NULL || strcmp(spec, "none") == 0)
+        return 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+    {
+        perror("sched_getaffinity");
+        return -1;
+    }
+
+    int ret = strcmp(spec, "cores") == 0 ? parse_cores(placement, &allowed) : parse_list(placement, spec, &allowed);
+    if (ret == -1 || placement->num_cpus == 0)
+    {
+        placement->num_cpus = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Returns the CPUs of one part when the placement is split into parts (e.g. one per shard)
+ *
+ * Details: Every part gets a contiguous, non-overlapping slice. If there are fewer CPUs than parts, the parts
+ *          take turns on the CPUs, one CPU each.
+ *
+ * @param[in] placement The placement
+ * @param[in] index The part (0 .. parts - 1)
+ * @param[in] parts The number of parts
+ * @param[out] num_cpus The number of CPUs in the slice (0 if the placement is empty)
+ * @return The first CPU of the slice
+ */
+const int *affinity_slice(const Cpu_placement *placement, int index, int parts, int *num_cpus)
+{
+    int n = placement->num_cpus;
+
+    if (n == 0)
+    {
+        *num_cpus = 0;
+        return placement->cpus;
+    }
+    if (n < parts)
+    {
+        *num_cpus = 1;
+        return &placement->cpus[index % n];
+    }
+
+    int first = index * n / parts;
+    *num_cpus = (index + 1) * n / parts - first;
+    return &placement->cpus[first];
+}
+
+/**
+ * @brief Makes threads created with attr start on a given CPU
+ *
+ * @param[in] attr The attributes passed to pthread_create()
+ * @param[in] cpu The CPU, or -1 to leave the thread unpinned
+ * @return 0 on success, an error number otherwise
+ */
+int affinity_set_attr(pthread_attr_t *attr, int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0)
+        return 0;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+}
+
+/**
+ * @brief Formats a list of CPUs compactly, e.g. "0-3,8"
+ *
+ * @param[out] buf The buffer the list is written to
+ * @param[in] size The size of buf
+ * @param[in] cpus The CPUs
+ * @param[in] num_cpus The number of CPUs
+ */
+void affinity_format(char *buf, size_t size, const int *cpus, int num_cpus)
+{
+    size_t len = 0;
+
+    buf[0] = '\0';
+    for (int i = 0; i < num_cpus && len < size; i++)
+    {
+        int j = i;
+        while (j + 1 < num_cpus && cpus[j + 1] == cpus[j] + 1)
+            j++;
+
+        if (j > i)
+            len += snprintf(buf + len, size - len, "%s%d-%d", i > 0 ? "," : "", cpus[i], cpus[j]);
+        else
+            len += snprintf(buf + len, size - len, "%s%d", i > 0 ? "," : "", cpus[i]);
+        i = j;
+    }
+}
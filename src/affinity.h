@@ -0,0 +1,51 @@
+/**
+ * @file affinity.h
+ * @brief Pinning the server's threads to CPUs and keeping their memory on the local NUMA node
+ * @authors
+ *
+ * Details:
+ * - A Cpu_placement is the ordered list of CPUs the server's threads are pinned to, together with the NUMA node of
+ *   every CPU. It is built from the -b option: "none" (the default; threads are not pinned), "cores" (the first
+ *   hardware thread of every physical core, grouped by NUMA node) or an explicit CPU list such as "0-3,8,10-11"
+ *   (used in the given order).
+ * - Every shard gets a contiguous slice of the list (affinity_slice()). The shard's reactor thread runs on the first
+ *   CPU of its slice and its workers are spread over the whole slice, so with "cores" a shard's threads stay on one
+ *   node whenever the shards divide the nodes evenly.
+ * - Threads are created already pinned (affinity_set_attr()), so their stacks and everything they allocate are
+ *   first touched on their own node. The kernel's first-touch policy then keeps that memory local: the connection
+ *   blocks and arenas allocated by a reactor, and the deques and object caches of its workers.
+ * - Topology comes from /sys/devices/system/cpu; no NUMA library is needed.
+ *
+ * Assumptions/Limitations:
+ * - Only CPUs the process is allowed to run on (sched_getaffinity()) can be used; at most AFFINITY_MAX_CPUS of them.
+ * - Memory is not migrated or bound explicitly. Memory shared by every shard (the file cache, the MIME table) lives
+ *   wherever it was first touched.
+ *
+ * @date 2026-10-17
+ */
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define AFFINITY_MAX_CPUS 256
+#define AFFINITY_SYSFS_CPU "/sys/devices/system/cpu"
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct {
+    int num_cpus;                       /* 0 if threads are not pinned */
+    int cpus[AFFINITY_MAX_CPUS];        /* CPUs in the order threads are placed on them */
+    int nodes[AFFINITY_MAX_CPUS];       /* NUMA node of every CPU in cpus */
+} Cpu_placement;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern int affinity_parse(const char *spec, Cpu_placement *placement);
+extern const int *affinity_slice(const Cpu_placement *placement, int index, int parts, int *num_cpus);
+extern int affinity_node_of(int cpu);
+extern int affinity_set_attr(pthread_attr_t *attr, int cpu);
+extern void affinity_format(char *buf, size_t size, const int *cpus, int num_cpus);
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file arena.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "arena.h"
+
+/**
+ * @brief Initializes an arena over a block of memory
+ *
+ * @param[out] arena The arena
+ * @param[in] base The first block; must be aligned to ARENA_ALIGN
+ * @param[in] size The size of the first block
+ */
+void arena_init(Arena *arena, void *base, size_t size)
+{
+    arena->base = base;
+    arena->size = size;
+    arena->used = 0;
+    arena->blocks = NULL;
+    arena->block_used = 0;
+}
+
+/**
+ * @brief Allocates memory from an arena
+ *
+ * Details: The memory is aligned to ARENA_ALIGN and stays valid until the arena is reset.
+ *
+ * @param[in, out] arena The arena
+ * @param[in] size The number of bytes to allocate
+ * @return The memory, or NULL if an overflow block could not be allocated
+ */
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (size <= arena->size - arena->used)
+    {
+        void *ptr = arena->base + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+
+    if (arena->blocks != NULL && size <= arena->blocks->size - arena->block_used)
+    {
+        void *ptr = arena->blocks->data + arena->block_used;
+        arena->block_used += size;
+        return ptr;
+    }
+
+    // start a new overflow block; it is at least as large as the first block so small allocations can share it
+    size_t block_size = size > arena->size ? size : arena->size;
+    Arena_block *block = malloc(sizeof(Arena_block) + block_size);
+    if (block == NULL)
+        return NULL;
+
+    block->size = block_size;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->block_used = size;
+
+    return block->data;
+}
+
+/**
+ * @brief Grows the most recent allocation of an arena, or moves it to a larger one
+ *
+ * @param[in, out] arena The arena
+ * @param[in] ptr The allocation to grow
+ * @param[in] old_size The size it was allocated with
+ * @param[in] new_size The new size
+ * @return The (possibly moved) allocation with its first old_size bytes preserved, or NULL if no memory is left
+ */
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    size_t old_aligned = (old_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    size_t new_aligned = (new_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    // the last allocation of a block can be extended in place
+    if ((char *)ptr + old_aligned == arena->base + arena->used && new_aligned - old_aligned <= arena->size - arena->used)
+    {
+        arena->used += new_aligned - old_aligned;
+        return ptr;
+    }
+
+    if (arena->blocks != NULL && (char *)ptr + old_aligned == arena->blocks->data + arena->block_used &&
+        new_aligned - old_aligned <= arena->blocks->size - arena->block_used)
+    {
+        arena->block_used += new_aligned - old_aligned;
+        return ptr;
+    }
+
+    void *new_ptr = arena_alloc(arena, new_size);
+    if (new_ptr != NULL)
+        memcpy(new_ptr, ptr, old_size);
+
+    return new_ptr;
+}
+
+/**
+ * @brief Releases everything allocated from an arena
+ *
+ * Details: Overflow blocks are freed; the first block is kept for the next request.
+ *
+ * @param[in, out] arena The arena
+ */
+void arena_reset(Arena *arena)
+{
+    while (arena->blocks != NULL)
+    {
+        Arena_block *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+
+    arena->used = 0;
+    arena->block_used = 0;
+}
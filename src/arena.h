@@ -0,0 +1,56 @@
+/**
+ * @file arena.h
+ * @brief A bump allocator for memory that lives as long as one request
+ * @authors
+ *
+ * Details:
+ * - Every connection owns an arena. Its first block is taken from a pool when a request starts and given back
+ *   when the request has been answered (see get_input() and release_input()), so allocating from it is a pointer
+ *   bump and never calls malloc(), and an idle connection holds no block.
+ * - Everything a request needs (the input buffer, the copy of its body, the directory listing page) is taken from
+ *   the arena and released all at once with arena_reset() when the request has been answered. Individual
+ *   allocations are never freed.
+ * - An allocation that does not fit in the first block is taken from an overflow block obtained with malloc().
+ *   Overflow blocks are freed by arena_reset(), so a single large request does not make an idle connection keep
+ *   its memory.
+ *
+ * Assumptions/Limitations:
+ * - An arena is not thread-safe; a connection is only handled by one thread at a time.
+ * - Memory taken from an arena must not be used after the arena has been reset.
+ *
+ * @date 2026-10-17
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE 16384      /* size of the first block of a connection's arena */
+#define ARENA_ALIGN 16
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Arena_block {
+    struct Arena_block *next;
+    size_t size;
+    _Alignas(ARENA_ALIGN) char data[];
+} Arena_block;
+
+typedef struct {
+    char *base;                     /* first block (owned by whoever embeds the arena), or NULL */
+    size_t size;
+    size_t used;
+    Arena_block *blocks;            /* overflow blocks, most recent first */
+    size_t block_used;              /* bytes used in the most recent overflow block */
+} Arena;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void arena_init(Arena *arena, void *base, size_t size);
+extern void *arena_alloc(Arena *arena, size_t size);
+extern void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+extern void arena_reset(Arena *arena);
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @file cmap_bench.c
+ * @authors
+ *
+ * Details: Measures a read-mostly table shared by worker threads, the way the fd cache is used: 1 to 16 threads
+ *          look up random keys out of 10K paths, and one operation in WRITE_EVERY replaces a key (delete, then put
+ *          again). The same workload runs on a HashTable behind a mutex, a HashTable behind a read-write lock and
+ *          a CMap (see cmap.h), whose lookups take no lock; the result is million operations per second over all
+ *          threads. Every lookup is checked: it must find the key's own data or, while the key is being replaced,
+ *          nothing.
+ *          An optional argument changes the operations per thread, e.g. "cmap_bench 100000".
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "hashtable.h"
+#include "cmap.h"
+
+#define NUM_KEYS 10000
+#define KEY_SIZE 32
+#define OPS_PER_THREAD 1000000
+#define WRITE_EVERY 100
+#define MAX_THREADS 16
+
+typedef enum { TABLE_MUTEX, TABLE_RWLOCK, TABLE_CMAP } table_kind;
+
+static const char *kind_names[] = {"mutex", "rwlock", "cmap"};
+static char keys[NUM_KEYS][KEY_SIZE];
+static int ops_per_thread = OPS_PER_THREAD;
+
+static table_kind kind;
+static HashTable *ht;
+static CMap *map;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static int errors;
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *lookup(char *key)
+{
+    void *data;
+
+    switch (kind)
+    {
+    case TABLE_MUTEX:
+        pthread_mutex_lock(&mutex);
+        data = Hashtable_get(ht, key);
+        pthread_mutex_unlock(&mutex);
+        return data;
+    case TABLE_RWLOCK:
+        pthread_rwlock_rdlock(&rwlock);
+        data = Hashtable_get(ht, key);
+        pthread_rwlock_unlock(&rwlock);
+        return data;
+    default:
+        return Cmap_get(map, key);
+    }
+}
+
+static void replace(char *key)
+{
+    switch (kind)
+    {
+    case TABLE_MUTEX:
+        pthread_mutex_lock(&mutex);
+        Hashtable_delete(ht, key);
+        Hashtable_put(ht, key, key);
+        pthread_mutex_unlock(&mutex);
+        break;
+    case TABLE_RWLOCK:
+        pthread_rwlock_wrlock(&rwlock);
+        Hashtable_delete(ht, key);
+        Hashtable_put(ht, key, key);
+        pthread_rwlock_unlock(&rwlock);
+        break;
+    default:
+        Cmap_delete(map, key);
+        Cmap_put(map, key, key);
+        break;
+    }
+}
+
+static void *worker(void *arg)
+{
+    unsigned int seed = (unsigned int)(long)arg * 7919 + 1;
+    int bad = 0;
+
+    for (int i = 0; i < ops_per_thread; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        char *key = keys[(seed >> 8) % NUM_KEYS];
+
+        if (i % WRITE_EVERY == 0)
+        {
+            replace(key);
+        }
+        else
+        {
+            void *data = lookup(key);
+            bad += data != NULL && data != key;
+        }
+    }
+
+    __atomic_add_fetch(&errors, bad, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/**
+ * @brief Runs the workload on one kind of table with n threads
+ *
+ * @return Million operations per second, or -1 if a thread could not be created
+ */
+static double run(table_kind k, int n)
+{
+    pthread_t threads[MAX_THREADS];
+
+    kind = k;
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        if (kind == TABLE_CMAP)
+            Cmap_put(map, keys[i], keys[i]);
+        else if (Hashtable_get(ht, keys[i]) == NULL)
+            Hashtable_put(ht, keys[i], keys[i]);
+    }
+
+    double t = now_seconds();
+    for (int i = 0; i < n; i++)
+    {
+        if (pthread_create(&threads[i], NULL, worker, (void *)(long)i) != 0)
+            return -1;
+    }
+    for (int i = 0; i < n; i++)
+        pthread_join(threads[i], NULL);
+
+    return (double)n * ops_per_thread / (now_seconds() - t) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && atoi(argv[1]) > 0)
+        ops_per_thread = atoi(argv[1]);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+        snprintf(keys[i], KEY_SIZE, "/var/www/static/%08x.css", (unsigned int)i * 2654435761u);
+
+    ht = Hashtable_create(NUM_KEYS, NULL);
+    map = Cmap_create(NUM_KEYS);
+    if (ht == NULL || map == NULL)
+    {
+        fprintf(stderr, "could not create the tables\n");
+        return 1;
+    }
+
+    printf("%8s %12s %12s %12s   (million ops/s, %d%% writes)\n", "threads", kind_names[0], kind_names[1],
+           kind_names[2], 100 / WRITE_EVERY);
+    for (int n = 1; n <= MAX_THREADS; n *= 2)
+    {
+        double result[3];
+        for (int k = TABLE_MUTEX; k <= TABLE_CMAP; k++)
+        {
+            result[k] = run(k, n);
+            if (result[k] < 0)
+            {
+                perror("pthread_create");
+                return 1;
+            }
+        }
+        printf("%8d %12.2f %12.2f %12.2f\n", n, result[0], result[1], result[2]);
+    }
+
+    if (errors != 0)
+    {
+        fprintf(stderr, "%d lookups returned the wrong data\n", errors);
+        return 1;
+    }
+
+    Hashtable_destroy(ht);
+    Cmap_destroy(map);
+    epoch_drain();
+    return 0;
+}
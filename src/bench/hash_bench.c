@@ -0,0 +1,152 @@
+/**
+ * @file hash_bench.c
+ * @authors
+ *
+ * Details: Compares the chained HashTable with the open-addressing SwissTable (see swisstable.h) at 1K to 10M
+ *          entries. The keys look like the paths of static files ("/static/0001a2b3.css"). For every size both
+ *          tables insert all keys, look every key up again (hits), look up as many keys that are not in the table
+ *          (misses) and delete every key, each in a random order; the result is nanoseconds per operation.
+ *          Both tables start at their default size and grow as the keys are inserted: the HashTable migrates a
+ *          few buckets per operation, the SwissTable rebuilds itself at once. The slowest single insert shows
+ *          the difference (every insert is timed on its own, which adds the same overhead to both tables).
+ *          Every lookup and delete is checked.
+ *          An optional argument lowers the largest size, e.g. "hash_bench 1000000".
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashtable.h"
+#include "swisstable.h"
+
+#define MAX_ENTRIES 10000000
+#define KEY_SIZE 24
+
+typedef struct {
+    double insert, hit, miss, delete;   /* nanoseconds per operation */
+    double max_insert;                  /* slowest single insert in microseconds */
+} Result;
+
+static char (*keys)[KEY_SIZE];          /* MAX_ENTRIES keys that are inserted, then as many that are not */
+static int *order;
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void shuffle(int *a, int n)
+{
+    unsigned int seed = 12345;
+
+    for (int i = n - 1; i > 0; i--)
+    {
+        seed = seed * 1103515245 + 12345;
+        int j = (seed >> 8) % (i + 1);
+        int t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+/* the same workload for both tables; the data of key i is &keys[i] */
+#define RUN_TABLE(res, n, put, get, del, table, ok)                                   \
+    do {                                                                              \
+        double t = now_seconds(), op = t;                                             \
+        (res).max_insert = 0;                                                         \
+        for (int i = 0; i < (n); i++)                                                 \
+        {                                                                             \
+            put(table, keys[order[i]], keys[order[i]]);                               \
+            double end = now_seconds();                                               \
+            if (end - op > (res).max_insert)                                          \
+                (res).max_insert = end - op;                                          \
+            op = end;                                                                 \
+        }                                                                             \
+        (res).insert = (now_seconds() - t) * 1e9 / (n);                              \
+        (res).max_insert *= 1e6;                                                      \
+        shuffle(order, (n));                                                          \
+        t = now_seconds();                                                            \
+        for (int i = 0; i < (n); i++)                                                 \
+            (ok) &= get(table, keys[order[i]]) == keys[order[i]];                     \
+        (res).hit = (now_seconds() - t) * 1e9 / (n);                                  \
+        t = now_seconds();                                                            \
+        for (int i = 0; i < (n); i++)                                                 \
+            (ok) &= get(table, keys[MAX_ENTRIES + order[i]]) == NULL;                 \
+        (res).miss = (now_seconds() - t) * 1e9 / (n);                                 \
+        shuffle(order, (n));                                                          \
+        t = now_seconds();                                                            \
+        for (int i = 0; i < (n); i++)                                                 \
+            (ok) &= del(table, keys[order[i]]) == keys[order[i]];                     \
+        (res).delete = (now_seconds() - t) * 1e9 / (n);                               \
+    } while (0)
+
+/**
+ * @brief Runs the workload with n keys through both tables
+ *
+ * @return 0 on success, -1 if a table could not be created or returned a wrong result
+ */
+static int run(int n, Result *chained, Result *swiss)
+{
+    int ok = 1;
+
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    shuffle(order, n);
+
+    HashTable *ht = Hashtable_create(0, NULL);
+    if (ht == NULL)
+        return -1;
+    RUN_TABLE(*chained, n, Hashtable_put, Hashtable_get, Hashtable_delete, ht, ok);
+    Hashtable_destroy(ht);
+
+    SwissTable *st = Swisstable_create(0);
+    if (st == NULL)
+        return -1;
+    RUN_TABLE(*swiss, n, Swisstable_put, Swisstable_get, Swisstable_delete, st, ok);
+    ok &= st->num_entries == 0;
+    Swisstable_destroy(st);
+
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_entries = argc > 1 ? atoi(argv[1]) : MAX_ENTRIES;
+
+    if (max_entries < 1000 || max_entries > MAX_ENTRIES)
+        max_entries = MAX_ENTRIES;
+
+    keys = malloc((size_t)2 * MAX_ENTRIES * KEY_SIZE);
+    order = malloc((size_t)MAX_ENTRIES * sizeof(int));
+    if (keys == NULL || order == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+    for (int i = 0; i < 2 * MAX_ENTRIES; i++)
+        snprintf(keys[i], KEY_SIZE, "/static/%08x.css", (unsigned int)i * 2654435761u);
+
+    printf("%10s %-9s %10s %10s %10s %10s %14s\n", "entries", "table", "insert ns", "hit ns", "miss ns", "delete ns",
+           "max insert us");
+    for (int n = 1000; n <= max_entries; n *= 10)
+    {
+        Result chained, swiss;
+        if (run(n, &chained, &swiss) == -1)
+        {
+            fprintf(stderr, "wrong result with %d entries\n", n);
+            return 1;
+        }
+        printf("%10d %-9s %10.1f %10.1f %10.1f %10.1f %14.1f\n", n, "chained", chained.insert, chained.hit,
+               chained.miss, chained.delete, chained.max_insert);
+        printf("%10s %-9s %10.1f %10.1f %10.1f %10.1f %14.1f\n", "", "swiss", swiss.insert, swiss.hit, swiss.miss,
+               swiss.delete, swiss.max_insert);
+    }
+
+    free(order);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file hashfn_bench.c
+ * @authors
+ *
+ * Details: Measures the hash functions of the hash tables by key length (4 bytes to 4KB): str_hashf(), the old
+ *          default of HashTable, 64-bit FNV-1a, the old hash of SwissTable, and hash_bytes() (see hash.h), the
+ *          new default of both. The keys are random bytes read at a changing offset, so no hash can be computed
+ *          ahead of time; the result is nanoseconds per hash and bytes hashed per second.
+ *          A second table counts how evenly 64K keys that look like paths of static files fall into 64K buckets
+ *          (an ideal hash leaves about 37% of the buckets empty with a largest bucket of 7 or 8).
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashtable.h"
+
+#define MAX_KEY_SIZE 4096
+#define KEY_OFFSETS 64
+#define BYTES_PER_RUN (64 * 1024 * 1024)    /* bytes hashed per function and key length */
+#define DIST_KEYS (64 * 1024)
+#define DIST_BUCKETS (64 * 1024)
+
+static const int key_sizes[] = {4, 8, 16, 24, 32, 64, 128, 256, 1024, 4096};
+static unsigned char buffer[MAX_KEY_SIZE + KEY_OFFSETS];
+static volatile uint64_t sink;
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t fnv1a(const void *key, int key_size)
+{
+    const unsigned char *c = key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < key_size; i++)
+    {
+        hash ^= c[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* the same loop for every hash function; the previous hash picks the next key's offset */
+#define TIME_HASH(ns, n, expr)                                                        \
+    do {                                                                              \
+        uint64_t h = 0;                                                               \
+        double t = now_seconds();                                                     \
+        for (long i = 0; i < (n); i++)                                                \
+        {                                                                             \
+            const unsigned char *key = buffer + ((h + i) & (KEY_OFFSETS - 1));        \
+            h = (expr);                                                               \
+        }                                                                             \
+        (ns) = (now_seconds() - t) * 1e9 / (n);                                       \
+        sink = h;                                                                     \
+    } while (0)
+
+/**
+ * @brief Counts the empty buckets and the size of the largest bucket when DIST_KEYS path keys are hashed
+ */
+static void distribution(int (*hashf)(void *, int, int), int *empty, int *largest)
+{
+    static int counts[DIST_BUCKETS];
+    char key[32];
+
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < DIST_KEYS; i++)
+    {
+        int len = snprintf(key, sizeof(key), "/static/img/%05d.png", i);
+        counts[hashf(key, len, DIST_BUCKETS)]++;
+    }
+
+    *empty = *largest = 0;
+    for (int i = 0; i < DIST_BUCKETS; i++)
+    {
+        *empty += counts[i] == 0;
+        if (counts[i] > *largest)
+            *largest = counts[i];
+    }
+}
+
+int main()
+{
+    srand(12345);
+    for (size_t i = 0; i < sizeof(buffer); i++)
+        buffer[i] = rand();
+
+    printf("%8s %14s %14s %14s %14s %12s %12s\n", "key size", "str_hashf ns", "fnv1a ns", "hash_bytes ns",
+           "str_hashf", "fnv1a", "hash_bytes");
+    for (size_t k = 0; k < sizeof(key_sizes) / sizeof(key_sizes[0]); k++)
+    {
+        int size = key_sizes[k];
+        long n = BYTES_PER_RUN / size;
+        double str_ns, fnv_ns, wy_ns;
+
+        TIME_HASH(str_ns, n, (uint64_t)str_hashf((void *)key, size, 1 << 20));
+        TIME_HASH(fnv_ns, n, fnv1a(key, size));
+        TIME_HASH(wy_ns, n, hash_bytes(key, size));
+        printf("%8d %14.1f %14.1f %14.1f %9.2f GB/s %7.2f GB/s %7.2f GB/s\n", size, str_ns, fnv_ns, wy_ns,
+               size / str_ns, size / fnv_ns, size / wy_ns);
+    }
+
+    printf("\n%d path keys in %d buckets:\n", DIST_KEYS, DIST_BUCKETS);
+    printf("%-14s %14s %14s\n", "hash", "empty buckets", "largest bucket");
+    int empty, largest;
+    distribution(str_hashf, &empty, &largest);
+    printf("%-14s %14d %14d\n", "str_hashf", empty, largest);
+    distribution(seeded_hashf, &empty, &largest);
+    printf("%-14s %14d %14d\n", "seeded_hashf", empty, largest);
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file header_bench.c
+ * @authors
+ *
+ * Details: Measures the cost of serializing a response header. The legacy path formats the status line and the
+ *          string fields of the old response header with snprintf(), as the server used to; the current path
+ *          copies a pre-rendered block and appends the cached Date header, Content-Length and Content-Type
+ *          (render_response_header()).
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "server.h"
+
+#define ITERATIONS 2000000
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+__attribute__((noipa)) static size_t legacy_render(char *buf, size_t size, long content_length)
+{
+    return snprintf(buf, size,
+                    "HTTP/1.1 %s %s\r\n"
+                    "Content-Length: %ld\r\n"
+                    "Content-Type: %s\r\n"
+                    "Connection: %s\r\n"
+                    "%s\r\n",
+                    "200", "OK", content_length, "text/html", "keep-alive",
+                    "Keep-Alive: timeout=10, max=999\r\nServer: tinyserver\r\n");
+}
+
+int main()
+{
+    char buf[MAXLINE];
+    Header_buf out;
+    Http_response_header res_header = {HTTP_STATUS_OK, 1, 999, "text/html"};
+    volatile size_t sink = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        sink += legacy_render(buf, sizeof(buf), 1000 + i % 1000);
+    double legacy_time = (now_seconds() - start) / ITERATIONS;
+
+    start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        sink += render_response_header(&out, &res_header, 1000 + i % 1000);
+    double render_time = (now_seconds() - start) / ITERATIONS;
+
+    printf("snprintf():                 %8.1f ns/header\n", legacy_time * 1e9);
+    printf("render_response_header():   %8.1f ns/header (%.1fx)\n", render_time * 1e9, legacy_time / render_time);
+
+    return 0;
+}
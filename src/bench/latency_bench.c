@@ -0,0 +1,188 @@
+/**
+ * @file latency_bench.c
+ * @authors
+ *
+ * Details: Measures the response latency of a running server for small assets. For every path it opens one
+ *          keep-alive connection, sends GET requests one at a time (the next one after the previous response has
+ *          been read completely) and reports the 50th, 99th and 99.9th percentile and the maximum in microseconds.
+ *          One request and one response per round trip is the case where a response split over two segments costs
+ *          the most: with Nagle's algorithm the second one waits for the client's delayed ACK.
+ *          Usage: "latency_bench port [requests] [path...]", e.g. "latency_bench 8080 2000 /test.txt /nope".
+ *          Start the server with -c 0 to measure files sent with sendfile() instead of from the file cache.
+ *
+ * @date 2026-10-17
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define DEFAULT_REQUESTS 2000
+#define WARMUP_REQUESTS 50
+#define RESPONSE_SIZE 65536
+
+static const char *default_paths[] = {"/test.txt", "/style.css", "/nope", "/"};
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Opens a connection to the server on the loopback interface
+ *
+ * @return The socket, or -1 if the server could not be reached
+ */
+static int connect_server(int port)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd != -1 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Reads one response with a Content-Length header
+ *
+ * @return 0 on success, 1 if the server is going to close the connection after it, -1 if the connection failed
+ *         or the response is malformed
+ */
+static int read_response(int fd, char *buf)
+{
+    size_t len = 0;
+    char *end = NULL;
+
+    while (end == NULL)
+    {
+        ssize_t n = recv(fd, buf + len, RESPONSE_SIZE - 1 - len, 0);
+        if (n <= 0)
+            return -1;
+        len += n;
+        buf[len] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+        if (end == NULL && len == RESPONSE_SIZE - 1)
+            return -1;
+    }
+
+    char *field = strcasestr(buf, "\r\nContent-Length:");
+    if (field == NULL)
+        return -1;
+
+    size_t total = end + 4 - buf + strtoul(field + 17, NULL, 10);
+    char *connection = strcasestr(buf, "\r\nConnection: close");
+    int closing = connection != NULL && connection < end;
+    while (len < total)
+    {
+        ssize_t n = recv(fd, buf, RESPONSE_SIZE < total - len ? RESPONSE_SIZE : total - len, 0);
+        if (n <= 0)
+            return -1;
+        len += n;
+    }
+
+    return closing;
+}
+
+/**
+ * @brief Times requests for one path over one connection
+ *
+ * @return 0 on success, -1 if the server could not be reached
+ */
+static int measure(int port, const char *path, int requests)
+{
+    static char buf[RESPONSE_SIZE];
+    char request[512];
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+    double *samples = malloc(requests * sizeof(double));
+
+    int fd = connect_server(port);
+    if (samples == NULL || fd == -1)
+    {
+        perror("connect");
+        free(samples);
+        return -1;
+    }
+
+    for (int i = -WARMUP_REQUESTS; i < requests; i++)
+    {
+        double t = now_us();
+        int ret = send(fd, request, len, 0) == len ? read_response(fd, buf) : -1;
+        if (i >= 0)
+            samples[i] = now_us() - t;
+
+        if (ret == 1)
+        {
+            // the server closes connections after a number of requests (-l)
+            close(fd);
+            fd = connect_server(port);
+        }
+        if (ret == -1 || fd == -1)
+        {
+            fprintf(stderr, "%s: request %d failed\n", path, i);
+            if (fd != -1)
+                close(fd);
+            free(samples);
+            return -1;
+        }
+    }
+    close(fd);
+
+    qsort(samples, requests, sizeof(double), compare_doubles);
+    printf("%-24s %10.1f %10.1f %10.1f %10.1f\n", path, samples[requests / 2], samples[requests * 99 / 100],
+           samples[requests * 999 / 1000], samples[requests - 1]);
+
+    free(samples);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s port [requests] [path...]\n", argv[0]);
+        return 1;
+    }
+
+    int port = atoi(argv[1]);
+    int requests = argc > 2 && atoi(argv[2]) > 0 ? atoi(argv[2]) : DEFAULT_REQUESTS;
+
+    printf("%-24s %10s %10s %10s %10s   (us, %d requests)\n", "path", "p50", "p99", "p99.9", "max", requests);
+    if (argc > 3)
+    {
+        for (int i = 3; i < argc; i++)
+        {
+            if (measure(port, argv[i], requests) == -1)
+                return 1;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(default_paths) / sizeof(default_paths[0]); i++)
+        {
+            if (measure(port, default_paths[i], requests) == -1)
+                return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file parser_bench.c
+ * @authors
+ *
+ * Details: Compares the incremental request parser with the regex based parser it replaced. Both parse the
+ *          same browser-like GET request in a loop on one core; the result is requests parsed per second.
+ *          The incremental parser is also fed the request one byte at a time to check that resuming gives the
+ *          same result as parsing it in one go.
+ *          Finally the incremental parser is run with every header scanning implementation (see scan.h) on the
+ *          browser request and on a request with a large cookie, checking that all of them agree.
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <time.h>
+#include "parser.h"
+#include "scan.h"
+
+#define ITERATIONS 200000
+#define LEGACY_ITERATIONS 20000
+#define COOKIE_SIZE 4096
+
+static const char request[] =
+    "GET /apps/tinyChat/interface.html HTTP/1.1\r\n"
+    "Host: 10.65.255.109:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/119.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cookie: session=0123456789abcdef; theme=dark\r\n"
+    "\r\n";
+
+/* ----------< Legacy parser (regex based, as previously used by handle_http_request) >---------- */
+
+typedef struct {
+    int method;
+    char path[256];
+    char host[64];
+    char buffer[100000];
+} Legacy_request;
+
+static void legacy_parse_field(char *src, char *des, const char *field)
+{
+    char *start = strstr(src, field), *end;
+    if (start == NULL)
+        return;
+
+    start += strlen(field) + 2;
+    end = strchr(start, '\n');
+    if (end == NULL)
+        end = src + strlen(src);
+
+    strncpy(des, start, end - start);
+    des[end - start] = '\0';
+}
+
+static int legacy_parse(Legacy_request *req, const char *data, size_t len)
+{
+    regex_t regex;
+    regmatch_t pmatch[3];
+
+    memset(req, 0, sizeof(*req));
+    memcpy(req->buffer, data, len);
+
+    regcomp(&regex, "^GET", 0);
+    if (regexec(&regex, req->buffer, 2, pmatch, 0) == 0)
+        req->method = 0;
+    regfree(&regex);
+
+    regcomp(&regex, "^POST", 0);
+    if (regexec(&regex, req->buffer, 2, pmatch, 0) == 0)
+        req->method = 1;
+    regfree(&regex);
+
+    if (regcomp(&regex, "^(GET|POST) ([^ ]*) HTTP", REG_EXTENDED) != 0)
+        return -1;
+    if (regexec(&regex, req->buffer, 3, pmatch, 0) != 0)
+    {
+        regfree(&regex);
+        return -1;
+    }
+
+    size_t path_length = pmatch[2].rm_eo - pmatch[2].rm_so;
+    strncpy(req->path, req->buffer + pmatch[2].rm_so, path_length);
+    req->path[path_length] = '\0';
+    regfree(&regex);
+
+    legacy_parse_field(req->buffer, req->host, "Host");
+
+    return 0;
+}
+
+/* ----------< Benchmark >---------- */
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Builds a request with a COOKIE_SIZE byte cookie, as sent by sites with many tracking cookies
+ */
+static char *make_cookie_request(size_t *len)
+{
+    char *buf = malloc(COOKIE_SIZE + 1024);
+    size_t n = sprintf(buf, "GET /index.html HTTP/1.1\r\nHost: localhost:8080\r\nCookie: ");
+
+    for (int i = 0; n < COOKIE_SIZE; i++)
+        n += sprintf(buf + n, "c%d=%016x%016x; ", i, i * 2654435761u, i ^ 0x5bd1e995);
+
+    n += sprintf(buf + n, "last=1\r\nConnection: keep-alive\r\n\r\n");
+    *len = n;
+    return buf;
+}
+
+/**
+ * @brief Parses a request ITERATIONS times with the selected scanning implementation
+ *
+ * @return Requests parsed per second, or -1 if the result differs from the expected parse
+ */
+static double run_scan(const char *buf, size_t len, const Http_parser *expected)
+{
+    Http_parser parser;
+    volatile size_t sink = 0;
+
+    http_parser_init(&parser);
+    if (http_parser_execute(&parser, buf, len) != PARSE_DONE || parser.num_headers != expected->num_headers ||
+        memcmp(parser.headers, expected->headers, sizeof(Http_header_view) * parser.num_headers) != 0)
+        return -1;
+
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        http_parser_init(&parser);
+        http_parser_execute(&parser, buf, len);
+        sink += parser.header_len;
+    }
+    return ITERATIONS / (now_seconds() - start);
+}
+
+/**
+ * @brief Compares every scanning implementation the CPU supports on one request
+ */
+static int compare_scans(const char *label, const char *buf, size_t len)
+{
+    Http_parser expected;
+
+    scan_select(SCAN_SCALAR);
+    http_parser_init(&expected);
+    if (http_parser_execute(&expected, buf, len) != PARSE_DONE)
+    {
+        fprintf(stderr, "parser rejected the %s request\n", label);
+        return -1;
+    }
+
+    printf("%s request: %zu bytes\n", label, len);
+    double scalar = 0;
+    for (scan_level level = SCAN_SCALAR; level <= SCAN_AVX2; level++)
+    {
+        if (scan_select(level) != level)
+            continue;
+
+        double rate = run_scan(buf, len, &expected);
+        if (rate < 0)
+        {
+            fprintf(stderr, "%s scanning differs from scalar scanning\n", scan_level_name(level));
+            return -1;
+        }
+        if (level == SCAN_SCALAR)
+            scalar = rate;
+        printf("  %-8s %12.0f requests/s (%.1fx)\n", scan_level_name(level), rate, rate / scalar);
+    }
+
+    return 0;
+}
+
+int main()
+{
+    size_t len = strlen(request);
+    Http_parser parser;
+    volatile size_t sink = 0;
+
+    scan_init();
+
+    /* resuming byte by byte must give the same views as a single call */
+    Http_parser whole;
+    http_parser_init(&whole);
+    if (http_parser_execute(&whole, request, len) != PARSE_DONE)
+    {
+        fprintf(stderr, "parser rejected the request\n");
+        return 1;
+    }
+
+    http_parser_init(&parser);
+    parse_status status = PARSE_AGAIN;
+    for (size_t i = 1; i <= len && status == PARSE_AGAIN; i++)
+        status = http_parser_execute(&parser, request, i);
+
+    if (status != PARSE_DONE || parser.num_headers != whole.num_headers ||
+        memcmp(&parser.path, &whole.path, sizeof(Http_view)) != 0 ||
+        memcmp(&parser.host, &whole.host, sizeof(Http_view)) != 0)
+    {
+        fprintf(stderr, "incremental parse differs from a single parse\n");
+        return 1;
+    }
+
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        http_parser_init(&parser);
+        http_parser_execute(&parser, request, len);
+        sink += parser.path.len;
+    }
+    double incremental = ITERATIONS / (now_seconds() - start);
+
+    Legacy_request *legacy = malloc(sizeof(Legacy_request));
+    start = now_seconds();
+    for (int i = 0; i < LEGACY_ITERATIONS; i++)
+    {
+        legacy_parse(legacy, request, len);
+        sink += legacy->path[0];
+    }
+    double regex = LEGACY_ITERATIONS / (now_seconds() - start);
+    free(legacy);
+
+    printf("request: %zu bytes, %d headers\n", len, whole.num_headers);
+    printf("regex parser:       %12.0f requests/s\n", regex);
+    printf("incremental parser: %12.0f requests/s (%.1fx)\n", incremental, incremental / regex);
+
+    size_t cookie_len;
+    char *cookie_request = make_cookie_request(&cookie_len);
+    int failed = compare_scans("browser", request, len) == -1 || compare_scans("cookie", cookie_request, cookie_len) == -1;
+    free(cookie_request);
+
+    return failed;
+}
@@ -0,0 +1,374 @@
+/**
+ * @file queue_bench.c
+ * @authors
+ *
+ * Details: Compares the thread pool's task queues (see pool.h) with 1 to 64 workers.
+ *          - flat: one producer, like the reactor thread, submits TASKS trivial tasks. The linked list
+ *            serializes the producer and every worker on pool_lock; the ring and the work-stealing pool let them
+ *            proceed without a lock.
+ *          - spawned: ROOTS tasks each fill a BLOCK_SIZE block of memory and then submit FANOUT child tasks
+ *            from the worker that read back a slice of that block, like work spawned while handling a request.
+ *            With work stealing the children stay on the parent's deque (and cache) unless another worker is
+ *            idle.
+ *          Both measure tasks completed per second from the first submission to the last completion.
+ *          - mixed: a burst of MIXED_TASKS tasks of which every BULK_EVERY-th busy-waits for BULK_TASK_US, like
+ *            directory listings between cached GETs. The burst is run once with every task in the normal lane and
+ *            once with the slow tasks in the bulk lane and the others in the fast lane; the result is the
+ *            median and 99th percentile time a fast task waited before it started.
+ *          - burst: BURST_TASKS tasks that each sleep for BURST_TASK_MS are submitted at once to BURST_THREADS
+ *            parked workers, BURST_RUNS times, once by the main thread (the shared ring) and once by a task
+ *            running on a worker (its deque with work stealing). Every task needs its own worker, so the burst
+ *            must finish after one task's time; a run that takes more than BURST_SLACK_MS longer lost a wakeup
+ *            (a task waited behind a busy worker while another one stayed parked) and fails the benchmark.
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "pool.h"
+
+#define TASKS 200000
+#define MAX_THREADS 64
+#define ROOTS 8192
+#define FANOUT 16
+#define BLOCK_SIZE 4096
+#define MIXED_TASKS 4000
+#define MIXED_THREADS 4
+#define BULK_EVERY 10
+#define BULK_TASK_US 200
+#define BURST_THREADS 8
+#define BURST_TASKS 8
+#define BURST_TASK_MS 100
+#define BURST_RUNS 15
+#define BURST_SLACK_MS 50
+#define BURST_IDLE_MS 50            /* pause before every burst, long enough for the workers to park */
+
+static const task_queue_type queue_types[] = {TASK_QUEUE_LIST, TASK_QUEUE_RING, TASK_QUEUE_STEAL};
+#define NUM_QUEUE_TYPES (sizeof(queue_types) / sizeof(queue_types[0]))
+
+static long completed;
+static unsigned long checksum;      /* keeps the reads of the children from being optimized away */
+static ThreadPool *bench_pool;
+static unsigned char *blocks;
+static Task *tasks;
+
+static void *count_task(void *arg)
+{
+    (void)arg;
+    __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void *child_task(void *arg)
+{
+    unsigned char *slice = arg;
+    unsigned long sum = 0;
+
+    for (int i = 0; i < BLOCK_SIZE / FANOUT; i++)
+        sum += slice[i];
+    __atomic_add_fetch(&checksum, sum, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void *root_task(void *arg)
+{
+    long root = (long)arg;
+    unsigned char *block = blocks + root * BLOCK_SIZE;
+    Task *children = tasks + ROOTS + root * FANOUT;
+
+    memset(block, (int)(root | 1), BLOCK_SIZE);
+    for (int i = 0; i < FANOUT; i++)
+        thread_pool_submit(bench_pool, &children[i], child_task, block + i * (BLOCK_SIZE / FANOUT));
+    __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    Task task;
+    int bulk;
+    double queued;
+    double waited;                  /* seconds between submission and start */
+} Mixed_task;
+
+static void *mixed_task(void *arg)
+{
+    Mixed_task *mixed = arg;
+    double start = now_seconds();
+
+    mixed->waited = start - mixed->queued;
+    while (mixed->bulk && now_seconds() - start < BULK_TASK_US / 1e6)
+        ;
+    __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+static void *sleep_task(void *arg)
+{
+    (void)arg;
+    sleep_ms(BURST_TASK_MS);
+    __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void *burst_root_task(void *arg)
+{
+    Task *burst = arg;
+
+    for (int i = 0; i < BURST_TASKS; i++)
+        thread_pool_submit(bench_pool, &burst[i], sleep_task, NULL);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Runs one workload through a pool with the given queue
+ *
+ * @return Tasks per second, or -1 if the pool could not be created or did not run every task exactly once
+ */
+static double run(task_queue_type type, int num_threads, int spawned)
+{
+    long total = spawned ? ROOTS * (FANOUT + 1) : TASKS;
+
+    bench_pool = thread_pool_create_with_queue(num_threads, type);
+    if (bench_pool == NULL)
+        return -1;
+
+    __atomic_store_n(&completed, 0, __ATOMIC_RELAXED);
+    double start = now_seconds();
+    if (spawned)
+    {
+        for (long i = 0; i < ROOTS; i++)
+            thread_pool_submit(bench_pool, &tasks[i], root_task, (void *)i);
+    }
+    else
+    {
+        for (int i = 0; i < TASKS; i++)
+            thread_pool_submit(bench_pool, &tasks[i], count_task, NULL);
+    }
+    while (__atomic_load_n(&completed, __ATOMIC_RELAXED) < total)
+        sched_yield();
+    double elapsed = now_seconds() - start;
+
+    thread_pool_wait(bench_pool);
+    thread_pool_destroy(bench_pool);
+    if (__atomic_load_n(&completed, __ATOMIC_RELAXED) != total)
+    {
+        fprintf(stderr, "%ld tasks completed, expected %ld\n", completed, total);
+        return -1;
+    }
+    return total / elapsed;
+}
+
+/**
+ * @brief Runs the mixed burst through a pool, with or without sorting the slow tasks into the bulk lane
+ *
+ * @param[out] p50 Median wait of the fast tasks in microseconds
+ * @param[out] p99 99th percentile wait of the fast tasks in microseconds
+ * @return 0 on success, -1 if the pool could not be created or did not run every task
+ */
+static int run_mixed(task_queue_type type, int lanes, double *p50, double *p99)
+{
+    Mixed_task *mixed = calloc(MIXED_TASKS, sizeof(Mixed_task));
+    double *waits = malloc(MIXED_TASKS * sizeof(double));
+    int num_fast = 0;
+
+    bench_pool = thread_pool_create_with_queue(MIXED_THREADS, type);
+    if (bench_pool == NULL || mixed == NULL || waits == NULL)
+    {
+        thread_pool_destroy(bench_pool);
+        free(mixed);
+        free(waits);
+        return -1;
+    }
+
+    __atomic_store_n(&completed, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < MIXED_TASKS; i++)
+    {
+        task_lane lane = TASK_LANE_NORMAL;
+
+        mixed[i].bulk = i % BULK_EVERY == 0;
+        if (lanes)
+            lane = mixed[i].bulk ? TASK_LANE_BULK : TASK_LANE_FAST;
+        mixed[i].queued = now_seconds();
+        thread_pool_submit_lane(bench_pool, &mixed[i].task, lane, mixed_task, &mixed[i]);
+    }
+    while (__atomic_load_n(&completed, __ATOMIC_RELAXED) < MIXED_TASKS)
+        sched_yield();
+
+    thread_pool_wait(bench_pool);
+    thread_pool_destroy(bench_pool);
+
+    for (int i = 0; i < MIXED_TASKS; i++)
+    {
+        if (!mixed[i].bulk)
+            waits[num_fast++] = mixed[i].waited * 1e6;
+    }
+    qsort(waits, num_fast, sizeof(double), compare_double);
+    *p50 = waits[num_fast / 2];
+    *p99 = waits[num_fast * 99 / 100];
+
+    free(mixed);
+    free(waits);
+    return 0;
+}
+
+static int run_mixed_workload()
+{
+    static const char *names[] = {"list", "ring", "steal"};
+
+    printf("mixed: fast task wait with %d threads, 1 in %d tasks takes %d us\n", MIXED_THREADS, BULK_EVERY,
+           BULK_TASK_US);
+    printf("%8s %14s %14s %14s %14s\n", "queue", "one lane p50", "one lane p99", "lanes p50", "lanes p99");
+    for (size_t i = 0; i < NUM_QUEUE_TYPES; i++)
+    {
+        double p50, p99, lanes_p50, lanes_p99;
+        if (run_mixed(queue_types[i], 0, &p50, &p99) == -1 || run_mixed(queue_types[i], 1, &lanes_p50, &lanes_p99) == -1)
+        {
+            fprintf(stderr, "mixed burst failed\n");
+            return -1;
+        }
+        printf("%8s %11.0f us %11.0f us %11.0f us %11.0f us\n", names[i], p50, p99, lanes_p50, lanes_p99);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Runs the bursts through a pool of parked workers
+ *
+ * @param[in] spawned Whether the tasks are submitted by a task running on a worker rather than the main thread
+ * @param[out] worst The longest burst in milliseconds
+ * @return The number of bursts that took longer than BURST_TASK_MS + BURST_SLACK_MS, or -1 if the pool could
+ *         not be created
+ */
+static int run_burst(task_queue_type type, int spawned, double *worst)
+{
+    Task root, burst[BURST_TASKS];
+    int late = 0;
+
+    bench_pool = thread_pool_create_with_queue(BURST_THREADS, type);
+    if (bench_pool == NULL)
+        return -1;
+
+    *worst = 0;
+    for (int run = 0; run < BURST_RUNS; run++)
+    {
+        sleep_ms(BURST_IDLE_MS);
+        __atomic_store_n(&completed, 0, __ATOMIC_RELAXED);
+
+        double start = now_seconds();
+        if (spawned)
+            thread_pool_submit(bench_pool, &root, burst_root_task, burst);
+        else
+            for (int i = 0; i < BURST_TASKS; i++)
+                thread_pool_submit(bench_pool, &burst[i], sleep_task, NULL);
+        while (__atomic_load_n(&completed, __ATOMIC_RELAXED) < BURST_TASKS)
+            sleep_ms(1);
+        double elapsed = (now_seconds() - start) * 1e3;
+        thread_pool_wait(bench_pool);   /* the workers are done with the tasks before they are submitted again */
+
+        if (elapsed > *worst)
+            *worst = elapsed;
+        if (elapsed > BURST_TASK_MS + BURST_SLACK_MS)
+            late++;
+    }
+
+    thread_pool_destroy(bench_pool);
+    return late;
+}
+
+static int run_burst_workload()
+{
+    static const char *names[] = {"list", "ring", "steal"};
+    int failed = 0;
+
+    printf("burst: %d tasks of %d ms on %d parked workers, %d runs\n", BURST_TASKS, BURST_TASK_MS, BURST_THREADS,
+           BURST_RUNS);
+    printf("%8s %14s %10s %14s %10s\n", "queue", "submit worst", "late runs", "spawn worst", "late runs");
+    for (size_t i = 0; i < NUM_QUEUE_TYPES; i++)
+    {
+        double worst[2];
+        int late[2];
+
+        for (int spawned = 0; spawned < 2; spawned++)
+        {
+            late[spawned] = run_burst(queue_types[i], spawned, &worst[spawned]);
+            if (late[spawned] == -1)
+            {
+                fprintf(stderr, "burst failed\n");
+                return -1;
+            }
+            failed |= late[spawned] > 0;
+        }
+        printf("%8s %11.0f ms %10d %11.0f ms %10d\n", names[i], worst[0], late[0], worst[1], late[1]);
+    }
+
+    if (failed)
+        fprintf(stderr, "a burst took longer than %d ms: a parked worker was not woken\n",
+                BURST_TASK_MS + BURST_SLACK_MS);
+    return failed ? -1 : 0;
+}
+
+static int run_workload(const char *label, int spawned)
+{
+    printf("%s\n%8s %16s %16s %16s\n", label, "threads", "list tasks/s", "ring tasks/s", "steal tasks/s");
+    for (int num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2)
+    {
+        double rate[NUM_QUEUE_TYPES];
+        for (size_t i = 0; i < NUM_QUEUE_TYPES; i++)
+        {
+            rate[i] = run(queue_types[i], num_threads, spawned);
+            if (rate[i] < 0)
+            {
+                fprintf(stderr, "pool of %d threads failed\n", num_threads);
+                return -1;
+            }
+        }
+        printf("%8d %16.0f %16.0f %16.0f\n", num_threads, rate[0], rate[1], rate[2]);
+    }
+
+    return 0;
+}
+
+int main()
+{
+    size_t num_tasks = TASKS > ROOTS * (FANOUT + 1) ? TASKS : ROOTS * (FANOUT + 1);
+
+    tasks = malloc(num_tasks * sizeof(Task));
+    blocks = malloc((size_t)ROOTS * BLOCK_SIZE);
+    if (tasks == NULL || blocks == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    int failed = run_workload("flat: one producer", 0) == -1 ||
+                 run_workload("spawned: tasks submitted by workers", 1) == -1 || run_mixed_workload() == -1 ||
+                 run_burst_workload() == -1;
+
+    free(blocks);
+    free(tasks);
+    return failed;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file request_bench.c
+ * @authors
+ *
+ * Details: Measures the memory traffic of handing a request down the GET handler chain
+ *          (http_get_handler -> serve_request -> serve_file -> send_response).
+ *          The legacy chain passes the old Http_request_header (with its 100 KB header buffer and 1 MB body) and the
+ *          old string-based response header by value, as the server used to; the current chain passes the compact Http_request_header
+ *          and the response header by pointer. Both fill the request from the same parsed input, and the handlers
+ *          only read the path, so the difference is the cost of the copies.
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "server.h"
+
+#define ITERATIONS 2000
+#define CHAIN_DEPTH 3       /* by-value hops of the request: get handler, serve_request, serve_file */
+
+static const char request[] =
+    "GET /apps/tinyChat/interface.html HTTP/1.1\r\n"
+    "Host: 10.65.255.109:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "\r\n";
+
+/* ----------< Legacy chain (request and response passed by value) >---------- */
+
+typedef struct {
+    http_method method;
+    char path[MAX_PATH_SIZE];
+    char version[MAX_VERSION_SIZE];
+    char buffer[MAX_HEADER_SIZE];
+    char host[MAX_HOST_SIZE];
+    char connection[MAX_CONNECTION_SIZE];
+    char body[MAX_BODY_SIZE];
+} Legacy_request_header;
+
+typedef struct {
+    char status_code[MAX_STATUS_CODE_SIZE];
+    char content_type[MAX_CONTENT_TYPE_SIZE];
+    char connection[MAX_CONNECTION_SIZE];
+    char status_message[MAX_STATUS_MESSAGE_SIZE];
+    char additional_headers[MAX_ADDITIONAL_HEADERS_SIZE];
+} Legacy_response_header;
+
+static void copy_view(char *des, size_t size, const char *buf, Http_view view)
+{
+    size_t len = view.len < size - 1 ? view.len : size - 1;
+
+    memcpy(des, VIEW_PTR(buf, view), len);
+    des[len] = '\0';
+}
+
+__attribute__((noipa)) static size_t legacy_send_response(Legacy_response_header res_header)
+{
+    return strlen(res_header.status_code);
+}
+
+__attribute__((noipa)) static size_t legacy_serve_file(Legacy_request_header req_header, Legacy_response_header res_header)
+{
+    return strlen(req_header.path) + legacy_send_response(res_header);
+}
+
+__attribute__((noipa)) static size_t legacy_serve_request(Legacy_request_header req_header, Legacy_response_header res_header)
+{
+    return legacy_serve_file(req_header, res_header);
+}
+
+__attribute__((noipa)) static size_t legacy_get_handler(Legacy_request_header req_header, Legacy_response_header res_header)
+{
+    return legacy_serve_request(req_header, res_header);
+}
+
+static size_t legacy_handle(Http_input *in, Legacy_request_header *req_header, Legacy_response_header *res_header)
+{
+    Http_parser *parser = &in->parser;
+    Http_view body = {parser->header_len, parser->content_length > 0 ? parser->content_length : 0};
+
+    copy_view(req_header->path, sizeof(req_header->path), in->data, parser->path);
+    copy_view(req_header->version, sizeof(req_header->version), in->data, parser->version);
+    copy_view(req_header->host, sizeof(req_header->host), in->data, parser->host);
+    copy_view(req_header->connection, sizeof(req_header->connection), in->data, parser->connection);
+    copy_view(req_header->body, sizeof(req_header->body), in->data, body);
+
+    return legacy_get_handler(*req_header, *res_header);
+}
+
+/* ----------< Current chain (compact request passed by pointer) >---------- */
+
+__attribute__((noipa)) static size_t send_response_ptr(Http_response_header *res_header)
+{
+    return res_header->status;
+}
+
+__attribute__((noipa)) static size_t serve_file_ptr(Http_request_header *req_header, Http_response_header *res_header)
+{
+    return strlen(req_header->path) + send_response_ptr(res_header);
+}
+
+__attribute__((noipa)) static size_t serve_request_ptr(Http_request_header *req_header, Http_response_header *res_header)
+{
+    return serve_file_ptr(req_header, res_header);
+}
+
+__attribute__((noipa)) static size_t get_handler_ptr(Http_request_header *req_header, Http_response_header *res_header)
+{
+    return serve_request_ptr(req_header, res_header);
+}
+
+static size_t compact_handle(Http_input *in, Http_request_header *req_header, Http_response_header *res_header)
+{
+    Http_parser *parser = &in->parser;
+
+    copy_view(req_header->path, sizeof(req_header->path), in->data, parser->path);
+    copy_view(req_header->version, sizeof(req_header->version), in->data, parser->version);
+    copy_view(req_header->host, sizeof(req_header->host), in->data, parser->host);
+    copy_view(req_header->connection, sizeof(req_header->connection), in->data, parser->connection);
+    req_header->input = in;
+    req_header->body_len = parser->content_length > 0 ? parser->content_length : 0;
+    req_header->body = NULL;
+
+    return get_handler_ptr(req_header, res_header);
+}
+
+/* ----------< Benchmark >---------- */
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+    static char data[MAX_HEADER_SIZE];
+    Http_input *in = malloc(sizeof(Http_input));
+    Legacy_response_header legacy_res_header;
+    Http_response_header res_header = {HTTP_STATUS_OK, 1, -1, NULL};
+    volatile size_t sink = 0;
+
+    memset(&legacy_res_header, 0, sizeof(legacy_res_header));
+    strcpy(legacy_res_header.status_code, "200");
+
+    in->data = data;
+    in->size = sizeof(data);
+    in->len = strlen(request);
+    memcpy(in->data, request, in->len);
+    http_parser_init(&in->parser);
+    if (http_parser_execute(&in->parser, in->data, in->len) != PARSE_DONE)
+    {
+        fprintf(stderr, "parser rejected the request\n");
+        return 1;
+    }
+
+    Legacy_request_header *legacy = malloc(sizeof(Legacy_request_header));
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        sink += legacy_handle(in, legacy, &legacy_res_header);
+    double legacy_time = (now_seconds() - start) / ITERATIONS;
+    free(legacy);
+
+    Http_request_header compact;
+    start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        sink += compact_handle(in, &compact, &res_header);
+    double compact_time = (now_seconds() - start) / ITERATIONS;
+
+    size_t legacy_bytes = CHAIN_DEPTH * sizeof(Legacy_request_header) + (CHAIN_DEPTH + 1) * sizeof(Legacy_response_header);
+
+    printf("request header: %zu bytes (legacy), %zu bytes (compact)\n",
+           sizeof(Legacy_request_header), sizeof(Http_request_header));
+    printf("legacy  (by value):   %9zu bytes copied, %8.2f us/request\n", legacy_bytes, legacy_time * 1e6);
+    printf("compact (by pointer): %9d bytes copied, %8.2f us/request (%.0fx)\n", 0, compact_time * 1e6,
+           legacy_time / compact_time);
+
+    free(in);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file timer_bench.c
+ * @authors
+ *
+ * Details: Measures the connection deadlines of the reactor with 1K to 100K connections waiting at once. Every
+ *          connection has a timer in a Timer_wheel (see timerwheel.h); the benchmark reports the cost of moving a
+ *          pending timer (what a re-armed keep-alive connection does), of cancelling one, and of one 100 ms tick
+ *          once the deadlines start falling due. For comparison it also times one pass of the sweep the reactor
+ *          used before, which looked at every connection once a second. Every expired timer is checked against its
+ *          deadline.
+ *          An optional argument changes the number of rounds, e.g. "timer_bench 10".
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "timerwheel.h"
+
+#define TICK_MS 100
+#define TIMEOUT_MS 10000
+#define MAX_CONNS 100000
+#define ROUNDS 20
+
+typedef struct {
+    Timer timer;
+    long last_active;
+    int idle;
+} Conn;
+
+static Conn conns[MAX_CONNS];
+static int rounds = ROUNDS;
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    Timer_wheel wheel;
+    unsigned int seed = 1;
+    long expired_total = 0;
+
+    if (argc > 1 && atoi(argv[1]) > 0)
+        rounds = atoi(argv[1]);
+
+    printf("%8s %12s %12s %12s %12s   (ns)\n", "conns", "move", "cancel", "tick", "sweep");
+    for (int n = 1000; n <= MAX_CONNS; n *= 10)
+    {
+        double move = 0, cancel = 0, tick = 0, sweep = 0;
+
+        for (int r = 0; r < rounds; r++)
+        {
+            long now = 0;
+            timer_wheel_init(&wheel, now, TICK_MS);
+            for (int i = 0; i < n; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                conns[i].timer.pprev = NULL;
+                conns[i].idle = 1;
+                conns[i].last_active = now + (seed >> 8) % TIMEOUT_MS;
+                timer_add(&wheel, &conns[i].timer, conns[i].last_active + TIMEOUT_MS);
+            }
+
+            // every connection is re-armed a little later, as if it had answered a request
+            double t = now_ns();
+            for (int i = 0; i < n; i++)
+                timer_add(&wheel, &conns[i].timer, conns[i].last_active + TIMEOUT_MS + TICK_MS);
+            move += (now_ns() - t) / n;
+
+            // jump to when the first tenth of the deadlines is due, then time one tick
+            now = TIMEOUT_MS + TIMEOUT_MS / 10;
+            timer_wheel_advance(&wheel, now - TICK_MS);
+            t = now_ns();
+            Timer *expired = timer_wheel_advance(&wheel, now);
+            tick += now_ns() - t;
+
+            for (Timer *timer = expired; timer != NULL; timer = timer->next)
+            {
+                Conn *conn = timer_entry(timer, Conn, timer);
+                if (conn->last_active + TIMEOUT_MS + TICK_MS > now)
+                {
+                    fprintf(stderr, "a timer expired before its deadline\n");
+                    return 1;
+                }
+                expired_total++;
+            }
+
+            t = now_ns();
+            for (int i = 0; i < n; i++)
+            {
+                if (conns[i].idle && now - conns[i].last_active >= TIMEOUT_MS)
+                    expired_total++;
+            }
+            sweep += now_ns() - t;
+
+            t = now_ns();
+            for (int i = 0; i < n; i++)
+                timer_cancel(&wheel, &conns[i].timer);
+            cancel += (now_ns() - t) / n;
+
+            if (wheel.num_timers != 0)
+            {
+                fprintf(stderr, "%d timers left after cancelling all of them\n", wheel.num_timers);
+                return 1;
+            }
+        }
+
+        printf("%8d %12.1f %12.1f %12.0f %12.0f\n", n, move / rounds, cancel / rounds, tick / rounds,
+               sweep / rounds);
+    }
+
+    printf("(%ld timers expired)\n", expired_total);
+    return 0;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file cache.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "cache.h"
+
+File_cache *file_cache;
+
+/* ----------< LRU list >---------- */
+
+static void lru_unlink(File_cache *cache, Cache_entry *entry)
+{
+    if (entry->prev != NULL)
+        entry->prev->next = entry->next;
+    else
+        cache->head = entry->next;
+
+    if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+    else
+        cache->tail = entry->prev;
+
+    entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(File_cache *cache, Cache_entry *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+
+    if (cache->head != NULL)
+        cache->head->prev = entry;
+    else
+        cache->tail = entry;
+
+    cache->head = entry;
+}
+
+/* ----------< Entries >---------- */
+
+/**
+ * @brief Drops a reference to an entry and frees it when it was the last one
+ *
+ * @param[in] entry The entry
+ */
+static void entry_unref(Cache_entry *entry)
+{
+    if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        free(entry->data);
+        free(entry->path);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Removes an entry from the cache (the lock must be held)
+ *
+ * @param[in] cache The cache
+ * @param[in] entry The entry to remove
+ */
+static void cache_remove(File_cache *cache, Cache_entry *entry)
+{
+    Hashtable_delete(cache->index, entry->path);
+    lru_unlink(cache, entry);
+
+    cache->stats.bytes -= entry->size;
+    cache->stats.entries--;
+
+    entry_unref(entry); // the cache's reference
+}
+
+/**
+ * @brief Checks that an entry still describes a file
+ *
+ * @param[in] entry The entry
+ * @param[in] st The current status of the file
+ * @return non-zero if the cached contents are still those of the file
+ */
+static int entry_is_fresh(const Cache_entry *entry, const struct stat *st)
+{
+    return entry->dev == st->st_dev && entry->ino == st->st_ino && entry->size == (size_t)st->st_size &&
+           entry->mtime.tv_sec == st->st_mtim.tv_sec && entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* ----------< File_cache >---------- */
+
+/**
+ * @brief Creates the file cache
+ *
+ * Details: Like the MIME database, the cache is created once before the server starts accepting connections.
+ *
+ * @param[in] capacity The maximum number of bytes of file contents to keep in memory; 0 disables the cache
+ */
+void create_file_cache(size_t capacity)
+{
+    if (capacity == 0)
+        return;
+
+    file_cache = calloc(1, sizeof(File_cache));
+    if (file_cache == NULL)
+    {
+        perror("calloc");
+        return;
+    }
+
+    file_cache->index = Hashtable_create(CACHE_BUCKETS, NULL);
+    if (file_cache->index == NULL)
+    {
+        free(file_cache);
+        file_cache = NULL;
+        return;
+    }
+
+    pthread_mutex_init(&file_cache->lock, NULL);
+    file_cache->capacity = capacity;
+}
+
+/**
+ * @brief Destroys the file cache and every entry in it
+ */
+void destroy_file_cache()
+{
+    if (file_cache == NULL)
+        return;
+
+    while (file_cache->head != NULL)
+        cache_remove(file_cache, file_cache->head);
+
+    Hashtable_destroy(file_cache->index);
+    pthread_mutex_destroy(&file_cache->lock);
+    free(file_cache);
+    file_cache = NULL;
+}
+
+/**
+ * @brief Tells whether a file of a given size should be read into the cache
+ *
+ * @param[in] size The size of the file
+ * @return non-zero if the cache is enabled and the file is small enough to be cached
+ */
+int file_cache_accepts(size_t size)
+{
+    return file_cache != NULL && size <= CACHE_MAX_ENTRY_SIZE && size <= file_cache->capacity;
+}
+
+/**
+ * @brief Looks up a file in the cache
+ *
+ * Details: An entry whose file has changed since it was read is dropped and counted as an invalidation and a miss.
+ *          The returned entry stays valid until it is released with file_cache_release(), even if it is evicted.
+ *
+ * @param[in] path The full path of the file
+ * @param[in] st The current status of the file
+ * @return The entry, or NULL on a miss
+ */
+Cache_entry *file_cache_get(const char *path, const struct stat *st)
+{
+    if (!file_cache_accepts(st->st_size))
+        return NULL; // never cached; not counted as a miss
+
+    pthread_mutex_lock(&file_cache->lock);
+
+    Cache_entry *entry = Hashtable_get(file_cache->index, (char *)path);
+    if (entry != NULL && !entry_is_fresh(entry, st))
+    {
+        cache_remove(file_cache, entry);
+        file_cache->stats.invalidations++;
+        entry = NULL;
+    }
+
+    if (entry == NULL)
+    {
+        file_cache->stats.misses++;
+        pthread_mutex_unlock(&file_cache->lock);
+        return NULL;
+    }
+
+    lru_unlink(file_cache, entry);
+    lru_push_front(file_cache, entry);
+    __atomic_add_fetch(&entry->refs, 1, __ATOMIC_RELAXED);
+    file_cache->stats.hits++;
+
+    pthread_mutex_unlock(&file_cache->lock);
+
+    return entry;
+}
+
+/**
+ * @brief Tells whether the cache holds an up-to-date copy of a file, without counting a hit or a miss
+ *
+ * Details: Used to classify requests before they are served; the LRU order is not changed.
+ *
+ * @param[in] path The full path of the file
+ * @param[in] st The current status of the file
+ * @return non-zero if the file would be served from the cache
+ */
+int file_cache_contains(const char *path, const struct stat *st)
+{
+    if (!file_cache_accepts(st->st_size))
+        return 0;
+
+    pthread_mutex_lock(&file_cache->lock);
+    Cache_entry *entry = Hashtable_get(file_cache->index, (char *)path);
+    int fresh = entry != NULL && entry_is_fresh(entry, st);
+    pthread_mutex_unlock(&file_cache->lock);
+
+    return fresh;
+}
+
+/**
+ * @brief Adds the contents of a file to the cache
+ *
+ * Details: Least recently used entries are evicted until the new entry fits in the byte budget. If another worker
+ *          cached the same path in the meantime, its entry is replaced.
+ *
+ * @param[in] path The full path of the file
+ * @param[in] st The status of the file when it was read
+ * @param[in] data The contents of the file (st->st_size bytes allocated with malloc()); the cache takes ownership
+ * @param[in] mime_type The MIME type of the file (must stay valid for the lifetime of the cache)
+ * @return The new entry, which must be released with file_cache_release(), or NULL if it could not be created
+ *         (data is freed in that case)
+ */
+Cache_entry *file_cache_put(const char *path, const struct stat *st, char *data, const char *mime_type)
+{
+    Cache_entry *entry = calloc(1, sizeof(Cache_entry));
+    if (entry == NULL || (entry->path = strdup(path)) == NULL)
+    {
+        perror("calloc");
+        free(entry);
+        free(data);
+        return NULL;
+    }
+
+    entry->data = data;
+    entry->size = st->st_size;
+    entry->mime_type = mime_type;
+    entry->dev = st->st_dev;
+    entry->ino = st->st_ino;
+    entry->mtime = st->st_mtim;
+    entry->refs = 2; // one for the cache, one for the caller
+
+    pthread_mutex_lock(&file_cache->lock);
+
+    Cache_entry *old = Hashtable_get(file_cache->index, entry->path);
+    if (old != NULL)
+        cache_remove(file_cache, old);
+
+    while (file_cache->tail != NULL && file_cache->stats.bytes + entry->size > file_cache->capacity)
+    {
+        cache_remove(file_cache, file_cache->tail);
+        file_cache->stats.evictions++;
+    }
+
+    Hashtable_put(file_cache->index, entry->path, entry);
+    lru_push_front(file_cache, entry);
+    file_cache->stats.bytes += entry->size;
+    file_cache->stats.entries++;
+    file_cache->stats.insertions++;
+
+    pthread_mutex_unlock(&file_cache->lock);
+
+    return entry;
+}
+
+/**
+ * @brief Releases an entry returned by file_cache_get() or file_cache_put()
+ *
+ * @param[in] entry The entry
+ */
+void file_cache_release(Cache_entry *entry)
+{
+    entry_unref(entry);
+}
+
+/**
+ * @brief Takes a snapshot of the cache's counters
+ *
+ * @param[out] stats The counters (all zero if the cache is disabled)
+ */
+void file_cache_get_stats(Cache_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (file_cache == NULL)
+        return;
+
+    pthread_mutex_lock(&file_cache->lock);
+    *stats = file_cache->stats;
+    pthread_mutex_unlock(&file_cache->lock);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file cache.h
+ * @brief An in-memory LRU cache of static files
+ * @authors
+ *
+ * Details:
+ * - Small, frequently requested files are kept in memory together with their size, MIME type and the identity
+ *   of the file they were read from (device, inode, size and modification time). A hit is answered with a single
+ *   send of the response header and the cached bytes, without opening the file.
+ * - Entries are indexed by their full path in a HashTable. Recency is tracked with a doubly linked list threaded
+ *   through the entries, so a hit moves its entry to the front in O(1). When the total size of the cached files
+ *   would exceed the byte budget, entries are evicted from the back of the list.
+ * - An entry is only used if the file it was read from still has the same identity; a file that was modified or
+ *   replaced is dropped from the cache and read again.
+ * - Hits, misses, insertions, evictions and invalidations are counted.
+ *
+ * Assumptions/Limitations:
+ * - Files larger than CACHE_MAX_ENTRY_SIZE are never cached; they are sent with sendfile().
+ * - A single lock protects the cache. Entries are reference counted, so an entry that is evicted while a worker
+ *   is sending it is freed once the send is done.
+ *
+ * @date 2026-10-17
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include "hashtable.h"
+
+#define DEFAULT_CACHE_SIZE (32 * 1024 * 1024)
+#define CACHE_MAX_ENTRY_SIZE (1024 * 1024)
+#define CACHE_BUCKETS 1024
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Cache_entry {
+    char *path;                     /* full path of the file (the key) */
+    char *data;                     /* contents of the file */
+    size_t size;
+    const char *mime_type;
+    dev_t dev;                      /* identity of the file the contents were read from */
+    ino_t ino;
+    struct timespec mtime;
+    int refs;                       /* references held by the cache and by workers sending the entry */
+    struct Cache_entry *prev;       /* neighbours in the LRU list (most recently used first) */
+    struct Cache_entry *next;
+} Cache_entry;
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long insertions;
+    unsigned long evictions;        /* entries dropped to stay within the byte budget */
+    unsigned long invalidations;    /* entries dropped because their file changed */
+    size_t bytes;                   /* total size of the cached files */
+    int entries;
+} Cache_stats;
+
+typedef struct {
+    pthread_mutex_t lock;
+    HashTable *index;               /* path -> Cache_entry */
+    Cache_entry *head;              /* most recently used entry */
+    Cache_entry *tail;              /* least recently used entry */
+    size_t capacity;                /* byte budget */
+    Cache_stats stats;
+} File_cache;
+
+extern File_cache *file_cache;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void create_file_cache(size_t capacity);
+extern void destroy_file_cache();
+extern int file_cache_accepts(size_t size);
+extern Cache_entry *file_cache_get(const char *path, const struct stat *st);
+extern int file_cache_contains(const char *path, const struct stat *st);
+extern Cache_entry *file_cache_put(const char *path, const struct stat *st, char *data, const char *mime_type);
+extern void file_cache_release(Cache_entry *entry);
+extern void file_cache_get_stats(Cache_stats *stats);
+
+#endif
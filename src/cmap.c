@@ -0,0 +1,324 @@
+/**
+ * @file cmap.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "cmap.h"
+
+static inline pthread_mutex_t *stripe_of(CMap *map, uint64_t hash)
+{
+    return &map->stripes[hash & (CMAP_STRIPES - 1)].lock;
+}
+
+static inline int node_matches(const Cmap_node *node, uint64_t hash, const void *key, int key_size)
+{
+    return node->hash == hash && node->key_size == key_size && memcmp(node->key, key, key_size) == 0;
+}
+
+/**
+ * @brief Allocates a bucket array of the given size, all buckets empty
+ *
+ * @return The array, or NULL if memory allocation failed
+ */
+static Cmap_table *table_create(size_t size)
+{
+    Cmap_table *table = malloc(sizeof(Cmap_table));
+    if (table == NULL) {
+        return NULL;
+    }
+
+    table->buckets = calloc(size, sizeof(Cmap_node *));
+    if (table->buckets == NULL) {
+        free(table);
+        return NULL;
+    }
+    table->size = size;
+
+    return table;
+}
+
+/**
+ * @brief Frees a bucket array with all of its entries (used as an epoch_retire() callback)
+ */
+static void table_free(void *arg)
+{
+    Cmap_table *table = arg;
+
+    for (size_t i = 0; i < table->size; i++) {
+        Cmap_node *node = table->buckets[i];
+        while (node != NULL) {
+            Cmap_node *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+
+    free(table->buckets);
+    free(table);
+}
+
+/**
+ * @brief Doubles the number of buckets if the map is still over its load limit
+ *
+ * Details: Every stripe is locked (in order), so no writer can change the map meanwhile. The entries are copied
+ *          rather than relinked: a reader walking an old chain must still find every key that was in it.
+ *
+ * @param[in, out] map The map
+ */
+static void cmap_grow(CMap *map)
+{
+    for (int i = 0; i < CMAP_STRIPES; i++) {
+        pthread_mutex_lock(&map->stripes[i].lock);
+    }
+
+    Cmap_table *old = map->table;
+    Cmap_table *table = NULL;
+
+    if (__atomic_load_n(&map->num_entries, __ATOMIC_RELAXED) > (long)old->size * CMAP_MAX_LOAD) {
+        table = table_create(old->size * 2);
+    }
+
+    for (size_t i = 0; table != NULL && i < old->size; i++) {
+        for (Cmap_node *node = old->buckets[i]; node != NULL; node = node->next) {
+            Cmap_node *copy = malloc(sizeof(Cmap_node) + node->key_size);
+            if (copy == NULL) {
+                table_free(table);
+                table = NULL;
+                break;
+            }
+            memcpy(copy, node, sizeof(Cmap_node) + node->key_size);
+
+            size_t index = node->hash & (table->size - 1);
+            copy->next = table->buckets[index];
+            table->buckets[index] = copy;
+        }
+    }
+
+    if (table != NULL) {
+        __atomic_store_n(&map->table, table, __ATOMIC_RELEASE);
+    }
+
+    for (int i = CMAP_STRIPES - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&map->stripes[i].lock);
+    }
+
+    if (table != NULL) {
+        epoch_retire(old, table_free);
+    }
+}
+
+/**
+ * @brief Creates a new concurrent map
+ *
+ * @param[in] size The number of entries expected (the map grows beyond it as needed)
+ * @return A pointer to the newly created map, or NULL if memory allocation failed
+ */
+CMap *Cmap_create(int size)
+{
+    size_t buckets = CMAP_MIN_SIZE;
+
+    while (size > 0 && buckets * CMAP_MAX_LOAD < (size_t)size) {
+        buckets *= 2;
+    }
+
+    CMap *map = calloc(1, sizeof(CMap));
+    if (map == NULL) {
+        return NULL;
+    }
+
+    map->table = table_create(buckets);
+    if (map->table == NULL) {
+        free(map);
+        return NULL;
+    }
+
+    for (int i = 0; i < CMAP_STRIPES; i++) {
+        pthread_mutex_init(&map->stripes[i].lock, NULL);
+    }
+
+    return map;
+}
+
+/**
+ * @brief Destroys a concurrent map
+ *
+ * Details: The copies of the keys are freed; the data is not. Entries retired earlier are freed by the epoch
+ *          collector as usual.
+ *
+ * @param[in] map The map to be destroyed
+ */
+void Cmap_destroy(CMap *map)
+{
+    if (map == NULL) {
+        return;
+    }
+
+    table_free(map->table);
+    for (int i = 0; i < CMAP_STRIPES; i++) {
+        pthread_mutex_destroy(&map->stripes[i].lock);
+    }
+    free(map);
+}
+
+/**
+ * @brief Inserts a key-value pair using a string key
+ *
+ * @param[in, out] map A pointer to a map
+ * @param[in] key A pointer to a string key
+ * @param[in] data A pointer to a value
+ * @return The value that was inserted, or NULL if the insertion failed
+ */
+void *Cmap_put(CMap *map, char *key, void *data)
+{
+    return Cmap_put_bin(map, key, strlen(key), data);
+}
+
+/**
+ * @brief Inserts a key-value pair, or replaces the value of a key that is already in the map
+ *
+ * Details: Only the key's stripe is locked. A new entry is linked in at the head of its bucket after it has been
+ *          filled in, so concurrent readers either see all of it or none of it.
+ *
+ * @param[in, out] map A pointer to a map
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @param[in] data A pointer to a value
+ * @return The value that was inserted, or NULL if the insertion failed
+ */
+void *Cmap_put_bin(CMap *map, void *key, int key_size, void *data)
+{
+    uint64_t hash = hash_bytes(key, key_size);
+    pthread_mutex_t *lock = stripe_of(map, hash);
+
+    pthread_mutex_lock(lock);
+
+    Cmap_table *table = map->table;     // cannot change while a stripe is locked
+    Cmap_node **bucket = &table->buckets[hash & (table->size - 1)];
+
+    for (Cmap_node *node = *bucket; node != NULL; node = node->next) {
+        if (node_matches(node, hash, key, key_size)) {
+            __atomic_store_n(&node->data, data, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(lock);
+            return data;
+        }
+    }
+
+    Cmap_node *node = malloc(sizeof(Cmap_node) + key_size);
+    if (node == NULL) {
+        pthread_mutex_unlock(lock);
+        return NULL;
+    }
+    node->next = *bucket;
+    node->data = data;
+    node->hash = hash;
+    node->key_size = key_size;
+    memcpy(node->key, key, key_size);
+    __atomic_store_n(bucket, node, __ATOMIC_RELEASE);
+
+    long num_entries = __atomic_add_fetch(&map->num_entries, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(lock);
+
+    if (num_entries > (long)table->size * CMAP_MAX_LOAD) {
+        cmap_grow(map);
+    }
+
+    return data;
+}
+
+/**
+ * @brief Retrieves a value using a string key
+ *
+ * @param[in] map A pointer to a map
+ * @param[in] key A pointer to a string key
+ * @return The value associated with the key, or NULL if the key is not found
+ */
+void *Cmap_get(CMap *map, char *key)
+{
+    return Cmap_get_bin(map, key, strlen(key));
+}
+
+/**
+ * @brief Retrieves a value without taking a lock
+ *
+ * @param[in] map A pointer to a map
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @return The value associated with the key, or NULL if the key is not found
+ */
+void *Cmap_get_bin(CMap *map, void *key, int key_size)
+{
+    uint64_t hash = hash_bytes(key, key_size);
+    void *data = NULL;
+
+    epoch_enter();
+
+    Cmap_table *table = __atomic_load_n(&map->table, __ATOMIC_ACQUIRE);
+    Cmap_node *node = __atomic_load_n(&table->buckets[hash & (table->size - 1)], __ATOMIC_ACQUIRE);
+
+    while (node != NULL) {
+        if (node_matches(node, hash, key, key_size)) {
+            data = __atomic_load_n(&node->data, __ATOMIC_ACQUIRE);
+            break;
+        }
+        node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    }
+
+    epoch_exit();
+
+    return data;
+}
+
+/**
+ * @brief Deletes a key-value pair using a string key
+ *
+ * @param[in, out] map A pointer to a map
+ * @param[in] key A pointer to a string key
+ * @return The value that was deleted, or NULL if the key was not found
+ */
+void *Cmap_delete(CMap *map, char *key)
+{
+    return Cmap_delete_bin(map, key, strlen(key));
+}
+
+/**
+ * @brief Deletes a key-value pair
+ *
+ * Details: The entry is unlinked under the key's stripe lock and freed by the epoch collector once no reader can
+ *          be looking at it. The data is returned to the caller, who must not free it before readers are done with
+ *          it either (see epoch_retire()).
+ *
+ * @param[in, out] map A pointer to a map
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @return The value that was deleted, or NULL if the key was not found
+ */
+void *Cmap_delete_bin(CMap *map, void *key, int key_size)
+{
+    uint64_t hash = hash_bytes(key, key_size);
+    pthread_mutex_t *lock = stripe_of(map, hash);
+
+    pthread_mutex_lock(lock);
+
+    Cmap_table *table = map->table;
+    Cmap_node **link = &table->buckets[hash & (table->size - 1)];
+
+    while (*link != NULL && !node_matches(*link, hash, key, key_size)) {
+        link = &(*link)->next;
+    }
+
+    Cmap_node *node = *link;
+    if (node == NULL) {
+        pthread_mutex_unlock(lock);
+        return NULL;
+    }
+
+    __atomic_store_n(link, node->next, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&map->num_entries, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(lock);
+
+    void *data = node->data;
+    epoch_retire(node, free);
+
+    return data;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file cmap.h
+ * @brief A concurrent hash map for tables that every worker reads on every request
+ * @authors
+ *
+ * Details:
+ * - A CMap maps keys of any type to data pointers, with the same put/get/delete functions for string and binary
+ *   keys as HashTable and SwissTable, but may be used by many threads at once.
+ * - Lookups take no lock and write nothing shared: they run inside an epoch critical section (see epoch.h) and
+ *   follow the bucket chains with atomic loads. Many workers hitting the same entries therefore do not bounce a
+ *   lock's cache line between them.
+ * - Writers lock one of CMAP_STRIPES stripes; bucket i belongs to stripe i % CMAP_STRIPES, so writers of keys in
+ *   different stripes do not wait for each other. A new entry is fully built before it is linked in, and an entry
+ *   that is deleted is unlinked and handed to epoch_retire(), so a reader never sees a half-built entry or one
+ *   that has been freed.
+ * - The table doubles when it holds more than CMAP_MAX_LOAD entries per bucket. The writer that notices takes
+ *   every stripe, builds a new bucket array with copies of the entries and publishes it; readers still walking
+ *   the old array finish there, and the old array and entries are retired.
+ *
+ * Assumptions/Limitations:
+ * - The map owns the copies of its keys, not the data. A reader may only use the data it got from Cmap_get()
+ *   until the writer that deletes or replaces it could free it: either the data is never freed while the map is
+ *   in use, or the writer frees it with epoch_retire() and the reader brackets the lookup and its use of the
+ *   data with epoch_enter()/epoch_exit().
+ * - Like Swisstable_put(), Cmap_put() replaces the data of a key that is already in the map.
+ * - Cmap_destroy() must not run concurrently with any other operation on the map.
+ *
+ * @date 2026-10-17
+ */
+#ifndef CMAP_H
+#define CMAP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "epoch.h"
+#include "hash.h"
+
+#define CMAP_STRIPES 64             /* writer locks (a power of two) */
+#define CMAP_MIN_SIZE 64            /* buckets of a new map (a power of two, at least CMAP_STRIPES) */
+#define CMAP_MAX_LOAD 1             /* entries per bucket above which the map doubles */
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Cmap_node {
+    struct Cmap_node *next;
+    void *data;
+    uint64_t hash;
+    int key_size;
+    char key[];                     /* copy of the key */
+} Cmap_node;
+
+typedef struct {
+    Cmap_node **buckets;
+    size_t size;                    /* a power of two */
+} Cmap_table;
+
+typedef struct {
+    pthread_mutex_t lock;
+} __attribute__((aligned(64))) Cmap_stripe;   /* one cache line per lock */
+
+typedef struct {
+    Cmap_table *table;              /* the current bucket array (replaced when the map grows) */
+    Cmap_stripe stripes[CMAP_STRIPES];
+    long num_entries;
+} CMap;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern CMap *Cmap_create(int size);
+extern void Cmap_destroy(CMap *map);
+
+extern void *Cmap_put(CMap *map, char *key, void *data);
+extern void *Cmap_put_bin(CMap *map, void *key, int key_size, void *data);
+
+extern void *Cmap_get(CMap *map, char *key);
+extern void *Cmap_get_bin(CMap *map, void *key, int key_size);
+
+extern void *Cmap_delete(CMap *map, char *key);
+extern void *Cmap_delete_bin(CMap *map, void *key, int key_size);
+
+#endif
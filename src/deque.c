@@ -0,0 +1,125 @@
+/**
+ * @file deque.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "deque.h"
+
+/**
+ * @brief Creates an empty deque
+ *
+ * @param[in] capacity The minimum number of items the deque can hold (rounded up to a power of two)
+ * @return The new deque, or NULL if it could not be allocated
+ */
+Deque *deque_create(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    Deque *deque = aligned_alloc(CACHE_LINE_SIZE, sizeof(Deque));
+    if (deque == NULL)
+        return NULL;
+
+    deque->items = calloc(size, sizeof(void *));
+    if (deque->items == NULL)
+    {
+        free(deque);
+        return NULL;
+    }
+
+    deque->top = 0;
+    deque->bottom = 0;
+    deque->mask = size - 1;
+
+    return deque;
+}
+
+/**
+ * @brief Frees a deque (items still in it are not freed)
+ */
+void deque_destroy(Deque *deque)
+{
+    if (deque == NULL)
+        return;
+
+    free(deque->items);
+    free(deque);
+}
+
+/**
+ * @brief Pushes an item at the bottom of the deque (owner only)
+ *
+ * @param[in] deque The deque
+ * @param[in] item The item (must not be NULL)
+ * @return 1 if the item was pushed, 0 if the deque is full
+ */
+int deque_push(Deque *deque, void *item)
+{
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+
+    if (bottom - top > deque->mask)
+        return 0;
+
+    __atomic_store_n(&deque->items[bottom & deque->mask], item, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);    /* publish the item before the new bottom */
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * @brief Takes the most recently pushed item (owner only)
+ *
+ * @param[in] deque The deque
+ * @return The item, or NULL if the deque is empty or a thief took the last item
+ */
+void *deque_take(Deque *deque)
+{
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    void *item = NULL;
+
+    /* reserve the bottom item before looking at top, so a thief cannot take it unnoticed */
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top <= bottom)
+    {
+        item = __atomic_load_n(&deque->items[bottom & deque->mask], __ATOMIC_RELAXED);
+        if (top == bottom)
+        {
+            /* last item: race the thieves for it */
+            if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                item = NULL;
+            __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);   // the deque was empty
+
+    return item;
+}
+
+/**
+ * @brief Steals the oldest item of the deque (any thread)
+ *
+ * @param[in] deque The deque
+ * @return The item, or NULL if the deque is empty or another thread took the item first
+ */
+void *deque_steal(Deque *deque)
+{
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+    if (top >= bottom)
+        return NULL;
+
+    void *item = __atomic_load_n(&deque->items[top & deque->mask], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+
+    return item;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file deque.h
+ * @brief A fixed-size Chase-Lev work-stealing deque
+ * @authors
+ *
+ * Details:
+ * - Each deque has one owner thread that pushes and takes items at the bottom (LIFO, so the most recently
+ *   spawned and cache-hot item runs first), while any other thread can steal items from the top (FIFO, so
+ *   thieves take the oldest items). The owner only synchronizes with thieves when they compete for the last
+ *   item.
+ * - The memory ordering follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013).
+ *
+ * Assumptions/Limitations:
+ * - Only the owner may call deque_push() and deque_take(); deque_steal() may be called by any thread.
+ * - The capacity is fixed (rounded up to a power of two) and the buffer never grows, so no thread can be left
+ *   reading a buffer that has been freed. deque_push() fails when the deque is full and the caller has to put
+ *   the item somewhere else.
+ * - NULL cannot be stored, since deque_take() and deque_steal() return NULL when there is nothing to take.
+ *
+ * @date 2026-10-17
+ */
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) long top;         /* next item to steal (advanced by thieves and the owner) */
+    _Alignas(CACHE_LINE_SIZE) long bottom;      /* next free slot (written by the owner only) */
+    _Alignas(CACHE_LINE_SIZE) long mask;        /* capacity - 1 */
+    void **items;
+} Deque;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern Deque *deque_create(size_t capacity);
+extern void deque_destroy(Deque *deque);
+extern int deque_push(Deque *deque, void *item);
+extern void *deque_take(Deque *deque);
+extern void *deque_steal(Deque *deque);
+
+#endif
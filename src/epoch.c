@@ -0,0 +1,195 @@
+/**
+ * @file epoch.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include <stdio.h>
+#include <sched.h>
+#include "epoch.h"
+
+static unsigned long global_epoch = 1;
+static Epoch_record *records;                    /* every record ever created (pushed, never removed) */
+static __thread Epoch_record *thread_record;     /* the calling thread's record */
+static pthread_key_t record_key;                 /* only used to give the record up when the thread exits */
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Gives a thread's record up for reuse when the thread exits (its retired objects stay in it)
+ */
+static void release_record(void *arg)
+{
+    Epoch_record *record = arg;
+
+    __atomic_store_n(&record->local, 0, __ATOMIC_RELEASE);
+    record->depth = 0;
+    __atomic_store_n(&record->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_record_key()
+{
+    pthread_key_create(&record_key, release_record);
+}
+
+/**
+ * @brief Finds the calling thread's record, taking over a released one or creating a new one on first use
+ *
+ * @return The record, or NULL if memory allocation failed
+ */
+static Epoch_record *get_record()
+{
+    Epoch_record *record = thread_record;
+
+    if (record != NULL)
+        return record;
+
+    for (record = __atomic_load_n(&records, __ATOMIC_ACQUIRE); record != NULL; record = record->next)
+    {
+        int free_record = 0;
+        if (__atomic_compare_exchange_n(&record->in_use, &free_record, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (record == NULL)
+    {
+        record = calloc(1, sizeof(Epoch_record));
+        if (record == NULL)
+            return NULL;
+        record->in_use = 1;
+        record->next = __atomic_load_n(&records, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&records, &record->next, record, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+
+    pthread_once(&record_key_once, create_record_key);
+    pthread_setspecific(record_key, record);
+    thread_record = record;
+    return record;
+}
+
+/**
+ * @brief Enters a critical section: objects retired from now on are not freed until the thread leaves it
+ */
+void epoch_enter()
+{
+    Epoch_record *record = get_record();
+
+    if (record == NULL)
+        abort();    // a reader without a record could not be protected
+
+    if (record->depth++ == 0)
+    {
+        unsigned long epoch;
+        // the announcement must be visible before any shared pointer is read, and must name the current epoch
+        do
+        {
+            epoch = __atomic_load_n(&global_epoch, __ATOMIC_RELAXED);
+            __atomic_store_n(&record->local, epoch << 1 | 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        } while (__atomic_load_n(&global_epoch, __ATOMIC_RELAXED) != epoch);
+    }
+}
+
+/**
+ * @brief Leaves a critical section entered with epoch_enter()
+ */
+void epoch_exit()
+{
+    Epoch_record *record = thread_record;
+
+    if (--record->depth == 0)
+        __atomic_store_n(&record->local, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Advances the global epoch if every thread inside a critical section has seen the current one
+ *
+ * @return The global epoch after the attempt
+ */
+static unsigned long try_advance()
+{
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+
+    for (Epoch_record *record = __atomic_load_n(&records, __ATOMIC_ACQUIRE); record != NULL; record = record->next)
+    {
+        unsigned long local = __atomic_load_n(&record->local, __ATOMIC_SEQ_CST);
+        if ((local & 1) && (local >> 1) != epoch)
+            return epoch;
+    }
+
+    __atomic_compare_exchange_n(&global_epoch, &epoch, epoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Frees the objects of a record that were retired at least two epochs before epoch
+ */
+static void collect(Epoch_record *record, unsigned long epoch)
+{
+    Epoch_retired **link = &record->retired;
+
+    while (*link != NULL)
+    {
+        Epoch_retired *retired = *link;
+        if (retired->epoch + 2 <= epoch)
+        {
+            *link = retired->next;
+            retired->free_fn(retired->ptr);
+            free(retired);
+            record->num_retired--;
+        }
+        else
+        {
+            link = &retired->next;
+        }
+    }
+}
+
+/**
+ * @brief Frees an object once no reader can be looking at it any more
+ *
+ * Details: The object must already be unreachable for readers that enter a critical section from now on. If the
+ *          bookkeeping cannot be allocated the thread waits for two epochs and frees the object itself (or leaks it
+ *          if the thread is inside a critical section, where waiting would never end).
+ *
+ * @param[in] ptr The object
+ * @param[in] free_fn The function that frees it (e.g. free)
+ */
+void epoch_retire(void *ptr, void (*free_fn)(void *ptr))
+{
+    Epoch_record *record = get_record();
+    Epoch_retired *retired = malloc(sizeof(Epoch_retired));
+
+    if (record == NULL || retired == NULL)
+    {
+        perror("malloc");
+        free(retired);
+        if (record != NULL && record->depth > 0)
+            return;
+        unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+        while (try_advance() < epoch + 2)
+            sched_yield();
+        free_fn(ptr);
+        return;
+    }
+
+    retired->ptr = ptr;
+    retired->free_fn = free_fn;
+    retired->epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    retired->next = record->retired;
+    record->retired = retired;
+
+    if (++record->num_retired % EPOCH_RETIRE_BATCH == 0)
+        collect(record, try_advance());
+}
+
+/**
+ * @brief Frees every retired object of every thread
+ *
+ * Details: Only for shutdown: no thread may be inside a critical section or retiring objects.
+ */
+void epoch_drain()
+{
+    for (Epoch_record *record = __atomic_load_n(&records, __ATOMIC_ACQUIRE); record != NULL; record = record->next)
+        collect(record, (unsigned long)-1);
+}
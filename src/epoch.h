@@ -0,0 +1,57 @@
+/**
+ * @file epoch.h
+ * @brief Epoch-based reclamation: freeing memory that lock-free readers may still be looking at
+ * @authors
+ *
+ * Details:
+ * - A reader brackets its accesses to a shared structure with epoch_enter() and epoch_exit() (a critical section).
+ *   Neither takes a lock: entering only publishes the current global epoch in the thread's own record.
+ * - A writer that unlinks an object hands it to epoch_retire() instead of freeing it. The object is tagged with
+ *   the global epoch and freed once the epoch has advanced twice, which can only happen after every reader that
+ *   was inside a critical section when the object was unlinked has left it.
+ * - The global epoch advances when every thread inside a critical section has seen the current epoch. Writers try
+ *   to advance it, and free what has become safe to free, every EPOCH_RETIRE_BATCH retirements.
+ *
+ * Assumptions/Limitations:
+ * - Critical sections may nest, but must be short and must not block: a reader that stays inside one keeps every
+ *   object retired since it entered from being freed.
+ * - Objects are freed by the thread that retired them. A thread that exits leaves its retired objects in its
+ *   record, which the next thread to start reuses; epoch_drain() frees everything at shutdown.
+ * - Thread records are never freed; there is one per thread that was alive at the same time.
+ *
+ * @date 2026-10-17
+ */
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#define EPOCH_RETIRE_BATCH 64       /* retirements between attempts to advance the epoch and free objects */
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Epoch_retired {
+    void *ptr;
+    void (*free_fn)(void *ptr);
+    unsigned long epoch;            /* global epoch when the object was retired */
+    struct Epoch_retired *next;
+} Epoch_retired;
+
+typedef struct Epoch_record {
+    unsigned long local;            /* (epoch << 1) | 1 inside a critical section, 0 outside */
+    int depth;                      /* nesting depth of critical sections */
+    int in_use;                     /* owned by a live thread */
+    Epoch_retired *retired;         /* objects retired by the owner, newest first */
+    int num_retired;
+    struct Epoch_record *next;      /* all records ever created */
+} Epoch_record;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void epoch_enter();
+extern void epoch_exit();
+extern void epoch_retire(void *ptr, void (*free_fn)(void *ptr));
+extern void epoch_drain();
+
+#endif
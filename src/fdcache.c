@@ -0,0 +1,283 @@
+/**
+ * @file fdcache.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "fdcache.h"
+
+Fd_cache *fd_cache;
+
+/**
+ * @brief Returns the current monotonic time in milliseconds
+ */
+static long now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+static void entry_free(void *arg)
+{
+    Fd_entry *entry = arg;
+
+    free(entry->path);
+    free(entry);
+}
+
+/**
+ * @brief Drops a reference to an entry, closing it when it was the last one
+ *
+ * Details: The memory is freed only once no lookup can still be reading the entry.
+ *
+ * @param[in] entry The entry
+ */
+static void entry_unref(Fd_entry *entry)
+{
+    if (__atomic_sub_fetch(&entry->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        if (entry->fd != -1)
+            close(entry->fd);
+        epoch_retire(entry, entry_free);
+    }
+}
+
+/**
+ * @brief Takes a reference to an entry found by a lookup, unless its last reference is already gone
+ *
+ * @return 1 if a reference was taken, 0 otherwise
+ */
+static int entry_ref(Fd_entry *entry)
+{
+    int refs = __atomic_load_n(&entry->refs, __ATOMIC_RELAXED);
+
+    while (refs > 0)
+    {
+        if (__atomic_compare_exchange_n(&entry->refs, &refs, refs + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the cached entry of a path if it is still fresh, with a reference taken (lock-free)
+ */
+static Fd_entry *find_fresh(const char *path)
+{
+    epoch_enter();
+    Fd_entry *entry = Cmap_get(fd_cache->index, (char *)path);
+    if (entry != NULL && (entry->expires <= now_ms() || !entry_ref(entry)))
+        entry = NULL;
+    epoch_exit();
+
+    return entry;
+}
+
+/**
+ * @brief Removes an entry from the cache (the lock must be held)
+ *
+ * @param[in] entry The entry to remove
+ */
+static void cache_remove(Fd_entry *entry)
+{
+    Cmap_delete(fd_cache->index, entry->path);
+
+    if (entry->prev != NULL)
+        entry->prev->next = entry->next;
+    else
+        fd_cache->oldest = entry->next;
+
+    if (entry->next != NULL)
+        entry->next->prev = entry->prev;
+    else
+        fd_cache->newest = entry->prev;
+
+    fd_cache->num_entries--;
+    entry_unref(entry); // the cache's reference
+}
+
+/**
+ * @brief Opens a path and records what was found
+ *
+ * @param[in] path The full path
+ * @return A new entry (positive or negative), or NULL if it could not be allocated
+ */
+static Fd_entry *resolve(const char *path)
+{
+    Fd_entry *entry = calloc(1, sizeof(Fd_entry));
+    if (entry == NULL || (entry->path = strdup(path)) == NULL)
+    {
+        perror("calloc");
+        free(entry);
+        return NULL;
+    }
+
+    // O_NONBLOCK so that opening a FIFO cannot block a worker
+    entry->fd = open(path, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (entry->fd != -1 && fstat(entry->fd, &entry->st) == 0 && (S_ISREG(entry->st.st_mode) || S_ISDIR(entry->st.st_mode)))
+    {
+        entry->exists = 1;
+
+        if (S_ISDIR(entry->st.st_mode))
+        {
+            close(entry->fd); // directories are listed by path
+            entry->fd = -1;
+        }
+        else
+        {
+            entry->mime_type = get_mime_type(path);
+        }
+    }
+    else if (entry->fd != -1)
+    {
+        close(entry->fd);
+        entry->fd = -1;
+    }
+
+    entry->expires = now_ms() + FD_CACHE_TTL_MS;
+    entry->refs = 2; // one for the cache, one for the caller
+
+    return entry;
+}
+
+/**
+ * @brief Creates the file descriptor cache
+ */
+void create_fd_cache()
+{
+    fd_cache = calloc(1, sizeof(Fd_cache));
+    if (fd_cache == NULL)
+    {
+        perror("calloc");
+        return;
+    }
+
+    fd_cache->index = Cmap_create(FD_CACHE_MAX_ENTRIES);
+    if (fd_cache->index == NULL)
+    {
+        free(fd_cache);
+        fd_cache = NULL;
+        return;
+    }
+
+    pthread_mutex_init(&fd_cache->lock, NULL);
+}
+
+/**
+ * @brief Destroys the file descriptor cache, closing every cached file descriptor
+ */
+void destroy_fd_cache()
+{
+    if (fd_cache == NULL)
+        return;
+
+    while (fd_cache->oldest != NULL)
+        cache_remove(fd_cache->oldest);
+
+    Cmap_destroy(fd_cache->index);
+    pthread_mutex_destroy(&fd_cache->lock);
+    free(fd_cache);
+    fd_cache = NULL;
+}
+
+/**
+ * @brief Looks up (or resolves) a path
+ *
+ * Details: A cached entry younger than FD_CACHE_TTL_MS is returned as is, without taking a lock. Otherwise the
+ *          path is opened again, outside of the lock, and the new entry replaces the old one.
+ *
+ * @param[in] path The full path
+ * @return The entry, which must be released with fd_cache_release(), or NULL if it could not be allocated. Check
+ *         entry->exists before using it.
+ */
+Fd_entry *fd_cache_open(const char *path)
+{
+    if (fd_cache == NULL)
+    {
+        Fd_entry *entry = resolve(path);
+        if (entry != NULL)
+            entry->refs = 1; // only the caller's reference
+        return entry;
+    }
+
+    Fd_entry *entry = find_fresh(path);
+    if (entry != NULL)
+    {
+        __atomic_add_fetch(&fd_cache->hits, 1, __ATOMIC_RELAXED);
+        return entry;
+    }
+
+    __atomic_add_fetch(&fd_cache->misses, 1, __ATOMIC_RELAXED);
+
+    entry = resolve(path);
+    if (entry == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&fd_cache->lock);
+
+    Fd_entry *old = Cmap_get(fd_cache->index, entry->path);
+    if (old != NULL)
+        cache_remove(old);
+    if (fd_cache->num_entries >= FD_CACHE_MAX_ENTRIES)
+        cache_remove(fd_cache->oldest);
+
+    if (Cmap_put(fd_cache->index, entry->path, entry) == NULL)
+    {
+        pthread_mutex_unlock(&fd_cache->lock);
+        entry->refs = 1; // not cached: only the caller's reference
+        return entry;
+    }
+    entry->prev = fd_cache->newest;
+    if (fd_cache->newest != NULL)
+        fd_cache->newest->next = entry;
+    else
+        fd_cache->oldest = entry;
+    fd_cache->newest = entry;
+    fd_cache->num_entries++;
+
+    pthread_mutex_unlock(&fd_cache->lock);
+
+    return entry;
+}
+
+/**
+ * @brief Returns what the cache already knows about a path, without touching the disk
+ *
+ * @param[in] path The full path of the file
+ * @return The entry (release it with fd_cache_release()), or NULL if the path is not cached or has expired
+ */
+Fd_entry *fd_cache_lookup(const char *path)
+{
+    if (fd_cache == NULL)
+        return NULL;
+
+    return find_fresh(path);
+}
+
+/**
+ * @brief Releases an entry returned by fd_cache_open() or fd_cache_lookup()
+ *
+ * @param[in] entry The entry
+ */
+void fd_cache_release(Fd_entry *entry)
+{
+    entry_unref(entry);
+}
+
+/**
+ * @brief Forgets what is known about a path, e.g. after the server has written to it
+ *
+ * @param[in] path The full path
+ */
+void fd_cache_invalidate(const char *path)
+{
+    if (fd_cache == NULL)
+        return;
+
+    pthread_mutex_lock(&fd_cache->lock);
+    Fd_entry *entry = Cmap_get(fd_cache->index, (char *)path);
+    if (entry != NULL)
+        cache_remove(entry);
+    pthread_mutex_unlock(&fd_cache->lock);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file fdcache.h
+ * @brief A cache of open file descriptors and file metadata
+ * @authors
+ *
+ * Details:
+ * - Resolving the target of a request used to take an access(), a stat(), an open() and an fstat() on every
+ *   request. Instead, the full path of the target is resolved once with open() and fstat(), and the result is
+ *   shared by every request for the same path for FD_CACHE_TTL_MS milliseconds: the open file descriptor (for
+ *   regular files), the file's status and its MIME type.
+ * - Paths that do not exist are cached too (negative entries), so repeated requests for missing files are
+ *   answered with 404 Not Found without touching the disk.
+ * - The entries are indexed by a CMap (see cmap.h), so lookups take no lock at all and concurrent hits do not
+ *   serialize; a mutex only orders the writers that add and remove entries. Entries are reference counted; an
+ *   entry that expires or is replaced while a worker is still sending from its file descriptor is closed once the
+ *   worker releases it, and its memory is freed through epoch_retire() once no lookup can still be reading it.
+ *
+ * Assumptions/Limitations:
+ * - Changes made to a file by other programs are noticed at most FD_CACHE_TTL_MS milliseconds later. Changes made
+ *   by the server itself (POST) invalidate the entry immediately.
+ * - File descriptors are shared between threads, so they are only read with pread() and sendfile() with an
+ *   explicit offset.
+ * - At most FD_CACHE_MAX_ENTRIES paths are cached; the oldest entry is dropped to make room for a new one.
+ *
+ * @date 2026-10-17
+ */
+#ifndef FDCACHE_H
+#define FDCACHE_H
+
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "cmap.h"
+#include "mime.h"
+
+#define FD_CACHE_TTL_MS 1000
+#define FD_CACHE_MAX_ENTRIES 4096
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Fd_entry {
+    char *path;                     /* full path of the file (the key) */
+    int exists;                     /* 0 for a negative entry: the path could not be opened */
+    int fd;                         /* open file descriptor of a regular file, -1 otherwise */
+    struct stat st;
+    const char *mime_type;
+    long expires;                   /* monotonic time (ms) after which the entry is resolved again */
+    int refs;                       /* references held by the cache and by requests using the entry */
+    struct Fd_entry *prev;          /* neighbours in insertion order (oldest first) */
+    struct Fd_entry *next;
+} Fd_entry;
+
+typedef struct {
+    pthread_mutex_t lock;           /* held by writers (the index's entries and the insertion order) */
+    CMap *index;                    /* path -> Fd_entry */
+    Fd_entry *oldest;
+    Fd_entry *newest;
+    int num_entries;
+    unsigned long hits;
+    unsigned long misses;
+} Fd_cache;
+
+extern Fd_cache *fd_cache;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void create_fd_cache();
+extern void destroy_fd_cache();
+extern Fd_entry *fd_cache_open(const char *path);
+extern Fd_entry *fd_cache_lookup(const char *path);
+extern void fd_cache_release(Fd_entry *entry);
+extern void fd_cache_invalidate(const char *path);
+
+#endif
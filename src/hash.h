@@ -0,0 +1,34 @@
+/**
+ * @file hash.h
+ * @brief A fast, seeded 64-bit hash function for the server's hash tables
+ * @authors
+ *
+ * Details:
+ * - hash_bytes() is wyhash (final version 4): it reads 8 or 16 bytes per step and mixes them with a 64x64->128-bit
+ *   multiplication, so long keys such as URL paths and header values hash at several bytes per cycle. All 64 bits
+ *   of the result are well mixed, so tables can pick a bucket by masking the low bits of the hash with a power of
+ *   two instead of a division.
+ * - Every process picks a random seed (getrandom(), falling back to the clock and the process id) before main()
+ *   runs. Clients therefore cannot precompute keys that all land in the same bucket.
+ *
+ * Assumptions/Limitations:
+ * - This is not a cryptographic hash; the seed only makes collisions hard to predict from outside.
+ * - The hash of a key differs between runs, so hashes must never be stored or sent anywhere.
+ * - Uses the compiler's unsigned __int128 (GCC and Clang on 64-bit targets).
+ *
+ * @date 2026-10-17
+ */
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern uint64_t hash_seed;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern uint64_t hash_bytes(const void *key, size_t len);
+extern uint64_t hash_bytes_seeded(const void *key, size_t len, uint64_t seed);
+
+#endif
@@ -6,11 +6,16 @@
  */
 #include "hashtable.h"
 
+static LinkedList *old_bucket_of(HashTable *ht, void *key, int key_size);
+static void rehash_step(HashTable *ht, int steps);
+static void rehash_start(HashTable *ht, int size);
+
 /**
  * @brief Creates a new hash table
  *
  * Details: This function creates a new hash table of a given size and uses the provided hash function. 
  *          If the function receives an invalid size or isn't given a hash function, default values are used.
+ *          The size is rounded up to a power of two, which seeded_hashf() relies on.
  * 
  * @param[in] size The size of the hash table
  * @param[in] hashf The hash function to be used
@@ -22,8 +27,14 @@ extern HashTable *Hashtable_create(int size, int (*hashf)(void *, int, int))
         size = DEFAULT_SIZE;
     }
 
+    int buckets = 1;
+    while (buckets < size && buckets <= INT_MAX / 2) {
+        buckets *= 2;
+    }
+    size = buckets;
+
     if (hashf == NULL) {    // use default hash function
-        hashf = str_hashf;
+        hashf = seeded_hashf;
     }
 
     HashTable *ht = (HashTable *)calloc(1, sizeof(HashTable));
@@ -35,11 +46,12 @@ extern HashTable *Hashtable_create(int size, int (*hashf)(void *, int, int))
     ht->size = size;
     ht->num_entries = 0;
     ht->load_factor = 0;
-    ht->buckets = malloc(size * sizeof(LinkedList *));
+    ht->buckets = calloc(size, sizeof(LinkedList *));   // a bucket's list is created by its first entry
     ht->hashf = hashf;
 
-    for (int i = 0; i < size; i++) {
-        ht->buckets[i] = llist_create();
+    if (ht->buckets == NULL) {
+        free(ht);
+        return NULL;
     }
 
     return ht;
@@ -61,10 +73,26 @@ void Hashtable_destroy(HashTable *ht)
     {
         LinkedList *list = ht->buckets[i];
 
+        if (list == NULL) {
+            continue;
+        }
 		llist_foreach(list, free_htentry, NULL);
         llist_destroy(list);
     }
 
+    for (int i = ht->rehash_index; ht->old_buckets != NULL && i < ht->old_size; i++)
+    {
+        LinkedList *list = ht->old_buckets[i];
+
+        if (list == NULL) {
+            continue;
+        }
+        llist_foreach(list, free_htentry, NULL);
+        llist_destroy(list);
+    }
+
+    free(ht->old_buckets);
+    free(ht->buckets);
     free(ht);
 }
 
@@ -89,7 +117,9 @@ void *Hashtable_put(HashTable *ht, char *key, void *data)
  * Details: This function inserts a key-value pair into the hash table. The key and
  *          value can point to an object of any data type. Creates a HtEntry instance
  *          containing the passed in key and value and appends it to the end of
- *          the bucket that the key hashes to. The hash table's size and load_factor are updated accordingly
+ *          the bucket that the key hashes to. The hash table's size and load_factor are updated accordingly.
+ *          While the table is being resized a few old buckets are migrated first; once the load factor
+ *          exceeds MAX_LOAD_FACTOR a new resize is started.
  * 
  * @param[in, out] ht A pointer to a hash table
  * @param[in] key A pointer to a key
@@ -99,13 +129,27 @@ void *Hashtable_put(HashTable *ht, char *key, void *data)
  */
 void *Hashtable_put_bin(HashTable *ht, void *key, int key_size, void *data)
 {
+    if (ht->old_buckets != NULL) {
+        rehash_step(ht, REHASH_STEP);
+    }
+
     int index = ht->hashf(key, key_size, ht->size);
 
+    if (ht->buckets[index] == NULL && (ht->buckets[index] = llist_create()) == NULL) {
+        return NULL;
+    }
     LinkedList *list = ht->buckets[index];
 
     HtEntry *entry = malloc(sizeof(HtEntry));
+    if (entry == NULL) {
+        return NULL;
+    }
 
     entry->key = malloc(key_size);
+    if (entry->key == NULL) {
+        free(entry);
+        return NULL;
+    }
     memcpy(entry->key, key, key_size);
 
     entry->key_size = key_size;
@@ -121,6 +165,10 @@ void *Hashtable_put_bin(HashTable *ht, void *key, int key_size, void *data)
 
     Hashtable_update(ht, 1);
 
+    if (ht->old_buckets == NULL && ht->load_factor > MAX_LOAD_FACTOR) {
+        rehash_start(ht, ht->size * DEFAULT_GROW_FACTOR);
+    }
+
     return data;
 }
 
@@ -143,7 +191,9 @@ void *Hashtable_get(HashTable *ht, char *key)
  *
  * Details: This function uses the hashed key to determine which bucket the value is in.
  *          Using a custom comparison function to compare two HtEntry's, it searches for
- *          a matching value in the bucket's linked list. 
+ *          a matching value in the bucket's linked list. While the table is being resized the
+ *          key's bucket in the old array is searched first if it has not been migrated yet.
+ *          Lookups never modify the table, so they may run concurrently under a read lock.
  * 
  * @param[in] ht A pointer to a hash table
  * @param[in] key A pointer to a key
@@ -152,15 +202,21 @@ void *Hashtable_get(HashTable *ht, char *key)
  */
 void *Hashtable_get_bin(HashTable *ht, void *key, int key_size)
 {
-    int index = ht->hashf(key, key_size, ht->size);
-
-    LinkedList *list = ht->buckets[index];
-
     HtEntry cmp_entry;
     cmp_entry.key = key;
     cmp_entry.key_size = key_size;
 
-    HtEntry *val_entry = llist_find(list, &cmp_entry, Hashtable_cmpfn);
+    HtEntry *val_entry = NULL;
+    LinkedList *list = old_bucket_of(ht, key, key_size);
+
+    if (list != NULL) {
+        val_entry = llist_find(list, &cmp_entry, Hashtable_cmpfn);
+    }
+
+    list = ht->buckets[ht->hashf(key, key_size, ht->size)];
+    if (val_entry == NULL && list != NULL) {
+        val_entry = llist_find(list, &cmp_entry, Hashtable_cmpfn);
+    }
 
     if (val_entry == NULL) {
         return NULL;
@@ -190,7 +246,8 @@ void *Hashtable_delete(HashTable *ht, char *key)
  * Details: Uses the same method as Hashtable_get() to find the HtEntry containing the
  *          desired key. The HtEntry is removed from the linked list and it's memory is
  *          deallocated. note that it does not free the data - just free's the hash table entry.
- *          The hash table's size and load_factor are updated accordingly
+ *          The hash table's size and load_factor are updated accordingly. Like Hashtable_put_bin(),
+ *          it migrates a few old buckets first while the table is being resized.
  * 
  * @param[in, out] ht A pointer to a hash table
  * @param[in] key A pointer to a key
@@ -199,15 +256,25 @@ void *Hashtable_delete(HashTable *ht, char *key)
  */
 void *Hashtable_delete_bin(HashTable *ht, void *key, int key_size)
 {
-    int index = ht->hashf(key, key_size, ht->size);
-
-    LinkedList *list = ht->buckets[index];
+    if (ht->old_buckets != NULL) {
+        rehash_step(ht, REHASH_STEP);
+    }
 
     HtEntry cmp_entry;  //making this a pointer and mallocing fixes double free
     cmp_entry.key = key;
     cmp_entry.key_size = key_size;
 
-    HtEntry *del_entry = llist_delete(list, &cmp_entry, Hashtable_cmpfn);
+    HtEntry *del_entry = NULL;
+    LinkedList *list = old_bucket_of(ht, key, key_size);
+
+    if (list != NULL) {
+        del_entry = llist_delete(list, &cmp_entry, Hashtable_cmpfn);
+    }
+
+    list = ht->buckets[ht->hashf(key, key_size, ht->size)];
+    if (del_entry == NULL && list != NULL) {
+        del_entry = llist_delete(list, &cmp_entry, Hashtable_cmpfn);
+    }
     
 	if (del_entry == NULL) {
 		return NULL;
@@ -215,8 +282,7 @@ void *Hashtable_delete_bin(HashTable *ht, void *key, int key_size)
 
 	void *data = del_entry->data;
 
-    // free_htentry(del_entry, NULL);
-    free(del_entry);
+    free_htentry(del_entry, NULL);
     
     Hashtable_update(ht, -1);
 
@@ -226,7 +292,8 @@ void *Hashtable_delete_bin(HashTable *ht, void *key, int key_size)
 /**
  * @brief Frees a hash table entry
  *
- * Deatils: This function frees only a hash table entry, not the key and data inside of it.
+ * Deatils: This function frees a hash table entry and the copy of the key made by Hashtable_put_bin(),
+ *          not the data inside of it.
  * 
  * @param[in] htent The hash table entry to be freed
  * @param[in] arg An argument that is not used in this function
@@ -234,6 +301,7 @@ void *Hashtable_delete_bin(HashTable *ht, void *key, int key_size)
 void free_htentry(void *htent, void *arg)
 {
     (void)arg;
+    free(((HtEntry *)htent)->key);
 	free(htent);
 }
 
@@ -272,11 +340,142 @@ extern int Hashtable_cmpfn(void *a, void *b)
 void Hashtable_update(HashTable *ht, int d)
 {
     ht->num_entries += d;
-    ht->load_factor = (float)(ht->num_entries / ht->size);
+    ht->load_factor = (float)ht->num_entries / ht->size;
+}
+
+/* ----------{ Resizing }---------- */
+
+/**
+ * @brief Finds the bucket of a key in the old array of a table that is being resized
+ *
+ * @return The bucket's list, or NULL if no resize is in progress, the bucket has already been migrated or is empty
+ */
+static LinkedList *old_bucket_of(HashTable *ht, void *key, int key_size)
+{
+    if (ht->old_buckets == NULL) {
+        return NULL;
+    }
+
+    int index = ht->hashf(key, key_size, ht->old_size);
+    return index >= ht->rehash_index ? ht->old_buckets[index] : NULL;
+}
+
+/**
+ * @brief Starts resizing a table to a new number of buckets
+ *
+ * Details: Only the new (empty) bucket array is allocated here; the entries are moved over a few buckets at a
+ *          time by rehash_step(). If the array cannot be allocated the table simply keeps its size.
+ *
+ * @param[in, out] ht The hash table
+ * @param[in] size The new number of buckets
+ */
+static void rehash_start(HashTable *ht, int size)
+{
+    LinkedList **buckets = calloc(size, sizeof(LinkedList *));
+    if (buckets == NULL) {
+        return;
+    }
+
+    ht->old_buckets = ht->buckets;
+    ht->old_size = ht->size;
+    ht->rehash_index = 0;
+    ht->buckets = buckets;
+    ht->size = size;
+    ht->load_factor = (float)ht->num_entries / ht->size;
+}
+
+/**
+ * @brief Migrates up to steps non-empty buckets from the old array to the new one
+ *
+ * Details: The nodes are relinked rather than copied, so no memory is allocated except for the list of a new
+ *          bucket. At most REHASH_EMPTY_VISITS empty buckets are skipped per step, so a step takes a bounded time
+ *          even in a sparse table. When the last old bucket has been migrated the old array is freed.
+ *
+ * @param[in, out] ht The hash table
+ * @param[in] steps The number of non-empty buckets to migrate
+ */
+static void rehash_step(HashTable *ht, int steps)
+{
+    int empty_visits = steps * REHASH_EMPTY_VISITS;
+
+    while (steps > 0 && ht->rehash_index < ht->old_size)
+    {
+        LinkedList *old = ht->old_buckets[ht->rehash_index];
+
+        if (old == NULL || old->head == NULL) {
+            ht->rehash_index++;
+            if (old != NULL) {
+                llist_destroy(old);
+            }
+            if (--empty_visits == 0) {
+                break;
+            }
+            continue;
+        }
+
+        /* move the head node to the end of its new bucket, keeping the order of entries within a bucket */
+        Node *node = old->head;
+        HtEntry *entry = node->data;
+        int index = ht->hashf(entry->key, entry->key_size, ht->size);
+
+        if (ht->buckets[index] == NULL && (ht->buckets[index] = llist_create()) == NULL) {
+            return;     // try again on the next operation
+        }
+
+        LinkedList *list = ht->buckets[index];
+        old->head = node->next;
+        old->length--;
+        node->next = NULL;
+        entry->hashed_key = index;
+
+        if (list->head == NULL) {
+            list->head = node;
+        }
+        else {
+            Node *tail = list->head;
+            while (tail->next != NULL) {
+                tail = tail->next;
+            }
+            tail->next = node;
+        }
+        list->length++;
+
+        if (old->head == NULL) {
+            ht->old_buckets[ht->rehash_index++] = NULL;
+            llist_destroy(old);
+            steps--;
+        }
+    }
+
+    if (ht->rehash_index == ht->old_size) {
+        free(ht->old_buckets);
+        ht->old_buckets = NULL;
+        ht->old_size = 0;
+        ht->rehash_index = 0;
+    }
+}
+
+/**
+ * @brief Hashes a key into an index in the buckets array (the default hash function)
+ *
+ * Details: The key is hashed with hash_bytes() and the low bits of the hash pick the bucket, so table_size must be
+ *          a power of two (Hashtable_create() and the resizes keep it one).
+ *
+ * @param[in] key The key to be hashed
+ * @param[in] data_size The size of the key
+ * @param[in] table_size The size of the hash table (a power of two)
+ * @return The hashed key
+ */
+int seeded_hashf(void *key, int data_size, int table_size)
+{
+    return (int)(hash_bytes(key, data_size) & (uint64_t)(table_size - 1));
 }
 
 /**
  * @brief Hashes a string key into an index in the buckets array.
+ *
+ * Details: The original hash function, kept for tables that ask for it. It takes a modulo per byte and has no
+ *          seed, so it is slow for long keys and its collisions are easy to predict.
  * 
  * @param[in] key The key to be hashed
  * @param[in] data_size The size of the key
@@ -314,13 +513,16 @@ int str_hashf(void *key, int data_size, int table_size)
  */
 void Hashtable_display(HashTable *ht, void (*printfn)(void *))
 {
+    while (ht->old_buckets != NULL) {   // finish a resize in progress so that every entry is shown
+        rehash_step(ht, ht->old_size);
+    }
+
     for(int i = 0; i < ht->size; i++)
     {
         /* modified version of llist_print(ht->buckets[i], typefn); */
         LinkedList *list = ht->buckets[i];
-        Node *curr_node = list->head;
 
-        if(list->length == 0)
+        if(list == NULL || list->length == 0)
         {
             printf("+---+        ");
             printf("\n");
@@ -338,6 +540,8 @@ void Hashtable_display(HashTable *ht, void (*printfn)(void *))
         }
         printf("\n");
 
+        Node *curr_node = list->head;
+
         while (curr_node != NULL) {
             HtEntry *entry = (HtEntry *)curr_node->data;
             printfn(entry->data);
@@ -9,13 +9,22 @@
  * A hash table in this library is generic, meaning you can make a hash table
  * that uses any data type as a key and that can store any data type. Chaining 
  * is used for collision resolution via the linked list library.
+ * By default keys are hashed with hash_bytes() (see hash.h), a fast 64-bit hash with a random
+ * per-process seed, and the number of buckets is always a power of two so that the bucket is
+ * picked by masking the hash rather than by a division.
+ * The table grows by DEFAULT_GROW_FACTOR when its load factor exceeds MAX_LOAD_FACTOR. The entries
+ * are not moved all at once: the new bucket array is allocated empty, and every insert and delete
+ * then migrates REHASH_STEP buckets of the old array, so no single operation pays for the whole
+ * resize. Until the migration is done, lookups search the key's old bucket and then its new one.
+ * Lookups never modify the table, so several threads may look up concurrently (e.g. under a read
+ * lock) as long as no thread inserts or deletes at the same time.
  * 
  * Assumptions/Limitations:
  * This implementation assumes that the key and data stored in each hash table entry has been
  * properly allocated and that the user is responsible for managing this memory. 
  * Since the key and data fields of an entry can contain anything, 
  * when we delete an entry from the hash table using the entry's key, 
- * we only free the entry itself. We assume that freeing the data
+ * we only free the entry itself and the copy of the key it holds. We assume that freeing the data
  * will be done by the caller at the appropraite time before the program executes.
  * 
  * @date 2023-12-1
@@ -26,10 +35,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include "linkedlist.h"
+#include "hash.h"
 
 #define DEFAULT_SIZE 16 // 128
 #define DEFAULT_GROW_FACTOR 2
+#define MAX_LOAD_FACTOR 1.0f        /* entries per bucket above which the table starts to grow */
+#define REHASH_STEP 2               /* old buckets migrated by every insert or delete while the table grows */
+#define REHASH_EMPTY_VISITS 16      /* empty old buckets a migration step may skip per bucket it migrates */
 
 /* ----------{ STRUCTURES AND TYPES }---------- */
 
@@ -41,11 +55,14 @@ typedef struct {
 } HtEntry;  /* Each node in a bucket contains a HtEntry */
 
 typedef struct {
-    LinkedList **buckets;
+    LinkedList **buckets;           /* a NULL bucket is empty */
     int size;
     int num_entries;
     float load_factor;
     int (*hashf)(void *data, int data_size, int bucket_count);
+    LinkedList **old_buckets;       /* buckets being migrated while the table grows (NULL otherwise) */
+    int old_size;
+    int rehash_index;               /* old buckets below this index have been migrated */
 } HashTable;
 
 /* ----------{ FUNCTION PROTOTYPES }---------- */
@@ -54,7 +71,8 @@ extern HashTable *Hashtable_create(int size, int (*hashf)(void *, int, int));
 extern void Hashtable_destroy(HashTable *ht);
 
 /* ----------{ Hash functions }---------- */
-extern int str_hashf(void *key, int data_size, int table_size);     /* default hash function */
+extern int seeded_hashf(void *key, int data_size, int table_size);  /* default hash function */
+extern int str_hashf(void *key, int data_size, int table_size);
 
 /* ----------{ Insert methods }---------- */
 extern void *Hashtable_put(HashTable *ht, char *key, void *data);   //Hashtable_put_str
@@ -6,91 +6,175 @@
  */
 #include "mime.h"
 
-HashTable *ext_to_mime;
+SwissTable *ext_to_mime;         /* extensions loaded from MIME_TYPES_FILE (read-only once created) */
+static char *mime_types_data;   /* contents of MIME_TYPES_FILE; the values of ext_to_mime point into it */
 
 /**
- * @brief converts all uppercase characters in a string to lowercase
- * 
- * @param[in] str The string being converted
+ * @brief Looks up an extension in the built-in table
+ *
+ * Details: Only stores some basic conversions that we use for this server. Switching on the length first
+ *          means at most a few short comparisons per lookup.
+ *
+ * @param[in] ext A lowercase file extension
+ * @param[in] len The length of the extension
+ * @return The MIME type, or NULL if the extension is not in the table
  */
-void strlower(char *str)
+static const char *builtin_mime_type(const char *ext, size_t len)
 {
-    for (char *c = str; *c != '\0'; c++) {
-        *c = (char)tolower((unsigned char)*c);
+#define EXT(str, type) if (memcmp(ext, str, len) == 0) return type
+
+    switch (len)
+    {
+    case 2:
+        EXT("js", "application/javascript");
+        break;
+    case 3:
+        EXT("htm", "text/html");
+        EXT("jpg", "image/jpg");
+        EXT("css", "text/css");
+        EXT("txt", "text/plain");
+        EXT("gif", "image/gif");
+        EXT("png", "image/png");
+        EXT("ico", "image/x-icon");
+        EXT("svg", "image/svg+xml");
+        EXT("mjs", "application/javascript");
+        EXT("xml", "application/xml");
+        EXT("pdf", "application/pdf");
+        break;
+    case 4:
+        EXT("html", "text/html");
+        EXT("jpeg", "image/jpg");
+        EXT("json", "application/json");
+        EXT("webp", "image/webp");
+        EXT("wasm", "application/wasm");
+        EXT("woff", "font/woff");
+        break;
+    case 5:
+        EXT("woff2", "font/woff2");
+        break;
     }
+
+#undef EXT
+    return NULL;
 }
 
 /**
- * @brief creates a new hash table containing a list of file extension to MIME type
- *        mappings
+ * @brief Loads the extension to MIME type mappings of MIME_TYPES_FILE
+ *
+ * Details: Each line of the file is a MIME type followed by its extensions. The file is read into memory once
+ *          and split in place, so the hash table's values point into that buffer.
+ */
+static void load_mime_types()
+{
+    FILE *fp = fopen(MIME_TYPES_FILE, "r");
+    if (fp == NULL)
+        return; // loading the system's types is optional
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    mime_types_data = size > 0 ? malloc(size + 1) : NULL;
+    if (mime_types_data == NULL || fread(mime_types_data, 1, size, fp) != (size_t)size)
+    {
+        fclose(fp);
+        free(mime_types_data);
+        mime_types_data = NULL;
+        return;
+    }
+    fclose(fp);
+    mime_types_data[size] = '\0';
+
+    ext_to_mime = Swisstable_create(HT_SIZE);
+    if (ext_to_mime == NULL)
+        return;
+
+    for (char *line = mime_types_data, *next; line != NULL; line = next)
+    {
+        next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+
+        char *save;
+        char *type = strtok_r(line, " \t\r", &save);
+        if (type == NULL || type[0] == '#')
+            continue;
+
+        for (char *ext = strtok_r(NULL, " \t\r", &save); ext != NULL; ext = strtok_r(NULL, " \t\r", &save))
+        {
+            for (char *c = ext; *c != '\0'; c++)
+                *c = (char)tolower((unsigned char)*c);
+
+            if (Swisstable_get(ext_to_mime, ext) == NULL) // the first mapping of an extension wins
+                Swisstable_put(ext_to_mime, ext, type);
+        }
+    }
+
+    printf("Server: loaded %d MIME types from %s\n", ext_to_mime->num_entries, MIME_TYPES_FILE);
+}
+
+/**
+ * @brief Sets up the MIME type database
  * 
- * Details: Only stores some basic conversions that we use for this server. 
- *          There's no way to know every MIME type and file extension in existence
- *          and many aren't even supported by browsers like Google Chrome.
+ * Details: The built-in table needs no setup; this only loads MIME_TYPES_FILE if it exists.
+ *          Must be called before the server starts accepting connections.
  */
 void create_mime_db()
 {
-    ext_to_mime = Hashtable_create(HT_SIZE, NULL);
-    
-    /* key = file extension, value = mime type */
-    Hashtable_put(ext_to_mime, "html", "text/html");
-    Hashtable_put(ext_to_mime, "htm", "text/html");
-    Hashtable_put(ext_to_mime, "jpeg", "image/jpg");
-    Hashtable_put(ext_to_mime, "jpg", "image/jpg");
-    Hashtable_put(ext_to_mime, "css", "text/css");
-    Hashtable_put(ext_to_mime, "js", "application/javascript");
-    Hashtable_put(ext_to_mime, "json", "application/json");
-    Hashtable_put(ext_to_mime, "txt", "text/plain");
-    Hashtable_put(ext_to_mime, "gif", "image/gif");
-    Hashtable_put(ext_to_mime, "png", "image/png");
-    Hashtable_put(ext_to_mime, "ico", "image/x-icon");
+    load_mime_types();
 }
 
 /**
- * @brief destroys the file extension to MIME type hash table
+ * @brief Destroys the MIME type database
  */
 void destroy_mime_db()
 {
-    Hashtable_destroy(ext_to_mime);   // do before server terminates
+    if (ext_to_mime != NULL)
+        Swisstable_destroy(ext_to_mime);   // do before server terminates
+
+    free(mime_types_data);
+    ext_to_mime = NULL;
+    mime_types_data = NULL;
 }
 
 /**
  * @brief Return a MIME type for a given filename
  * 
- * Details: Uses the ext_to_mime hash table since retrieval in a hash table is O(1)
+ * Details: Uses the built-in table first and then the types loaded from MIME_TYPES_FILE. The extension is
+ *          compared case-insensitively without modifying the filename.
  * 
  *          Previously done like this (O(n) time complexity):
  *          if (strcmp(ext, "html") == 0 || strcmp(ext, "htm") == 0) { return "text/html"; }
  *          if (strcmp(ext, "jpeg") == 0 || strcmp(ext, "jpg") == 0) { return "image/jpg"; }
- *          if (strcmp(ext, "css") == 0) { return "text/css"; }
- *          if (strcmp(ext, "js") == 0) { return "application/javascript"; }
- *          if (strcmp(ext, "json") == 0) { return "application/json"; }
- *          if (strcmp(ext, "txt") == 0) { return "text/plain"; }
- *          if (strcmp(ext, "gif") == 0) { return "image/gif"; }
- *          if (strcmp(ext, "png") == 0) { return "image/png"; }
+ *          ...
  * 
- * @param[in] filename A string storing the name of a file
+ * @param[in] filename A string storing the name (or path) of a file
  * @return A string storing the MIME type of the file
  */
-char *get_mime_type(char *filename)
+const char *get_mime_type(const char *filename)
 {
-    char *ext = strrchr(filename, '.');
+    const char *dot = strrchr(filename, '.');
+    char ext[MAX_EXT_SIZE];
+    size_t len = 0;
 
-    if (ext == NULL) {
+    if (dot == NULL) {
         return DEFAULT_MIME_TYPE;
     }
-    
-    ext++;
-    strlower(ext);
 
-    printf("The File extension of '%s' is '%s'\n", filename, ext);
-    
-    create_mime_db();
-    char *mime = Hashtable_get(ext_to_mime, ext);
-    destroy_mime_db(); 
+    for (const char *c = dot + 1; *c != '\0'; c++) {
+        if (*c == '/' || len == sizeof(ext) - 1) {  // the dot is in a directory name, or the extension is too long
+            return DEFAULT_MIME_TYPE;
+        }
+        ext[len++] = (char)tolower((unsigned char)*c);
+    }
+    ext[len] = '\0';
+
+    const char *mime = builtin_mime_type(ext, len);
+    if (mime == NULL && ext_to_mime != NULL)
+        mime = Swisstable_get(ext_to_mime, ext);
 
     if(mime == NULL)
         return DEFAULT_MIME_TYPE;
 
     return mime;
-}
\ No newline at end of file
+}
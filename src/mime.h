@@ -4,17 +4,21 @@
  * @authors Jayden Mingle
  * 
  * Details:
- * Before the server starts accepting connections, a hash table is set up that
- * holds the necessary file extension -> MIME type conversions needed by a client
- * like Google Chrome. If an unknown file extension is given to this
- * hash table, it defaults the mime type to "application/octet-stream". This MIME type
- * is generic and can be used for any binary file. It preserves the file's
+ * The MIME types the server itself relies on are compiled into a static table: the extension
+ * is lowercased into a small local buffer and looked up with a switch on its length followed by
+ * a handful of comparisons, so a lookup never allocates and never takes a lock.
+ * Before the server starts accepting connections, create_mime_db() can additionally load the
+ * system's /etc/mime.types into a SwissTable (see swisstable.h), where a lookup of a short
+ * extension touches one group of control bytes and one slot. That table is never modified afterwards, so any
+ * thread can read it without locking. Built-in types take precedence over loaded ones.
+ * If an unknown file extension is given, the mime type defaults to "application/octet-stream".
+ * This MIME type is generic and can be used for any binary file. It preserves the file's
  * contents without making assumptions about its type.
  * 
  * Assumptions/Limitations:
- * Doesn't support every single MIME type (only the common types that we're likely
- * to encounter while running the server). Operates on a filename string that we assume
- * has been allocated by the caller and will be freed by the caller as well.
+ * Extensions longer than MAX_EXT_SIZE - 1 characters are treated as unknown. The filename is
+ * never modified. create_mime_db() and destroy_mime_db() must not run while other threads look
+ * up MIME types.
  * 
  * @date 2023-12-2
  */
@@ -22,19 +26,22 @@
 #define _MIME_H_
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include "hashtable.h"
+#include "swisstable.h"
 
-#define HT_SIZE 16
+#define HT_SIZE 1024
+#define MAX_EXT_SIZE 16
+#define MIME_TYPES_FILE "/etc/mime.types"
 #define DEFAULT_MIME_TYPE "application/octet-stream"
 
-extern HashTable *ext_to_mime;
+extern SwissTable *ext_to_mime;
 
 /* ----------{ FUNCTION PROTOTYPES }---------- */
 
 extern void create_mime_db();
 extern void destroy_mime_db();
-extern char *get_mime_type(char *filename);
+extern const char *get_mime_type(const char *filename);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file mpmc.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "mpmc.h"
+
+/**
+ * @brief Creates an empty queue
+ *
+ * @param[in] capacity The minimum number of items the queue can hold (rounded up to a power of two)
+ * @return The new queue, or NULL if it could not be allocated
+ */
+Mpmc_queue *mpmc_create(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    Mpmc_queue *queue = aligned_alloc(CACHE_LINE_SIZE, sizeof(Mpmc_queue));
+    if (queue == NULL)
+        return NULL;
+
+    queue->cells = aligned_alloc(CACHE_LINE_SIZE, size * sizeof(Mpmc_cell));
+    if (queue->cells == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        queue->cells[i].seq = i;
+        queue->cells[i].data = NULL;
+    }
+    queue->mask = size - 1;
+    queue->head = 0;
+    queue->tail = 0;
+
+    return queue;
+}
+
+/**
+ * @brief Frees a queue (items still in it are not freed)
+ */
+void mpmc_destroy(Mpmc_queue *queue)
+{
+    if (queue == NULL)
+        return;
+
+    free(queue->cells);
+    free(queue);
+}
+
+/**
+ * @brief Adds an item to the queue
+ *
+ * @param[in] queue The queue
+ * @param[in] data The item (must not be NULL)
+ * @return 1 if the item was queued, 0 if the queue is full
+ */
+int mpmc_enqueue(Mpmc_queue *queue, void *data)
+{
+    size_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    Mpmc_cell *cell;
+
+    for (;;)
+    {
+        cell = &queue->cells[pos & queue->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)seq - (long)pos;
+
+        if (diff == 0)
+        {
+            /* the cell is free: claim it by moving the enqueue position past it */
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+            return 0;   // the cell still holds the item queued one lap ago
+        else
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    }
+
+    cell->data = data;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/**
+ * @brief Removes the oldest item from the queue
+ *
+ * @param[in] queue The queue
+ * @return The item, or NULL if the queue is empty
+ */
+void *mpmc_dequeue(Mpmc_queue *queue)
+{
+    size_t pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    Mpmc_cell *cell;
+
+    for (;;)
+    {
+        cell = &queue->cells[pos & queue->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)seq - (long)(pos + 1);
+
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+            return NULL;    // nothing has been published in this cell yet
+        else
+            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    }
+
+    void *data = cell->data;
+    /* hand the cell to the producer that reaches it on the next lap */
+    __atomic_store_n(&cell->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+    return data;
+}
+
+/**
+ * @brief Checks whether the queue looks empty (may be out of date as soon as it returns)
+ */
+int mpmc_empty(Mpmc_queue *queue)
+{
+    return __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+}
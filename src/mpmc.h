@@ -0,0 +1,54 @@
+/**
+ * @file mpmc.h
+ * @brief A bounded lock-free multi-producer/multi-consumer queue
+ * @authors
+ *
+ * Details:
+ * - The queue is a ring of 2^n cells (Dmitry Vyukov's bounded MPMC queue). Every cell holds a sequence number
+ *   next to its data: a producer claims the cell at the enqueue position with a compare-and-swap and publishes
+ *   the data by advancing the cell's sequence number, and a consumer does the same at the dequeue position. No
+ *   operation takes a lock or allocates memory.
+ * - The enqueue and dequeue positions live on separate cache lines, so producers and consumers do not invalidate
+ *   each other's position on every operation.
+ *
+ * Assumptions/Limitations:
+ * - The capacity is fixed when the queue is created (rounded up to a power of two). mpmc_enqueue() fails
+ *   instead of blocking when the queue is full; the caller decides what to do with the item.
+ * - The queue never blocks: waiting for an item is up to the caller (see the thread pool's parking in pool.c).
+ * - NULL cannot be queued, since mpmc_dequeue() returns NULL when the queue is empty.
+ *
+ * @date 2026-10-17
+ */
+#ifndef MPMC_H
+#define MPMC_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct {
+    size_t seq;                     /* position this cell is ready for (enqueue if == pos, dequeue if == pos + 1) */
+    void *data;
+} Mpmc_cell;
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) size_t head;      /* next position to enqueue at (written by producers) */
+    _Alignas(CACHE_LINE_SIZE) size_t tail;      /* next position to dequeue from (written by consumers) */
+    _Alignas(CACHE_LINE_SIZE) size_t mask;      /* capacity - 1 */
+    Mpmc_cell *cells;
+} Mpmc_queue;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern Mpmc_queue *mpmc_create(size_t capacity);
+extern void mpmc_destroy(Mpmc_queue *queue);
+extern int mpmc_enqueue(Mpmc_queue *queue, void *data);
+extern void *mpmc_dequeue(Mpmc_queue *queue);
+extern int mpmc_empty(Mpmc_queue *queue);
+
+#endif
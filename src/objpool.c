@@ -0,0 +1,213 @@
+/**
+ * @file objpool.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "objpool.h"
+
+typedef struct {
+    Objpool *pool;                  /* pool the cached objects belong to (NULL if the slot is unused) */
+    Obj_free *head;
+    int count;
+} Obj_cache;
+
+static __thread Obj_cache thread_caches[OBJPOOL_MAX_CACHES];
+static pthread_key_t cache_key;     /* only used to return a thread's caches when it exits */
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+/* ----------< Depot >---------- */
+
+/**
+ * @brief Moves up to count objects from the depot into a thread cache
+ *
+ * @return The number of objects moved
+ */
+static int depot_take(Objpool *pool, Obj_cache *cache, int count)
+{
+    int taken = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (taken < count && pool->depot != NULL)
+    {
+        Obj_free *obj = pool->depot;
+        pool->depot = obj->next;
+        obj->next = cache->head;
+        cache->head = obj;
+        taken++;
+    }
+    pool->depot_count -= taken;
+    pthread_mutex_unlock(&pool->lock);
+
+    cache->count += taken;
+    return taken;
+}
+
+/**
+ * @brief Moves count objects from a thread cache into the depot, freeing those that do not fit
+ */
+static void depot_put(Objpool *pool, Obj_cache *cache, int count)
+{
+    Obj_free *release = NULL;
+    unsigned long released = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (int i = 0; i < count && cache->head != NULL; i++)
+    {
+        Obj_free *obj = cache->head;
+        cache->head = obj->next;
+        cache->count--;
+
+        if (pool->depot_count < pool->max_free)
+        {
+            obj->next = pool->depot;
+            pool->depot = obj;
+            pool->depot_count++;
+        }
+        else
+        {
+            obj->next = release;
+            release = obj;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    while (release != NULL)     // free() outside of the lock
+    {
+        Obj_free *next = release->next;
+        free(release);
+        release = next;
+        released++;
+    }
+    if (released > 0)
+        __atomic_add_fetch(&pool->stats.releases, released, __ATOMIC_RELAXED);
+}
+
+/* ----------< Thread caches >---------- */
+
+/**
+ * @brief Returns every object cached by an exiting thread to its pool's depot
+ */
+static void flush_thread_caches(void *arg)
+{
+    (void)arg;
+
+    for (int i = 0; i < OBJPOOL_MAX_CACHES; i++)
+    {
+        Obj_cache *cache = &thread_caches[i];
+        if (cache->pool != NULL)
+            depot_put(cache->pool, cache, cache->count);
+        cache->pool = NULL;
+    }
+}
+
+static void create_cache_key()
+{
+    pthread_key_create(&cache_key, flush_thread_caches);
+}
+
+/**
+ * @brief Finds (or sets up) the calling thread's cache for a pool
+ *
+ * @return The cache, or NULL if the thread already caches OBJPOOL_MAX_CACHES other pools
+ */
+static Obj_cache *get_cache(Objpool *pool)
+{
+    for (int i = 0; i < OBJPOOL_MAX_CACHES; i++)
+    {
+        Obj_cache *cache = &thread_caches[i];
+        if (cache->pool == pool)
+            return cache;
+
+        if (cache->pool == NULL)
+        {
+            /* first use of a pool on this thread: make sure the cache is returned when the thread exits */
+            pthread_once(&cache_key_once, create_cache_key);
+            pthread_setspecific(cache_key, thread_caches);
+            cache->pool = pool;
+            return cache;
+        }
+    }
+
+    return NULL;
+}
+
+/* ----------< Objpool >---------- */
+
+/**
+ * @brief Allocates an object from a pool
+ *
+ * Details: Takes an object from the thread's cache, refilling the cache from the depot if it is empty. Only
+ *          when the depot is empty as well is the object allocated with malloc().
+ *
+ * @param[in] pool The pool
+ * @return The object (its contents are undefined), or NULL if it could not be allocated
+ */
+void *objpool_alloc(Objpool *pool)
+{
+    Obj_cache *cache = get_cache(pool);
+    Obj_cache single = {pool, NULL, 0};
+    Obj_free *obj;
+
+    if (cache == NULL)
+        cache = &single;    // no cache slot left: take a single object from the depot
+
+    if (cache->head == NULL && depot_take(pool, cache, cache == &single ? 1 : pool->batch) == 0)
+    {
+        obj = malloc(pool->obj_size);
+        if (obj == NULL)
+            return NULL;
+        __atomic_add_fetch(&pool->stats.mallocs, 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        obj = cache->head;
+        cache->head = obj->next;
+        cache->count--;
+    }
+
+    __atomic_add_fetch(&pool->stats.allocs, 1, __ATOMIC_RELAXED);
+    return obj;
+}
+
+/**
+ * @brief Returns an object to a pool
+ *
+ * @param[in] pool The pool the object was allocated from
+ * @param[in] obj The object (may be NULL)
+ */
+void objpool_free(Objpool *pool, void *obj)
+{
+    if (obj == NULL)
+        return;
+
+    Obj_cache *cache = get_cache(pool);
+    Obj_cache single = {pool, NULL, 0};
+
+    if (cache == NULL)
+        cache = &single;
+
+    ((Obj_free *)obj)->next = cache->head;
+    cache->head = obj;
+    cache->count++;
+    __atomic_add_fetch(&pool->stats.frees, 1, __ATOMIC_RELAXED);
+
+    if (cache == &single)
+        depot_put(pool, cache, 1);
+    else if (cache->count >= 2 * pool->batch)
+        depot_put(pool, cache, pool->batch);
+}
+
+/**
+ * @brief Copies a pool's counters
+ *
+ * @param[in] pool The pool
+ * @param[out] stats The counters
+ */
+void objpool_get_stats(Objpool *pool, Objpool_stats *stats)
+{
+    stats->allocs = __atomic_load_n(&pool->stats.allocs, __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&pool->stats.frees, __ATOMIC_RELAXED);
+    stats->mallocs = __atomic_load_n(&pool->stats.mallocs, __ATOMIC_RELAXED);
+    stats->releases = __atomic_load_n(&pool->stats.releases, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file objpool.h
+ * @brief Freelists for small fixed-size objects that are allocated and freed at a high rate
+ * @authors
+ *
+ * Details:
+ * - An Objpool hands out objects of one size. Freed objects are kept and handed out again instead of going back
+ *   to malloc(), so steady traffic (one connection, task or queue node per request) does not call malloc() or
+ *   free() at all.
+ * - Every thread keeps a small cache of free objects per pool, so allocating and freeing normally takes no lock.
+ *   A thread whose cache is empty takes a batch of objects from the pool's shared depot, and a thread whose cache
+ *   holds two batches returns one. This keeps objects flowing when they are allocated on one thread (e.g. the
+ *   reactor) and freed on another (a worker). When a thread exits its cache is returned to the depot.
+ * - The depot keeps at most max_free objects; objects beyond that are given back to free().
+ * - Each pool counts its allocations, frees and how many objects had to come from malloc(), so a steady state
+ *   can be verified (see objpool_get_stats()).
+ *
+ * Assumptions/Limitations:
+ * - Pools are meant to be global and live as long as the program (they are defined with OBJPOOL_INITIALIZER and
+ *   never destroyed). Objects are individually allocated with malloc(), and an object must be at least as large
+ *   as a pointer.
+ * - A thread caches objects of at most OBJPOOL_MAX_CACHES different pools; further pools go straight to the depot.
+ *
+ * @date 2026-10-17
+ */
+#ifndef OBJPOOL_H
+#define OBJPOOL_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define OBJPOOL_MAX_CACHES 8        /* pools a single thread keeps a cache for */
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Obj_free {
+    struct Obj_free *next;
+} Obj_free;
+
+typedef struct {
+    unsigned long allocs;           /* objects handed out */
+    unsigned long frees;            /* objects returned */
+    unsigned long mallocs;          /* objects that had to be allocated with malloc() */
+    unsigned long releases;         /* objects given back to free() because the depot was full */
+} Objpool_stats;
+
+typedef struct Objpool {
+    size_t obj_size;
+    int batch;                      /* objects moved between a thread cache and the depot at a time */
+    int max_free;                   /* most objects the depot keeps */
+    pthread_mutex_t lock;           /* protects the depot */
+    Obj_free *depot;                /* free objects not in any thread's cache */
+    int depot_count;
+    Objpool_stats stats;            /* updated atomically */
+} Objpool;
+
+#define OBJPOOL_INITIALIZER(size, batch_size, max_free_objs) \
+    { (size) < sizeof(Obj_free) ? sizeof(Obj_free) : (size), (batch_size), (max_free_objs), \
+      PTHREAD_MUTEX_INITIALIZER, NULL, 0, {0, 0, 0, 0} }
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void *objpool_alloc(Objpool *pool);
+extern void objpool_free(Objpool *pool, void *obj);
+extern void objpool_get_stats(Objpool *pool, Objpool_stats *stats);
+
+#endif
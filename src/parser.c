@@ -0,0 +1,325 @@
+/**
+ * @file parser.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "parser.h"
+#include "scan.h"
+
+/* characters allowed in a token (RFC 9110 section 5.6.2), used for methods and header names */
+static const unsigned char tchar[256] = {
+    ['0' ... '9'] = 1, ['a' ... 'z'] = 1, ['A' ... 'Z'] = 1,
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1,
+    ['+'] = 1, ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+};
+
+/**
+ * @brief Builds a view of the bytes between two offsets
+ *
+ * @param[in] start The offset of the first byte
+ * @param[in] end The offset one past the last byte
+ * @return The view
+ */
+static inline Http_view make_view(size_t start, size_t end)
+{
+    Http_view view = {(unsigned int)start, (unsigned int)(end - start)};
+    return view;
+}
+
+/**
+ * @brief Parses the value of a Content-Length header
+ *
+ * @param[in] buf The receive buffer
+ * @param[in] value The view of the header value
+ * @return The content length, or -1 if the value is not a valid length of at most MAX_REQUEST_BODY_SIZE
+ */
+static long parse_content_length(const char *buf, Http_view value)
+{
+    const char *digits = VIEW_PTR(buf, value);
+    long length = 0;
+
+    if (value.len == 0)
+        return -1;
+
+    for (unsigned int i = 0; i < value.len; i++)
+    {
+        if (digits[i] < '0' || digits[i] > '9')
+            return -1;
+
+        length = length * 10 + (digits[i] - '0');
+        if (length > MAX_REQUEST_BODY_SIZE)
+            return -1;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Records a header and picks out the headers the server cares about
+ *
+ * @param[in, out] parser The parser
+ * @param[in] buf The receive buffer
+ * @param[in] name The view of the header name
+ * @param[in] value The view of the header value (without surrounding whitespace)
+ * @return 0 if the header was accepted, -1 if it makes the request invalid
+ */
+static int on_header(Http_parser *parser, const char *buf, Http_view name, Http_view value)
+{
+    Http_header_view *header = &parser->headers[parser->num_headers++];
+    header->name = name;
+    header->value = value;
+
+    if (VIEW_CASE_EQ(buf, name, "Host"))
+    {
+        parser->host = value;
+    }
+    else if (VIEW_CASE_EQ(buf, name, "Connection"))
+    {
+        parser->connection = value;
+    }
+    else if (VIEW_CASE_EQ(buf, name, "Content-Length"))
+    {
+        long length = parse_content_length(buf, value);
+
+        // conflicting lengths could be used to smuggle a second request
+        if (length == -1 || (parser->content_length != -1 && parser->content_length != length))
+            return -1;
+
+        parser->content_length = length;
+    }
+    else if (VIEW_CASE_EQ(buf, name, "Transfer-Encoding"))
+    {
+        return -1; // chunked request bodies are not supported
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Resets a parser so that it can parse a new request
+ *
+ * @param[out] parser The parser
+ */
+void http_parser_init(Http_parser *parser)
+{
+    parser->state = PS_METHOD;
+    parser->pos = 0;
+    parser->mark = 0;
+    parser->num_headers = 0;
+    parser->method = parser->path = parser->version = make_view(0, 0);
+    parser->host = parser->connection = make_view(0, 0);
+    parser->content_length = -1;
+    parser->header_len = 0;
+}
+
+/**
+ * @brief Parses as much of a request as has been received
+ *
+ * Details: buf holds every byte of the request received so far (len bytes), starting at the first byte of the
+ *          request. Bytes that were already consumed by an earlier call are not looked at again.
+ *
+ * @param[in, out] parser The parser
+ * @param[in] buf The receive buffer
+ * @param[in] len The number of bytes in the receive buffer
+ * @return PARSE_DONE when the whole request (including its body) has been received, PARSE_AGAIN when more bytes
+ *         are needed, or PARSE_ERROR if the request is malformed
+ */
+parse_status http_parser_execute(Http_parser *parser, const char *buf, size_t len)
+{
+    size_t i = parser->pos;
+    size_t mark = parser->mark;
+    Http_view name = parser->num_headers < MAX_PARSED_HEADERS ? parser->headers[parser->num_headers].name : make_view(0, 0);
+
+    for (; i < len && parser->state != PS_BODY; i++)
+    {
+        unsigned char c = (unsigned char)buf[i];
+
+        switch (parser->state)
+        {
+        case PS_METHOD:
+            if (c == ' ' && i > mark)
+            {
+                parser->method = make_view(mark, i);
+                parser->state = PS_PATH;
+                mark = i + 1;
+            }
+            else if ((c == '\r' || c == '\n') && i == mark)
+            {
+                mark = i + 1; // ignore empty lines before the request line
+            }
+            else if (!tchar[c] || i - mark >= MAX_METHOD_SIZE)
+            {
+                return PARSE_ERROR;
+            }
+            break;
+
+        case PS_PATH:
+            if (c == ' ' && i > mark)
+            {
+                parser->path = make_view(mark, i);
+                parser->state = PS_VERSION;
+                mark = i + 1;
+            }
+            else if (c <= ' ' || c == 0x7f || (i == mark && c != '/') || i - mark >= MAX_REQUEST_PATH_SIZE - 1)
+            {
+                return PARSE_ERROR;
+            }
+            else
+            {
+                // skip to the next byte that ends the path, but no further than the length limit
+                size_t limit = mark + MAX_REQUEST_PATH_SIZE - 1 < len ? mark + MAX_REQUEST_PATH_SIZE - 1 : len;
+                i = scan_path(buf, i + 1, limit) - 1;
+            }
+            break;
+
+        case PS_VERSION:
+            if (c == '\r')
+            {
+                parser->version = make_view(mark, i);
+                if (!VIEW_EQ(buf, parser->version, "HTTP/1.1") && !VIEW_EQ(buf, parser->version, "HTTP/1.0"))
+                    return PARSE_ERROR;
+                parser->state = PS_LINE_LF;
+            }
+            else if (i - mark >= 8)
+            {
+                return PARSE_ERROR;
+            }
+            break;
+
+        case PS_LINE_LF:
+        case PS_HEADER_LF:
+            if (c != '\n')
+                return PARSE_ERROR;
+            parser->state = PS_HEADER_START;
+            break;
+
+        case PS_HEADER_START:
+            if (c == '\r')
+            {
+                parser->state = PS_HEADERS_END_LF;
+            }
+            else if (tchar[c] && parser->num_headers < MAX_PARSED_HEADERS)
+            {
+                mark = i;
+                parser->state = PS_HEADER_NAME;
+            }
+            else
+            {
+                return PARSE_ERROR;
+            }
+            break;
+
+        case PS_HEADER_NAME:
+            if (c == ':')
+            {
+                name = make_view(mark, i);
+                parser->headers[parser->num_headers].name = name;
+                parser->state = PS_HEADER_OWS;
+            }
+            else if (!tchar[c])
+            {
+                return PARSE_ERROR;
+            }
+            else
+            {
+                i = scan_header_name(buf, i + 1, len) - 1;
+            }
+            break;
+
+        case PS_HEADER_OWS:
+            if (c == ' ' || c == '\t')
+                break;
+            mark = i;
+            parser->state = PS_HEADER_VALUE;
+            /* fall through */
+
+        case PS_HEADER_VALUE:
+            if (c == '\r')
+            {
+                size_t end = i;
+                while (end > mark && (buf[end - 1] == ' ' || buf[end - 1] == '\t'))
+                    end--;
+
+                if (on_header(parser, buf, name, make_view(mark, end)) == -1)
+                    return PARSE_ERROR;
+                parser->state = PS_HEADER_LF;
+            }
+            else if ((c < ' ' && c != '\t') || c == 0x7f)
+            {
+                return PARSE_ERROR;
+            }
+            else
+            {
+                i = scan_header_value(buf, i + 1, len) - 1;
+            }
+            break;
+
+        case PS_HEADERS_END_LF:
+            if (c != '\n')
+                return PARSE_ERROR;
+            parser->header_len = i + 1;
+            parser->state = PS_BODY;
+            break;
+
+        case PS_BODY:
+            break;
+        }
+    }
+
+    parser->pos = i;
+    parser->mark = mark;
+
+    if (parser->state != PS_BODY)
+        return PARSE_AGAIN;
+
+    if (parser->content_length > 0 && len - parser->header_len < (size_t)parser->content_length)
+        return PARSE_AGAIN;
+
+    return PARSE_DONE;
+}
+
+/**
+ * @brief Returns the length of a completely parsed request
+ *
+ * @param[in] parser A parser that returned PARSE_DONE
+ * @return The number of bytes of the request, including its body
+ */
+size_t http_parser_request_len(Http_parser *parser)
+{
+    return parser->header_len + (parser->content_length > 0 ? parser->content_length : 0);
+}
+
+/**
+ * @brief Checks whether a comma separated header value (e.g. Connection) contains a token
+ *
+ * @param[in] buf The receive buffer
+ * @param[in] value The view of the header value
+ * @param[in] token The token, compared without regard to case
+ * @return 1 if one of the elements of the list is the token, 0 otherwise
+ */
+int http_header_has_token(const char *buf, Http_view value, const char *token)
+{
+    const char *p = VIEW_PTR(buf, value);
+    const char *end = p + value.len;
+    size_t token_len = strlen(token);
+
+    while (p < end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+            p++;
+
+        const char *start = p;
+        while (p < end && *p != ',')
+            p++;
+
+        const char *stop = p;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t'))
+            stop--;
+
+        if ((size_t)(stop - start) == token_len && strncasecmp(start, token, token_len) == 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file parser.h
+ * @brief An incremental HTTP/1.x request parser
+ * @authors
+ *
+ * Details:
+ * - The parser is a resumable state machine. It is fed the receive buffer every time more bytes arrive and
+ *   continues where it stopped last time, so a request can be split across any number of reads.
+ * - Nothing is copied: the method, path, version and every header name and value are recorded as views
+ *   (offset + length) into the receive buffer.
+ * - Malformed input is rejected as soon as the offending byte is seen: invalid token characters, control
+ *   characters, bare line feeds, oversized request lines, unsupported versions, invalid or oversized
+ *   Content-Length values and chunked transfer coding.
+ * - The request is complete once the blank line after the headers and Content-Length bytes of body have been
+ *   received. Any bytes after that belong to the next request (pipelining): the caller starts a new parse on the
+ *   buffer that follows http_parser_request_len() bytes of the current one.
+ *
+ * Assumptions/Limitations:
+ * - The receive buffer must not move or be modified between calls, since views refer to offsets inside it.
+ * - At most MAX_PARSED_HEADERS headers are accepted. Chunked request bodies are not supported.
+ *
+ * @date 2026-10-17
+ */
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_PARSED_HEADERS 64
+#define MAX_METHOD_SIZE 16
+#define MAX_REQUEST_PATH_SIZE 256       /* same as MAX_PATH_SIZE in server.h, including the terminator */
+#define MAX_REQUEST_BODY_SIZE 1000000   /* same as MAX_BODY_SIZE in server.h */
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef enum {
+    PARSE_DONE,         /* a complete request has been parsed */
+    PARSE_AGAIN,        /* more bytes are needed */
+    PARSE_ERROR         /* the request is malformed */
+} parse_status;
+
+typedef enum {
+    PS_METHOD,
+    PS_PATH,
+    PS_VERSION,
+    PS_LINE_LF,
+    PS_HEADER_START,
+    PS_HEADER_NAME,
+    PS_HEADER_OWS,
+    PS_HEADER_VALUE,
+    PS_HEADER_LF,
+    PS_HEADERS_END_LF,
+    PS_BODY
+} parser_state;
+
+typedef struct {
+    unsigned int off;   /* offset of the first byte in the receive buffer */
+    unsigned int len;
+} Http_view;
+
+typedef struct {
+    Http_view name;
+    Http_view value;
+} Http_header_view;
+
+typedef struct {
+    parser_state state;
+    size_t pos;                     /* number of bytes of the buffer already consumed */
+    size_t mark;                    /* start of the token currently being parsed */
+
+    Http_view method;
+    Http_view path;
+    Http_view version;
+    Http_header_view headers[MAX_PARSED_HEADERS];
+    int num_headers;
+
+    /* well known headers, also found in headers[] */
+    Http_view host;
+    Http_view connection;
+    long content_length;            /* -1 if there was no Content-Length header */
+
+    size_t header_len;              /* bytes up to and including the blank line after the headers */
+} Http_parser;
+
+#define VIEW_PTR(buf, view) ((buf) + (view).off)
+#define VIEW_EQ(buf, view, str) ((view).len == sizeof(str) - 1 && memcmp(VIEW_PTR(buf, view), str, sizeof(str) - 1) == 0)
+#define VIEW_CASE_EQ(buf, view, str) ((view).len == sizeof(str) - 1 && strncasecmp(VIEW_PTR(buf, view), str, sizeof(str) - 1) == 0)
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern void http_parser_init(Http_parser *parser);
+extern parse_status http_parser_execute(Http_parser *parser, const char *buf, size_t len);
+extern size_t http_parser_request_len(Http_parser *parser);
+extern int http_header_has_token(const char *buf, Http_view value, const char *token);
+
+#endif
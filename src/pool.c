@@ -6,6 +6,485 @@
  */
 #include "pool.h"
 
+static void drain_task_ring(Mpmc_queue *ring);
+static void destroy_lanes(ThreadPool *pool);
+static void *scale_do(void *arg);
+
+Objpool task_objpool = OBJPOOL_INITIALIZER(sizeof(Task), 32, 4096);
+
+static __thread Thread *current_thread;    /* the pool thread running on this thread, if any */
+
+/* ----------< Parking >---------- */
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * @brief Sleeps on a futex word while it holds val.
+ *
+ * @param[in] timeout_ms The longest time to sleep, or 0 to sleep until woken.
+ * @return 1 if the wait timed out, 0 otherwise.
+ */
+static int futex_wait(unsigned int *addr, unsigned int val, long timeout_ms)
+{
+    struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000};
+
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout_ms > 0 ? &timeout : NULL, NULL, 0) == -1) {
+        return errno == ETIMEDOUT;
+    }
+    return 0;
+}
+
+static void futex_wake(unsigned int *addr, int count)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/**
+ * @brief Wakes up to count parked workers of a TASK_QUEUE_RING pool.
+ *
+ * @details Pairs with wait_for_task(): a worker announces itself in sleepers before it checks the queue a last
+ *          time, and a producer checks sleepers only after its task is visible, so either the worker sees the
+ *          task or the producer sees the worker. Bumping wake_seq makes a worker that is about to call
+ *          futex_wait() return immediately, so no wakeup is lost. When no worker is parked this is a single
+ *          load and no system call is made.
+ *          wake_pending limits the producer to one futex_wake() until a parked worker has run again; without it
+ *          a producer that keeps the CPU would make a system call for every task while the woken worker waits
+ *          to be scheduled. The tasks submitted in the meantime are not forgotten: a worker that takes a task
+ *          while others are still queued and workers are parked wakes the next one (see ring_thread_do()), so a
+ *          burst wakes as many workers as it has tasks, one after the other.
+ */
+static void wake_workers(ThreadPool *pool, int count)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0 &&
+        (count > 1 || __atomic_exchange_n(&pool->wake_pending, 1, __ATOMIC_SEQ_CST) == 0)) {
+        __atomic_add_fetch(&pool->wake_seq, 1, __ATOMIC_SEQ_CST);
+        futex_wake(&pool->wake_seq, count);
+    }
+}
+
+/**
+ * @brief Wakes every idle worker (used on shutdown and when workers are asked to retire).
+ */
+static void wake_all_workers(ThreadPool *pool)
+{
+    pthread_cond_broadcast(&pool->task_available);
+    if (pool->queue_type != TASK_QUEUE_LIST) {
+        __atomic_add_fetch(&pool->wake_seq, 1, __ATOMIC_SEQ_CST);
+        futex_wake(&pool->wake_seq, INT_MAX);
+    }
+}
+
+/* ----------< Lanes >---------- */
+
+static long coarse_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Creates the queues of every lane and the weighted dequeue schedule.
+ *
+ * @details The schedule spreads each lane's slots evenly (smooth weighted round robin), so with weights
+ *          {8, 4, 1} the bulk lane is preferred once in every 13 dequeues rather than after a run of 12 others.
+ *
+ * @return 0 on success, -1 if a queue could not be created (call destroy_lanes() to clean up).
+ */
+static int create_lanes(ThreadPool *pool)
+{
+    int weights[TASK_LANES] = TASK_LANE_WEIGHTS, current[TASK_LANES] = {0}, total = 0;
+    long now = coarse_now_ms();
+
+    for (int lane = 0; lane < TASK_LANES; lane++) {
+        pool->lanes[lane].served_ms = now;
+        pool->lanes[lane].queue = task_queue_create();
+        if (pool->lanes[lane].queue == NULL) {
+            return -1;
+        }
+        if (pool->queue_type != TASK_QUEUE_LIST) {
+            pool->lanes[lane].ring = mpmc_create(TASK_RING_SIZE);
+            if (pool->lanes[lane].ring == NULL) {
+                return -1;
+            }
+        }
+        total += weights[lane];
+    }
+
+    for (pool->schedule_len = 0; pool->schedule_len < total && pool->schedule_len < TASK_LANE_SCHEDULE_MAX;
+         pool->schedule_len++) {
+        int best = 0;
+        for (int lane = 0; lane < TASK_LANES; lane++) {
+            current[lane] += weights[lane];
+            if (current[lane] > current[best]) {
+                best = lane;
+            }
+        }
+        current[best] -= total;
+        pool->lane_schedule[pool->schedule_len] = best;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Frees the queues of every lane together with the owned tasks left in them.
+ */
+static void destroy_lanes(ThreadPool *pool)
+{
+    for (int lane = 0; lane < TASK_LANES; lane++) {
+        drain_task_ring(pool->lanes[lane].ring);
+        task_queue_destroy(pool->lanes[lane].queue);
+    }
+}
+
+/**
+ * @brief Counts the tasks in the lists of a TASK_QUEUE_LIST pool. Must be called with pool_lock held.
+ */
+static int list_length(ThreadPool *pool)
+{
+    int length = 0;
+
+    for (int lane = 0; lane < TASK_LANES; lane++) {
+        length += pool->lanes[lane].queue->length;
+    }
+    return length;
+}
+
+/**
+ * @brief Checks whether a lane looks empty (may be out of date as soon as it returns).
+ */
+static bool lane_empty(ThreadPool *pool, Task_lane *lane)
+{
+    if (pool->queue_type == TASK_QUEUE_LIST) {
+        return __atomic_load_n(&lane->queue->length, __ATOMIC_RELAXED) == 0;
+    }
+    return mpmc_empty(lane->ring) && __atomic_load_n(&lane->overflow, __ATOMIC_SEQ_CST) == 0;
+}
+
+/**
+ * @brief Counts the tasks in a worker's deque (a snapshot).
+ */
+static long deque_length(Deque *deque)
+{
+    return __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Records when a task was queued if its queue has no older task. Called before the task is queued,
+ *        so that the worker that takes it (and empties the queue) always clears the time again.
+ */
+static void stamp_queued(long *oldest_ns, Task *task)
+{
+    long empty = 0;
+
+    __atomic_compare_exchange_n(oldest_ns, &empty, task->queued_ns, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Moves the oldest queue time of a FIFO queue on after a task was taken from it.
+ *
+ * @details The next task was queued no earlier than the one taken, so the time of the one taken is kept as an
+ *          estimate (too old by at most the gap between the two). Nothing is written if the time is unchanged,
+ *          so spinning workers that find the queue empty do not bounce its cache line.
+ *
+ * @param[in, out] oldest_ns The queue's oldest queue time.
+ * @param[in] queued_ns When the task taken was queued.
+ * @param[in] empty true if the queue is now empty.
+ */
+static void stamp_taken(long *oldest_ns, long queued_ns, bool empty)
+{
+    long oldest = empty ? 0 : queued_ns;
+
+    if (__atomic_load_n(oldest_ns, __ATOMIC_RELAXED) != oldest) {
+        __atomic_store_n(oldest_ns, oldest, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Queues a task in its lane. In a TASK_QUEUE_LIST pool pool_lock must be held.
+ */
+static void lane_push(ThreadPool *pool, Task *task)
+{
+    Task_lane *lane = &pool->lanes[task->lane];
+
+    stamp_queued(&lane->oldest_ns, task);
+    if (pool->queue_type == TASK_QUEUE_LIST) {
+        enqueue_node(lane->queue, &task->node);
+        return;
+    }
+
+    if (!mpmc_enqueue(lane->ring, task)) {
+        /* the ring is full: spill over into the list rather than block the producer */
+        pthread_mutex_lock(&pool->pool_lock);
+        enqueue_node(lane->queue, &task->node);
+        __atomic_add_fetch(&lane->overflow, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->pool_lock);
+    }
+}
+
+/**
+ * @brief Takes the oldest task of one lane. In a TASK_QUEUE_LIST pool pool_lock must be held.
+ *
+ * @details An empty lane counts as served, so aging only looks at how long a lane has had tasks waiting.
+ *
+ * @return The task, or NULL if the lane is empty.
+ */
+static Task *lane_take(ThreadPool *pool, int index, long now)
+{
+    Task_lane *lane = &pool->lanes[index];
+    Task *task = NULL;
+
+    if (pool->queue_type == TASK_QUEUE_LIST) {
+        QueueNode *node = dequeue_node(lane->queue);
+        task = node != NULL ? node->data : NULL;
+    }
+    else {
+        task = mpmc_dequeue(lane->ring);
+        if (task == NULL && __atomic_load_n(&lane->overflow, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&pool->pool_lock);
+            QueueNode *node = dequeue_node(lane->queue);
+            if (node != NULL) {
+                __atomic_sub_fetch(&lane->overflow, 1, __ATOMIC_SEQ_CST);
+                task = node->data;
+            }
+            pthread_mutex_unlock(&pool->pool_lock);
+        }
+    }
+
+    if (__atomic_load_n(&lane->served_ms, __ATOMIC_RELAXED) != now) {
+        __atomic_store_n(&lane->served_ms, now, __ATOMIC_RELAXED);     /* written at most once per tick */
+    }
+    stamp_taken(&lane->oldest_ns, task != NULL ? task->queued_ns : 0, task == NULL || lane_empty(pool, lane));
+    return task;
+}
+
+/**
+ * @brief Takes a task from the lanes: first from a lane that has waited too long, then from the lane the
+ *        weighted schedule prefers, and then from the others in order of priority.
+ *        In a TASK_QUEUE_LIST pool pool_lock must be held.
+ *
+ * @return The task, or NULL if every lane is empty.
+ */
+static Task *take_from_lanes(ThreadPool *pool)
+{
+    long now = coarse_now_ms();
+    Task *task;
+
+    for (int lane = TASK_LANES - 1; lane > TASK_LANE_FAST; lane--) {
+        if (now - __atomic_load_n(&pool->lanes[lane].served_ms, __ATOMIC_RELAXED) > LANE_AGING_MS &&
+            (task = lane_take(pool, lane, now)) != NULL) {
+            return task;
+        }
+    }
+
+    unsigned int tick = __atomic_fetch_add(&pool->lane_tick, 1, __ATOMIC_RELAXED);
+    int preferred = pool->lane_schedule[tick % pool->schedule_len];
+    if ((task = lane_take(pool, preferred, now)) != NULL) {
+        return task;
+    }
+    for (int lane = TASK_LANE_FAST; lane < TASK_LANES; lane++) {
+        if (lane != preferred && (task = lane_take(pool, lane, now)) != NULL) {
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+/* ----------< Scaling >---------- */
+
+static long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * @brief Adds the time a task spent in the queue to the controller's sample (elastic pools only).
+ */
+static void record_queue_wait(ThreadPool *pool, Task *task)
+{
+    if (pool->elastic) {
+        __atomic_add_fetch(&pool->wait_ns, now_ns() - task->queued_ns, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pool->wait_count, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Lets an idle worker retire if thread_pool_shrink() asked for it. Must be called with pool_lock held.
+ *
+ * @return true if the worker has to exit; it no longer counts as active.
+ */
+static bool retire_requested(ThreadPool *pool)
+{
+    if (pool->retire_requests > 0 && pool->active_threads > 1) {
+        pool->retire_requests--;
+        pool->active_threads--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Lets a worker that has been idle for SCALE_IDLE_TIMEOUT_MS retire while the pool has more than
+ *        min_threads workers. Must be called with pool_lock held.
+ *
+ * @return true if the worker has to exit; it no longer counts as active.
+ */
+static bool retire_idle(ThreadPool *pool)
+{
+    if (pool->on && pool->active_threads > pool->min_threads) {
+        pool->active_threads--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Starts the thread of a worker, pinned to its CPU if the pool has any.
+ *
+ * @return 0 on success, an error number otherwise.
+ */
+static int spawn_thread(Thread *thread)
+{
+    pthread_attr_t attr;
+
+    if (pthread_attr_init(&attr) != 0) {
+        return -1;
+    }
+    int err = affinity_set_attr(&attr, thread->cpu);
+    if (err == 0) {
+        err = pthread_create(&thread->thread, &attr, thread_do, thread);
+    }
+    pthread_attr_destroy(&attr);
+
+    return err;
+}
+
+/**
+ * @brief Starts up to num more workers, reusing the slots of retired ones. Must be called with pool_lock held.
+ *
+ * @return The number of workers started.
+ */
+static int start_threads(ThreadPool *pool, int num)
+{
+    int started = 0;
+
+    for (int i = 0; i < pool->num_threads && started < num && pool->active_threads < pool->max_threads; i++) {
+        Thread *thread = pool->threads[i];
+
+        if (thread != NULL && thread->state == THREAD_RUNNING) {
+            continue;
+        }
+        if (thread != NULL && thread->state == THREAD_EXITED) {
+            pthread_join(thread->thread, NULL);     // it has already released pool_lock for good
+            thread->state = THREAD_STOPPED;
+        }
+
+        if (thread == NULL) {
+            thread = thread_create(pool, i);
+            if (thread == NULL) {
+                break;
+            }
+            __atomic_store_n(&pool->threads[i], thread, __ATOMIC_RELEASE);    /* running workers may look for victims */
+        }
+        else {
+            thread->state = THREAD_RUNNING;
+            if (spawn_thread(thread) != 0) {
+                perror("THREAD CREATION FAILED\n");
+                thread->state = THREAD_STOPPED;
+                break;
+            }
+        }
+
+        pool->active_threads++;
+        started++;
+    }
+
+    return started;
+}
+
+/**
+ * @brief Counts the tasks waiting in the pool's queues (a snapshot; other threads keep changing them).
+ */
+static int queued_tasks(ThreadPool *pool)
+{
+    if (pool->queue_type == TASK_QUEUE_LIST) {
+        return list_length(pool);
+    }
+
+    long queued = 0;
+    for (int lane = 0; lane < TASK_LANES; lane++) {
+        queued += __atomic_load_n(&pool->lanes[lane].ring->head, __ATOMIC_RELAXED) -
+                  __atomic_load_n(&pool->lanes[lane].ring->tail, __ATOMIC_RELAXED) +
+                  __atomic_load_n(&pool->lanes[lane].overflow, __ATOMIC_RELAXED);
+    }
+
+    for (int i = 0; pool->queue_type == TASK_QUEUE_STEAL && i < pool->num_threads; i++) {
+        Thread *thread = __atomic_load_n(&pool->threads[i], __ATOMIC_ACQUIRE);
+        Deque *deque = thread != NULL ? __atomic_load_n(&thread->deque, __ATOMIC_ACQUIRE) : NULL;
+        if (deque != NULL) {
+            queued += deque_length(deque);
+        }
+    }
+
+    return queued > 0 ? queued : 0;
+}
+
+/**
+ * @brief The controller of an elastic pool.
+ *
+ * @details Every SCALE_INTERVAL_MS it joins retired workers and looks at the tasks taken during the interval.
+ *          If tasks are queued and they waited longer than SCALE_UP_WAIT_US on average (or none could be taken
+ *          at all, because every worker is stuck in a long task), it starts half as many workers again as are
+ *          running, up to max_threads. Shrinking is left to the workers themselves (see retire_idle()).
+ */
+static void *scale_do(void *arg)
+{
+    ThreadPool *pool = (ThreadPool *)arg;
+
+    pthread_mutex_lock(&pool->pool_lock);
+    while (pool->on) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += SCALE_INTERVAL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+
+        pthread_cond_timedwait(&pool->controller_wake, &pool->pool_lock, &deadline);
+        if (!pool->on) {
+            break;
+        }
+
+        for (int i = 0; i < pool->num_threads; i++) {
+            Thread *thread = pool->threads[i];
+            if (thread != NULL && thread->state == THREAD_EXITED) {
+                pthread_join(thread->thread, NULL);
+                thread->state = THREAD_STOPPED;
+            }
+        }
+
+        long count = __atomic_exchange_n(&pool->wait_count, 0, __ATOMIC_RELAXED);
+        long wait_ns = __atomic_exchange_n(&pool->wait_ns, 0, __ATOMIC_RELAXED);
+        bool slow = count > 0 ? wait_ns / count > SCALE_UP_WAIT_US * 1000L : true;
+
+        if (slow && queued_tasks(pool) > 0 && pool->active_threads < pool->max_threads) {
+            start_threads(pool, pool->active_threads / 2 + 1);
+        }
+    }
+    pthread_mutex_unlock(&pool->pool_lock);
+
+    return NULL;
+}
+
 /* ----------< ThreadPool >---------- */
 
 /**
@@ -20,10 +499,61 @@
  */
 ThreadPool *thread_pool_create(size_t pool_size) 
 {
-    
+    return thread_pool_create_with_queue(pool_size, TASK_QUEUE_LIST);
+}
+
+/**
+ * @brief Creates a new thread pool that uses the given kind of task queue.
+ *
+ * @param[in] pool_size The size of the thread pool.
+ * @param[in] queue_type TASK_QUEUE_LIST for the mutex protected linked list, TASK_QUEUE_RING for the lock-free ring.
+ * @return A pointer to the newly created thread pool. If the thread pool
+ *         could not be created, it returns NULL.
+ */
+ThreadPool *thread_pool_create_with_queue(size_t pool_size, task_queue_type queue_type)
+{
+    return thread_pool_create_elastic(pool_size, pool_size, queue_type);
+}
+
+/**
+ * @brief Creates a thread pool whose size is adjusted to the load.
+ *
+ * @details Starts min_threads workers. If max_threads is larger, a controller thread adds workers while tasks
+ *          wait too long in the queue, and workers idle for SCALE_IDLE_TIMEOUT_MS retire down to min_threads.
+ *
+ * @param[in] min_threads The number of workers the pool keeps when idle.
+ * @param[in] max_threads The most workers the pool runs (raised to min_threads if smaller).
+ * @param[in] queue_type The kind of task queue (see task_queue_type).
+ * @return A pointer to the newly created thread pool. If the thread pool
+ *         could not be created, it returns NULL.
+ */
+ThreadPool *thread_pool_create_elastic(size_t min_threads, size_t max_threads, task_queue_type queue_type)
+{
+    return thread_pool_create_pinned(min_threads, max_threads, queue_type, NULL, 0);
+}
 
-    if(pool_size <= 0) {
-        pool_size = THREAD_POOL_SIZE;
+/**
+ * @brief Creates an elastic thread pool whose workers are pinned to CPUs.
+ *
+ * @details Worker i runs on cpus[i % num_cpus]. Workers are created already pinned and allocate their own
+ *          per-worker data (such as their deque), so it is first touched on the worker's NUMA node.
+ *
+ * @param[in] min_threads The number of workers the pool keeps when idle.
+ * @param[in] max_threads The most workers the pool runs (raised to min_threads if smaller).
+ * @param[in] queue_type The kind of task queue (see task_queue_type).
+ * @param[in] cpus The CPUs to pin workers to; must stay valid as long as the pool. NULL leaves them unpinned.
+ * @param[in] num_cpus The number of CPUs in cpus.
+ * @return A pointer to the newly created thread pool. If the thread pool
+ *         could not be created, it returns NULL.
+ */
+ThreadPool *thread_pool_create_pinned(size_t min_threads, size_t max_threads, task_queue_type queue_type,
+                                      const int *cpus, int num_cpus)
+{
+    if(min_threads <= 0) {
+        min_threads = THREAD_POOL_SIZE;
+    }
+    if (max_threads < min_threads) {
+        max_threads = min_threads;
     }
 
     ThreadPool *new_pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
@@ -34,7 +564,7 @@ ThreadPool *thread_pool_create(size_t pool_size)
 
     
 
-    new_pool->threads = malloc(pool_size * sizeof(Thread *));
+    new_pool->threads = calloc(max_threads, sizeof(Thread *));
     if (new_pool->threads == NULL) {
         perror("THREADS CREATION FAILED\n");
         free(new_pool);
@@ -67,34 +597,53 @@ ThreadPool *thread_pool_create(size_t pool_size)
         return NULL;  // Failed to initialize the condition variable
     }
 
-    
+    if (pthread_cond_init(&new_pool->controller_wake, NULL) != 0) {
+        pthread_cond_destroy(&new_pool->threads_idle);
+        pthread_cond_destroy(&new_pool->task_available);
+        pthread_mutex_destroy(&new_pool->pool_lock);
+        free(new_pool->threads);
+        free(new_pool);
+        return NULL;  // Failed to initialize the condition variable
+    }
 
-    new_pool->task_queue = task_queue_create();
-    if (new_pool->task_queue == NULL) {
+    new_pool->queue_type = queue_type;
+    if (create_lanes(new_pool) == -1) {
         perror("QUEUE CREATION FAILED\n");
+        destroy_lanes(new_pool);
+        pthread_cond_destroy(&new_pool->controller_wake);
         pthread_cond_destroy(&new_pool->threads_idle);
         pthread_cond_destroy(&new_pool->task_available);
         pthread_mutex_destroy(&new_pool->pool_lock);
         free(new_pool->threads);
         free(new_pool);
-        return NULL;  // Failed to create the task queue
+        return NULL;  // Failed to create the task queues
     }
 
-    
+    new_pool->num_threads = max_threads;
+    new_pool->min_threads = min_threads;
+    new_pool->max_threads = max_threads;
+    new_pool->elastic = max_threads > min_threads;
+    new_pool->on = true;
+    new_pool->cpus = num_cpus > 0 ? cpus : NULL;
+    new_pool->num_cpus = num_cpus > 0 ? num_cpus : 0;
 
-    for (size_t i = 0; i < pool_size; i++) {
-        new_pool->threads[i] = thread_create(new_pool, i);
-        if (new_pool->threads[i] == NULL) {
-            perror("THREAD ERROR\n");
-            thread_pool_destroy(new_pool);
-            return NULL;  // Failed to create a thread
-        }
-    }
+    pthread_mutex_lock(&new_pool->pool_lock);
+    int started = start_threads(new_pool, min_threads);
+    pthread_mutex_unlock(&new_pool->pool_lock);
 
-    while(new_pool->active_threads != pool_size)   // wait for all threads to initialize
-        ;
+    if (started != (int)min_threads) {
+        perror("THREAD ERROR\n");
+        new_pool->elastic = false;
+        thread_pool_destroy(new_pool);
+        return NULL;  // Failed to create a thread
+    }
 
-    
+    if (new_pool->elastic && pthread_create(&new_pool->controller, NULL, scale_do, new_pool) != 0) {
+        perror("THREAD ERROR\n");
+        new_pool->elastic = false;
+        thread_pool_destroy(new_pool);
+        return NULL;  // Failed to create the controller
+    }
 
     return new_pool;
 }
@@ -110,23 +659,30 @@ void thread_pool_destroy(ThreadPool *pool)
 
     // thread_pool_wait(pool);
     
-    volatile int thread_count = pool->active_threads;
-
     pthread_mutex_lock(&pool->pool_lock);
-    pool->active_threads = 0;
-    pthread_cond_broadcast(&pool->task_available);
+    pool->on = false;
+    wake_all_workers(pool);
+    pthread_cond_signal(&pool->controller_wake);
     pthread_mutex_unlock(&pool->pool_lock);
 
-    // sleep(1);   /* give one second to kill idle threads (if threads are detached upon creation) */
+    if (pool->elastic) {
+        pthread_join(pool->controller, NULL);
+    }
 
-    for (int i = 0; i < thread_count; i++) {
-        pthread_join(pool->threads[i]->thread, NULL);   // ensure all threads terminate before destroying them
+    for (int i = 0; i < pool->num_threads; i++) {
+        if (pool->threads[i] == NULL) {
+            continue;
+        }
+        if (pool->threads[i]->state != THREAD_STOPPED) {
+            pthread_join(pool->threads[i]->thread, NULL);   // ensure all threads terminate before destroying them
+        }
         thread_destroy(pool->threads[i]);
     }
 
     free(pool->threads);
 
-    task_queue_destroy(pool->task_queue);
+    destroy_lanes(pool);
+    pthread_cond_destroy(&pool->controller_wake);
     pthread_cond_destroy(&pool->threads_idle);
     pthread_cond_destroy(&pool->task_available);
     pthread_mutex_destroy(&pool->pool_lock);
@@ -136,60 +692,166 @@ void thread_pool_destroy(ThreadPool *pool)
     
 }
 
-void thread_pool_add_task(ThreadPool *pool, task_func function, void *arg) 
+static void push_task(ThreadPool *pool, Task *task)
 {
-    Task *task = (Task *)malloc(sizeof(Task));
-    task->func = function;
-    task->arg = arg;
+    task->node.data = task;
+    task->queued_ns = now_ns();
+
+    if (pool->queue_type == TASK_QUEUE_STEAL && current_thread != NULL && current_thread->pool == pool &&
+        current_thread->deque != NULL) {
+        stamp_queued(&current_thread->oldest_ns, task);
+        if (deque_push(current_thread->deque, task)) {
+            wake_workers(pool, 1);      /* an idle worker may steal it */
+            return;
+        }
+    }
+
+    if (pool->queue_type != TASK_QUEUE_LIST) {
+        lane_push(pool, task);
+        wake_workers(pool, 1);
+        return;
+    }
 
     pthread_mutex_lock(&pool->pool_lock);
-    enqueue(pool->task_queue, task);
+    lane_push(pool, task);
     pthread_cond_signal(&pool->task_available);
     pthread_mutex_unlock(&pool->pool_lock);
+}
 
-    
+void thread_pool_add_task(ThreadPool *pool, task_func function, void *arg) 
+{
+    Task *task = (Task *)objpool_alloc(&task_objpool);
+    if (task == NULL) {
+        perror("TASK CREATION FAILED\n");
+        return;
+    }
+
+    task->func = function;
+    task->arg = arg;
+    task->lane = TASK_LANE_NORMAL;
+    task->owned = true;
+    push_task(pool, task);
+}
+
+/**
+ * @brief Adds a task whose memory is owned by the caller to the pool.
+ *
+ * @details Nothing is allocated: the task (usually embedded in the object it works on) is linked into the
+ *          queue directly. The task must stay valid until its function has started running, and must not be
+ *          submitted again before then.
+ *
+ * @param[in] pool The thread pool.
+ * @param[in] task The task to fill in and queue.
+ * @param[in] function The function to run.
+ * @param[in] arg The argument passed to the function.
+ */
+void thread_pool_submit(ThreadPool *pool, Task *task, task_func function, void *arg)
+{
+    thread_pool_submit_lane(pool, task, TASK_LANE_NORMAL, function, arg);
+}
+
+/**
+ * @brief Adds a task whose memory is owned by the caller to one of the pool's priority lanes.
+ *
+ * @details Same as thread_pool_submit(), but the caller says how expensive the task is expected to be (see
+ *          task_lane).
+ *
+ * @param[in] pool The thread pool.
+ * @param[in] task The task to fill in and queue.
+ * @param[in] lane The lane the task is queued in.
+ * @param[in] function The function to run.
+ * @param[in] arg The argument passed to the function.
+ */
+void thread_pool_submit_lane(ThreadPool *pool, Task *task, task_lane lane, task_func function, void *arg)
+{
+    task->func = function;
+    task->arg = arg;
+    task->lane = lane;
+    task->owned = false;
+    push_task(pool, task);
 }
 
 void thread_pool_wait(ThreadPool *pool)
 {
     pthread_mutex_lock(&pool->pool_lock);
-    while (pool->working_threads > 0) {
+    __atomic_add_fetch(&pool->waiting, 1, __ATOMIC_SEQ_CST);  /* ring workers only signal when someone waits */
+    while (__atomic_load_n(&pool->working_threads, __ATOMIC_SEQ_CST) > 0) {
         pthread_cond_wait(&pool->threads_idle, &pool->pool_lock);
     }
+    __atomic_sub_fetch(&pool->waiting, 1, __ATOMIC_SEQ_CST);
     pthread_mutex_unlock(&pool->pool_lock);
+}
 
-    
+/**
+ * @brief Returns the number of tasks waiting in the pool's queues.
+ *
+ * @details A snapshot taken without any lock; other threads keep changing the queues.
+ *
+ * @param[in] pool The thread pool.
+ * @return The number of queued tasks.
+ */
+int thread_pool_queued(ThreadPool *pool)
+{
+    return queued_tasks(pool);
 }
 
-void thread_pool_grow(ThreadPool *pool, size_t num) 
+/**
+ * @brief Returns how long the oldest task in the pool's queues has been waiting.
+ *
+ * @details Every lane and deque keeps the time its oldest task was queued (see stamp_queued() and
+ *          stamp_taken()), so the age keeps growing while no worker takes anything, e.g. when every worker is
+ *          stuck in a slow task. While nothing is queued it is 0.
+ *
+ * @param[in] pool The thread pool.
+ * @return The queue wait in milliseconds.
+ */
+long thread_pool_queue_wait_ms(ThreadPool *pool)
 {
-    pthread_mutex_lock(&pool->pool_lock);
-    pool->threads = realloc(pool->threads, (pool->active_threads + num) * sizeof(Thread *));
-    for (size_t i = pool->active_threads; i < pool->active_threads + num; i++) 
-    {
-        pool->threads[i] = thread_create(pool, i);
-        if (pool->threads[i] == NULL) {
-            // Handle error...
-            break;
+    long oldest = 0;
+
+    for (int lane = 0; lane < TASK_LANES; lane++) {
+        long queued = __atomic_load_n(&pool->lanes[lane].oldest_ns, __ATOMIC_RELAXED);
+        if (queued != 0 && (oldest == 0 || queued < oldest) && !lane_empty(pool, &pool->lanes[lane])) {
+            oldest = queued;
         }
     }
-    pool->active_threads += num;
+
+    for (int i = 0; pool->queue_type == TASK_QUEUE_STEAL && i < pool->num_threads; i++) {
+        Thread *thread = __atomic_load_n(&pool->threads[i], __ATOMIC_ACQUIRE);
+        Deque *deque = thread != NULL ? __atomic_load_n(&thread->deque, __ATOMIC_ACQUIRE) : NULL;
+        long queued = thread != NULL ? __atomic_load_n(&thread->oldest_ns, __ATOMIC_RELAXED) : 0;
+        if (queued != 0 && (oldest == 0 || queued < oldest) && deque != NULL && deque_length(deque) > 0) {
+            oldest = queued;
+        }
+    }
+
+    return oldest != 0 ? (now_ns() - oldest) / 1000000 : 0;
+}
+
+/**
+ * @brief Starts up to num more workers (the pool never exceeds max_threads).
+ */
+void thread_pool_grow(ThreadPool *pool, size_t num) 
+{
+    pthread_mutex_lock(&pool->pool_lock);
+    start_threads(pool, num);
     pthread_mutex_unlock(&pool->pool_lock);
 }
 
+/**
+ * @brief Asks num workers to retire.
+ *
+ * @details Workers are not cancelled: the next num workers that become idle exit on their own, so no worker
+ *          stops in the middle of a task or while holding pool_lock. At least one worker is always kept.
+ */
 void thread_pool_shrink(ThreadPool *pool, size_t num) 
 {
     pthread_mutex_lock(&pool->pool_lock);
-    for (size_t i = 0; i < num; i++) 
-    {
-        if (pool->active_threads == 0) {
-            break;
-        }
-        pool->active_threads--;
-        pthread_cancel(pool->threads[pool->active_threads]->thread);
-        thread_destroy(pool->threads[pool->active_threads]);
+    pool->retire_requests += num;
+    if (pool->retire_requests > pool->active_threads - 1) {
+        pool->retire_requests = pool->active_threads - 1;
     }
-    pool->threads = realloc(pool->threads, pool->active_threads * sizeof(Thread *));
+    wake_all_workers(pool);
     pthread_mutex_unlock(&pool->pool_lock);
 }
 
@@ -211,8 +873,13 @@ Thread *thread_create(ThreadPool *pool, int id)
     
     thread->pool = pool;
     thread->id = id;
+    thread->seed = 2654435761u * (id + 1);
+    thread->deque = NULL;
+    thread->oldest_ns = 0;
+    thread->cpu = pool->num_cpus > 0 ? pool->cpus[id % pool->num_cpus] : -1;
+    thread->state = THREAD_RUNNING;
 
-    if (pthread_create(&thread->thread, NULL, thread_do, thread) != 0)
+    if (spawn_thread(thread) != 0)
     {
         perror("THREAD CREATION FAILED\n");
         free(thread);
@@ -229,8 +896,7 @@ Thread *thread_create(ThreadPool *pool, int id)
  * @brief Destroys a worker thread.
  * 
  * @details This function destroys a worker thread. 
- *          It stops the thread, waits for it to finish its current task, 
- *          and then frees all the resources associated with the thread.
+ *          The thread must already have been joined; this frees all the resources associated with it.
  * 
  * @param thread A pointer to the thread to be destroyed.
  * @return void
@@ -242,14 +908,212 @@ void thread_destroy(Thread *thread)
     }
 
     // pthread_cancel(thread->thread);  // if thread_do returns, the thread terminates
+    if (thread->deque != NULL) {
+        Task *task;
+        while ((task = deque_take(thread->deque)) != NULL) {   // tasks left when the pool was destroyed
+            if (task->owned) {
+                objpool_free(&task_objpool, task);
+            }
+        }
+        deque_destroy(thread->deque);
+    }
     free(thread);
 }
 
+/**
+ * @brief Steals a task from the deque of another worker, starting at a random victim.
+ *
+ * @return The task, or NULL if every other deque is empty (or the thief lost every race).
+ */
+static Task *steal_task(Thread *thief)
+{
+    ThreadPool *pool = thief->pool;
+    int num_threads = pool->num_threads;
+
+    /* xorshift32: cheap and good enough to spread thieves over the victims */
+    thief->seed ^= thief->seed << 13;
+    thief->seed ^= thief->seed >> 17;
+    thief->seed ^= thief->seed << 5;
+
+    int start = thief->seed % num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        Thread *victim = __atomic_load_n(&pool->threads[(start + i) % num_threads], __ATOMIC_ACQUIRE);
+        if (victim == NULL || victim == thief) {
+            continue;
+        }
+
+        Deque *deque = __atomic_load_n(&victim->deque, __ATOMIC_ACQUIRE);
+        Task *task = deque != NULL ? deque_steal(deque) : NULL;
+        if (task != NULL) {
+            /* thieves take the oldest task, so the victim's next one was queued no earlier */
+            stamp_taken(&victim->oldest_ns, task->queued_ns, deque_length(deque) <= 0);
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Takes a task from a TASK_QUEUE_RING or TASK_QUEUE_STEAL pool without blocking.
+ *
+ * @details Looks at the thread's own deque first, then the lanes (rings and their overflow lists, see
+ *          take_from_lanes()), and finally steals from the other workers.
+ *
+ * @return The task, or NULL if no task was found.
+ */
+static Task *take_task(Thread *thread)
+{
+    ThreadPool *pool = thread->pool;
+    Task *task = thread->deque != NULL ? deque_take(thread->deque) : NULL;
+
+    if (thread->deque != NULL && deque_length(thread->deque) <= 0) {
+        stamp_taken(&thread->oldest_ns, 0, true);   /* the owner takes the newest task; only emptying matters */
+    }
+    if (task == NULL) {
+        task = take_from_lanes(pool);
+    }
+
+    if (task == NULL && pool->queue_type == TASK_QUEUE_STEAL) {
+        task = steal_task(thread);
+    }
+
+    return task;
+}
+
+/**
+ * @brief Waits until a task is available in a TASK_QUEUE_RING or TASK_QUEUE_STEAL pool.
+ *
+ * @details The worker first retries SPINS_BEFORE_PARK times, which is enough to pick up the next task of a busy
+ *          producer without a system call, and then parks on the pool's futex (see wake_workers()). In an
+ *          elastic pool the worker retires if it stays parked for SCALE_IDLE_TIMEOUT_MS.
+ *
+ * @param[out] retired Set to true if the worker retired (it no longer counts as active).
+ * @return The task, or NULL if the pool is being destroyed or the worker retired.
+ */
+static Task *wait_for_task(Thread *thread, bool *retired)
+{
+    ThreadPool *pool = thread->pool;
+    Task *task;
+
+    for (;;) {
+        for (int i = 0; i < SPINS_BEFORE_PARK; i++) {
+            if (!__atomic_load_n(&pool->on, __ATOMIC_ACQUIRE)) {
+                return NULL;
+            }
+            if ((task = take_task(thread)) != NULL) {
+                return task;
+            }
+            cpu_relax();
+        }
+
+        if (__atomic_load_n(&pool->retire_requests, __ATOMIC_RELAXED) > 0) {
+            pthread_mutex_lock(&pool->pool_lock);
+            *retired = retire_requested(pool);
+            pthread_mutex_unlock(&pool->pool_lock);
+            if (*retired) {
+                return NULL;
+            }
+        }
+
+        unsigned int seq = __atomic_load_n(&pool->wake_seq, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&pool->wake_pending, 0, __ATOMIC_SEQ_CST);   /* let the next task wake us */
+
+        int timed_out = 0;
+        task = take_task(thread);   /* a task queued before we announced ourselves would not wake us */
+        if (task == NULL && __atomic_load_n(&pool->on, __ATOMIC_SEQ_CST)) {
+            timed_out = futex_wait(&pool->wake_seq, seq, pool->elastic ? SCALE_IDLE_TIMEOUT_MS : 0);
+        }
+
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&pool->wake_pending, 0, __ATOMIC_SEQ_CST);
+        if (task != NULL) {
+            return task;
+        }
+
+        if (timed_out) {
+            pthread_mutex_lock(&pool->pool_lock);
+            *retired = retire_idle(pool);
+            pthread_mutex_unlock(&pool->pool_lock);
+            if (*retired) {
+                return NULL;
+            }
+        }
+    }
+}
+
+/**
+ * @brief The worker loop of a TASK_QUEUE_RING or TASK_QUEUE_STEAL pool; takes no lock unless thread_pool_wait()
+ *        is in use.
+ *
+ * @return true if the worker retired, false if the pool is being destroyed.
+ */
+static bool ring_thread_do(Thread *thread)
+{
+    ThreadPool *pool = thread->pool;
+    bool retired = false;
+    Task *task;
+
+    while ((task = wait_for_task(thread, &retired)) != NULL) {
+        __atomic_add_fetch(&pool->working_threads, 1, __ATOMIC_SEQ_CST);
+        record_queue_wait(pool, task);
+
+        /* the producer woke only one worker for the tasks behind this one: pass the wakeup on */
+        if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0 && queued_tasks(pool) > 0) {
+            wake_workers(pool, 1);
+        }
+
+        bool owned = task->owned;   /* the function may free a task it owns */
+        task->func(task->arg);
+        if (owned) {
+            objpool_free(&task_objpool, task);
+        }
+
+        if (__atomic_sub_fetch(&pool->working_threads, 1, __ATOMIC_SEQ_CST) == 0 &&
+            __atomic_load_n(&pool->waiting, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&pool->pool_lock);
+            pthread_cond_broadcast(&pool->threads_idle);
+            pthread_mutex_unlock(&pool->pool_lock);
+        }
+    }
+
+    return retired;
+}
+
+/**
+ * @brief Waits on task_available until a task may be available in a TASK_QUEUE_LIST pool.
+ *        Must be called with pool_lock held.
+ *
+ * @return true if the worker retired instead (it no longer counts as active).
+ */
+static bool list_wait_for_task(ThreadPool *pool)
+{
+    if (retire_requested(pool)) {
+        return true;
+    }
+
+    if (!pool->elastic) {
+        pthread_cond_wait(&pool->task_available, &pool->pool_lock);
+        return false;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SCALE_IDLE_TIMEOUT_MS / 1000;
+
+    if (pthread_cond_timedwait(&pool->task_available, &pool->pool_lock, &deadline) == ETIMEDOUT) {
+        return retire_idle(pool);
+    }
+    return false;
+}
+
 /**
  * @brief The function to be executed by all worker threads.
  * 
  * @details This function is the main function that the worker threads execute. 
- *          It fetches tasks from the work queue and processes them.
+ *          It fetches tasks from the work queue and processes them until the pool is destroyed or the
+ *          worker retires.
  * 
  * @param arg A pointer to the argument to be passed to the function. 
  *            This is usually a pointer to the thread's own structure.
@@ -258,39 +1122,51 @@ void *thread_do(void *arg)
 {
     Thread *thread = (Thread *)arg;
     ThreadPool *pool = thread->pool;
+    bool retired = false;
 
-    pthread_mutex_lock(&pool->pool_lock);
-    pool->active_threads++;
-    
-    pthread_mutex_unlock(&pool->pool_lock);
+    current_thread = thread;
+    if (pool->queue_type == TASK_QUEUE_STEAL && thread->deque == NULL) {
+        /* allocated here rather than in thread_create() so that it is first touched on this worker's CPU */
+        Deque *deque = deque_create(TASK_DEQUE_SIZE);
+        if (deque == NULL) {
+            perror("DEQUE CREATION FAILED\n");     // the worker still serves the shared ring
+        }
+        __atomic_store_n(&thread->deque, deque, __ATOMIC_RELEASE);
+    }
+    if (pool->queue_type != TASK_QUEUE_LIST) {
+        retired = ring_thread_do(thread);
+    }
 
-    for(;;) 
+    while (pool->queue_type == TASK_QUEUE_LIST)
     {
         pthread_mutex_lock(&pool->pool_lock);
 
         /* go to sleep until there's something to do */
-        while (pool->task_queue->length == 0 && pool->active_threads > 0) {
-            pthread_cond_wait(&pool->task_available, &pool->pool_lock);
+        while (list_length(pool) == 0 && pool->on && !retired) {
+            retired = list_wait_for_task(pool);
         }
 
-        // 
-        /* thread pool is being destroyed; end this thread's execution */
-        if (pool->active_threads == 0) {
+        /* thread pool is being destroyed (or this worker retired); end this thread's execution */
+        if (!pool->on || retired) {
             
             pthread_mutex_unlock(&pool->pool_lock);
             break;
         }
 
-        Task *task = dequeue(pool->task_queue);
-        
+        Task *task = take_from_lanes(pool);
+
         pool->working_threads++;
 
         pthread_mutex_unlock(&pool->pool_lock);
 
         /* start processing the dequeued task */
         if (task != NULL) {
+            record_queue_wait(pool, task);
+            bool owned = task->owned;   /* the function may free a task it owns */
             task->func(task->arg);
-            free(task);
+            if (owned) {
+                objpool_free(&task_objpool, task);
+            }
         }
 
         pthread_mutex_lock(&pool->pool_lock);
@@ -302,11 +1178,12 @@ void *thread_do(void *arg)
         pthread_mutex_unlock(&pool->pool_lock);
     }
 
-    // pthread_mutex_lock(&pool->pool_lock);
-    // pool->active_threads--;
-    // if "on" field is implemented, change stop condition and un comment this code
-    
-    // pthread_mutex_unlock(&pool->pool_lock);
+    pthread_mutex_lock(&pool->pool_lock);
+    if (!retired) {
+        pool->active_threads--;
+    }
+    thread->state = THREAD_EXITED;     /* the controller (or thread_pool_destroy) joins it */
+    pthread_mutex_unlock(&pool->pool_lock);
 
     return NULL;
 }
@@ -327,7 +1204,33 @@ Queue *task_queue_create()
 void task_queue_destroy(Queue *queue) 
 {
     if (queue != NULL) {
+        QueueNode *node;
+        while ((node = dequeue_node(queue)) != NULL) {  // task nodes are embedded in their tasks
+            Task *task = node->data;
+            if (task->owned) {
+                objpool_free(&task_objpool, task);
+            }
+        }
         queue_destroy(queue);
         
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Frees the owned tasks left in a task ring and the ring itself.
+ */
+static void drain_task_ring(Mpmc_queue *ring)
+{
+    Task *task;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    while ((task = mpmc_dequeue(ring)) != NULL) {
+        if (task->owned) {
+            objpool_free(&task_objpool, task);
+        }
+    }
+    mpmc_destroy(ring);
+}
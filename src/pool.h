@@ -7,14 +7,35 @@
  * This thread pool is implemented as an array of worker threads and a queue of tasks. 
  * Each worker thread continuously fetches a task from the queue and executes it. 
  * The thread pool provides functions for creating and destroying the pool, 
- * as well as adding tasks to the pool. It also includes experimental support for 
- * dynamic resizing of the thread pool.
+ * as well as adding tasks to the pool. 
+ * An elastic pool (thread_pool_create_elastic()) runs between min_threads and max_threads workers.
+ * A controller thread samples the number of queued tasks and the time tasks waited in the queue
+ * every SCALE_INTERVAL_MS, and starts more workers (up to max_threads) while tasks wait longer than
+ * SCALE_UP_WAIT_US. A worker that has been idle for SCALE_IDLE_TIMEOUT_MS retires on its own while
+ * there are more than min_threads workers, so workers are never cancelled in the middle of a task.
+ * thread_pool_grow() and thread_pool_shrink() resize any pool the same way.
+ * The task queue is either a linked list protected by pool_lock (TASK_QUEUE_LIST) or a lock-free
+ * ring (TASK_QUEUE_RING, see mpmc.h). With the ring, adding and taking tasks takes no lock: idle
+ * workers spin briefly and then park on a futex, and a producer only makes a system call when a
+ * worker is actually parked. Tasks that do not fit in a full ring spill over into the linked list.
+ * In work-stealing mode (TASK_QUEUE_STEAL) every worker also owns a Chase-Lev deque (see deque.h).
+ * A task submitted by a worker of the pool goes to that worker's own deque and is run by the same
+ * worker (newest first, while its data is still in cache) unless an idle worker steals it. Tasks
+ * submitted from outside the pool go to the shared ring. A worker looks for work in its own deque,
+ * then the ring, then the deques of the other workers starting at a random victim.
+ * Workers of a pool created with thread_pool_create_pinned() are started pinned to CPUs (see affinity.h).
+ * Tasks are queued in one of TASK_LANES priority lanes (see task_lane), each with its own list or ring.
+ * Workers take from the lanes in a fixed weighted schedule (TASK_LANE_WEIGHTS), so cheap tasks are not
+ * stuck behind expensive ones while the expensive lane still gets its share. A lane whose tasks have
+ * gone unserved for LANE_AGING_MS is served first (aging).
+ * thread_pool_queued() and thread_pool_queue_wait_ms() report how deep the queues are and how long tasks
+ * currently wait in them, so that callers can stop adding work when the pool falls behind.
  * 
  * Assumptions/Limitations: 
- * It's assumed that the size of the thread pool doesn't change after the pool has been created, 
- * except when using the experimental resize functions. The current implementation does not 
- * provide a way to cancel tasks once they have been added to the pool or a way to pause the pool
- * but not destroy it.
+ * The pool never runs more than max_threads workers; the threads array has one slot per worker, and
+ * the Thread in a slot is reused (never freed) until the pool is destroyed, so thieves can always
+ * read it. The current implementation does not provide a way to cancel tasks once they have been
+ * added to the pool or a way to pause the pool but not destroy it.
  * 
  * @date 2023-12-06
  */
@@ -26,9 +47,27 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include "queue.h"
+#include "mpmc.h"
+#include "deque.h"
+#include "affinity.h"
 
 #define THREAD_POOL_SIZE 16
+#define TASK_RING_SIZE 1024         /* capacity of the lock-free task queue */
+#define SPINS_BEFORE_PARK 64        /* attempts an idle worker makes to take a task before it sleeps */
+#define TASK_DEQUE_SIZE 256         /* capacity of a worker's deque (TASK_QUEUE_STEAL) */
+#define SCALE_INTERVAL_MS 100       /* how often the controller of an elastic pool samples the queue */
+#define SCALE_UP_WAIT_US 1000       /* average queue wait above which the controller starts more workers */
+#define SCALE_IDLE_TIMEOUT_MS 5000  /* idle time after which a worker above min_threads retires */
+#define TASK_LANES 3                /* priority lanes of the task queue (see task_lane) */
+#define TASK_LANE_WEIGHTS {8, 4, 1} /* share of the dequeues each lane gets while every lane has tasks */
+#define TASK_LANE_SCHEDULE_MAX 64   /* most slots in the dequeue schedule (the sum of the weights) */
+#define LANE_AGING_MS 50            /* a lane whose tasks have waited this long unserved goes first */
 
 /* ----------{ STRUCTURES AND TYPES }---------- */
 
@@ -38,35 +77,99 @@ typedef int bool;
 
 typedef void *(*task_func)(void *arg);
 
+typedef enum {
+    TASK_QUEUE_LIST,                /* linked list protected by pool_lock */
+    TASK_QUEUE_RING,                /* bounded lock-free ring with futex parking */
+    TASK_QUEUE_STEAL                /* per-worker work-stealing deques in front of the ring */
+} task_queue_type;
+
+typedef enum {
+    THREAD_STOPPED,                 /* not running (never started, or joined) */
+    THREAD_RUNNING,
+    THREAD_EXITED                   /* returned from thread_do() and waiting to be joined */
+} thread_state;
+
+typedef enum {
+    TASK_LANE_FAST,                 /* cheap tasks, e.g. requests answered from the file cache */
+    TASK_LANE_NORMAL,               /* everything that is not classified otherwise */
+    TASK_LANE_BULK                  /* expensive tasks: directory listings, uploads, large files */
+} task_lane;
+
 typedef struct Task {
     task_func func;
     void *arg;
+    task_lane lane;                 /* priority lane the task is queued in */
+    QueueNode node;                 /* links the task into the task queue */
+    bool owned;                     /* allocated by thread_pool_add_task() from task_objpool and freed once it has run */
+    long queued_ns;                 /* when the task was queued */
 } Task;
 
 typedef struct Thread {
     pthread_t thread;
     struct ThreadPool *pool;        /* reference to the pool that the thread is in (for access to its condition variables and mutexes) */
     int id;                         /* an id used for testing */
+    Deque *deque;                   /* tasks submitted by this thread (TASK_QUEUE_STEAL only; allocated by the worker itself) */
+    int cpu;                        /* CPU the worker is pinned to, or -1 */
+    unsigned int seed;              /* state of the random victim selection */
+    long oldest_ns;                 /* when the oldest task in deque was queued (an estimate; 0 once it is empty) */
+    thread_state state;             /* protected by pool_lock */
 } Thread;
 
+typedef struct Task_lane {
+    Queue *queue;                   /* tasks of the lane (TASK_QUEUE_LIST) or tasks spilled out of its full ring */
+    Mpmc_queue *ring;               /* lock-free queue of the lane's tasks (TASK_QUEUE_RING and TASK_QUEUE_STEAL) */
+    int overflow;                   /* tasks spilled into queue because the ring was full */
+    long served_ms;                 /* last time a task was taken from the lane or it was found empty */
+    long oldest_ns;                 /* when the oldest task in the lane was queued (an estimate; 0 once it is empty) */
+} Task_lane;
+
 typedef struct ThreadPool {
     Thread **threads;               /* threads of the thread pool */
-    volatile int active_threads;
+    int num_threads;                /* number of slots in threads (max_threads; the victims a thief looks at) */
+    int min_threads;                /* workers an elastic pool keeps when idle */
+    int max_threads;                /* ceiling of the pool's size */
+    volatile int active_threads;    /* running workers (protected by pool_lock) */
     volatile int working_threads;
     pthread_mutex_t pool_lock;      /* synchronize reading from and writing to the pool (all threads in the pool have access to the same shared thread pool struct) */
     pthread_cond_t task_available;  /* used to signal when the queue has an available task to be processed */
     pthread_cond_t threads_idle;    /* used to signal when there are no threads processing tasks */
-    Queue *task_queue;              /* queue of tasks that worker threads will be servicing */
     bool on;                        /* boolean that determines whether the thread pool is active or not */
+    bool elastic;                   /* a controller adjusts the number of workers (min_threads < max_threads) */
+    pthread_t controller;           /* thread running scale_do() (elastic pools only) */
+    pthread_cond_t controller_wake; /* wakes the controller up when the pool is destroyed */
+    int retire_requests;            /* workers thread_pool_shrink() asked to retire (protected by pool_lock) */
+    long wait_ns;                   /* total queue wait of the tasks taken since the controller's last sample */
+    long wait_count;                /* number of tasks taken since the controller's last sample */
+    task_queue_type queue_type;
+    Task_lane lanes[TASK_LANES];    /* queues of tasks that worker threads will be servicing, by priority */
+    unsigned char lane_schedule[TASK_LANE_SCHEDULE_MAX];   /* lane preferred by each dequeue, weighted */
+    int schedule_len;
+    unsigned int lane_tick;         /* position in lane_schedule */
+    unsigned int wake_seq;          /* futex word idle workers park on; bumped to wake them */
+    int sleepers;                   /* workers parked (or about to park) on wake_seq */
+    int wake_pending;               /* a wakeup has been sent that no parked worker has acted on yet */
+    int waiting;                    /* threads blocked in thread_pool_wait() */
+    const int *cpus;                /* CPUs workers are pinned to (worker i on cpus[i % num_cpus]), or NULL */
+    int num_cpus;
 } ThreadPool;
 
+extern Objpool task_objpool;        /* tasks allocated by thread_pool_add_task() */
+
 /* ----------{ FUNCTION PROTOTYPES }---------- */
 /* ----------< ThreadPool >---------- */
 extern ThreadPool *thread_pool_create(size_t pool_size);
+extern ThreadPool *thread_pool_create_with_queue(size_t pool_size, task_queue_type queue_type);
+extern ThreadPool *thread_pool_create_elastic(size_t min_threads, size_t max_threads, task_queue_type queue_type);
+extern ThreadPool *thread_pool_create_pinned(size_t min_threads, size_t max_threads, task_queue_type queue_type,
+                                             const int *cpus, int num_cpus);
 extern void thread_pool_destroy(ThreadPool *pool);
 extern void thread_pool_add_task(ThreadPool *pool, task_func function, void* arg);
+extern void thread_pool_submit(ThreadPool *pool, Task *task, task_func function, void *arg);
+extern void thread_pool_submit_lane(ThreadPool *pool, Task *task, task_lane lane, task_func function, void *arg);
 extern void thread_pool_wait(ThreadPool *pool);
-/* dynamic thread pool resizing (EXPERIMENTAL) */
+extern int thread_pool_queued(ThreadPool *pool);
+extern long thread_pool_queue_wait_ms(ThreadPool *pool);
+/* dynamic thread pool resizing (within max_threads) */
 extern void thread_pool_grow(ThreadPool *pool, size_t num);
 extern void thread_pool_shrink(ThreadPool *pool, size_t num);
 
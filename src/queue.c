@@ -6,6 +6,8 @@
  */
 #include "queue.h"
 
+Objpool queue_node_objpool = OBJPOOL_INITIALIZER(sizeof(QueueNode), 64, 4096);
+
 Queue *queue_create()
 {
     Queue *new_queue = (Queue *)calloc(1, sizeof(Queue));
@@ -28,7 +30,7 @@ void queue_destroy(Queue *queue)
     while(curr != NULL)
     {
         next = curr->next;
-        free(curr);
+        objpool_free(&queue_node_objpool, curr);
         curr = next;
     }
 
@@ -37,38 +39,56 @@ void queue_destroy(Queue *queue)
 
 void enqueue(Queue *queue, void *data)
 {
-    QueueNode *new_node = (QueueNode *)calloc(1, sizeof(QueueNode));
+    QueueNode *new_node = (QueueNode *)objpool_alloc(&queue_node_objpool);
 
-    if(new_node == NULL) {  //calloc failed
+    if(new_node == NULL) {  //allocation failed
         return;
     }
 
     new_node->data = data;
-    new_node->next = NULL;
-    new_node->prev = queue->tail;
+    enqueue_node(queue, new_node);
+}
+
+void *dequeue(Queue *queue)
+{
+    QueueNode *node = dequeue_node(queue);
+
+    if (node == NULL) {  // empty list
+        return NULL;
+    }
+
+    void *data = node->data;
+
+    objpool_free(&queue_node_objpool, node);
+
+    return data;
+}
+
+void enqueue_node(Queue *queue, QueueNode *node)
+{
+    node->next = NULL;
+    node->prev = queue->tail;
 
     if (queue->tail != NULL) {
-        queue->tail->next = new_node;
+        queue->tail->next = node;
     }
 
-    queue->tail = new_node;
+    queue->tail = node;
 
     if (queue->head == NULL) {
-        queue->head = new_node;
+        queue->head = node;
     }
 
     queue->length++;
 }
 
-void *dequeue(Queue *queue)
+QueueNode *dequeue_node(Queue *queue)
 {
     if (queue->head == NULL) {  // empty list
         return NULL;
     }
 
     QueueNode *node = queue->head;
-    
-    void *data = node->data;
 
     queue->head = node->next;
 
@@ -78,8 +98,7 @@ void *dequeue(Queue *queue)
         queue->tail = NULL;
     }
 
-    free(node);
     queue->length--;
 
-    return data;
-}
\ No newline at end of file
+    return node;
+}
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include "objpool.h"
 
 /* =========={ METHOD 2: DOUBLY-LINKED LIST }========== */
 // pros: all operations are O(1) and the queue can grow and shrink dynamically
@@ -39,12 +40,17 @@ typedef struct queue {
     QueueNode *tail;
 } Queue;
 
+extern Objpool queue_node_objpool;  /* nodes allocated by enqueue() */
+
 /* ----------{ FUNCTION PROTOTYPES }---------- */
 
 extern Queue *queue_create();
 extern void queue_destroy(Queue *queue);
 extern void enqueue(Queue *queue, void *data);
 extern void *dequeue(Queue *queue);
+/* intrusive variants: the caller owns the node (e.g. embedded in the data), nothing is allocated or freed */
+extern void enqueue_node(Queue *queue, QueueNode *node);
+extern QueueNode *dequeue_node(Queue *queue);
 
 /* =============== ALTERNATIVE IMPLEMENTATION =============== */
 
@@ -0,0 +1,449 @@
+/**
+ * @file reactor.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#define _GNU_SOURCE
+#include "reactor.h"
+
+/**
+ * @brief Puts a file descriptor into non-blocking mode
+ *
+ * @param[in] fd The file descriptor
+ * @return 0 on success, -1 otherwise
+ */
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1)
+    {
+        return -1;
+    }
+
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * @brief Removes a connection from the reactor's connection list and stops its timer
+ *
+ * The caller must hold conn_lock.
+ *
+ * @param[in] reactor The reactor that owns the connection
+ * @param[in] client The connection to be removed
+ */
+static void unlink_client(Reactor *reactor, Http_client *client)
+{
+    timer_cancel(&reactor->timers, &client->timer);
+
+    if (client->prev != NULL)
+        client->prev->next = client->next;
+    else
+        reactor->conns = client->next;
+
+    if (client->next != NULL)
+        client->next->prev = client->prev;
+
+    reactor->num_conns--;
+}
+
+/**
+ * @brief Closes a connection's socket and frees the connection
+ *
+ * Details: Closing the socket also removes it from the epoll instance.
+ *
+ * @param[in] client The connection
+ */
+static void destroy_client(Http_client *client)
+{
+    close(client->connfd);
+    release_input(client);
+    free_client(client);
+}
+
+/**
+ * @brief Accepts every pending connection on the listening socket
+ *
+ * Details: Because the listening socket is edge-triggered, connections are accepted until accept4() reports
+ *          that the backlog is empty. Every new socket is made non-blocking and registered with the epoll
+ *          instance as a one-shot, edge-triggered read event. A connection over the admission budget is answered
+ *          with 503 and closed right away (see admission.h).
+ *
+ * @param[in] reactor The reactor accepting the connections
+ */
+static void reactor_accept(Reactor *reactor)
+{
+    Http_server *server = reactor->server;
+
+    for (;;)
+    {
+        struct rusage usage;
+        struct timeval start, wall_start;
+
+        getrusage(RUSAGE_SELF, &usage);
+        start = usage.ru_utime;
+        gettimeofday(&wall_start, NULL);
+
+        SA_IN client_addr;
+        socklen_t addr_size = sizeof(client_addr);
+
+        int connfd = accept4(reactor->listenfd, (SA *)&client_addr, &addr_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                perror("accept");
+            return;
+        }
+
+        shed_reason reason = admission_check(&server->config, reactor->pool, true);
+        if (reason != ADMIT)
+        {
+            send_overloaded(connfd, reason);
+            close(connfd);
+            continue;
+        }
+
+        Http_client *client = create_client();
+        if (client == NULL)
+        {
+            close(connfd);
+            continue;
+        }
+
+        client->connfd = connfd;
+        client->client_addr = client_addr;
+        client->reactor = reactor;
+        client->state = CONN_IDLE;
+
+        printf("Server: got connection from %s\n", inet_ntoa(client->client_addr.sin_addr));
+        reactor->connection_count++;
+        printf("Server: connection count is %d\n", reactor->connection_count);
+
+        pthread_mutex_lock(&reactor->conn_lock);
+        client->next = reactor->conns;
+        if (reactor->conns != NULL)
+            reactor->conns->prev = client;
+        reactor->conns = client;
+        reactor->num_conns++;
+        timer_add(&reactor->timers, &client->timer, request_deadline(client, timer_now_ms()));
+        pthread_mutex_unlock(&reactor->conn_lock);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+        ev.data.ptr = client;
+        if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, connfd, &ev) == -1)
+        {
+            perror("epoll_ctl");
+            reactor_close(reactor, client);
+            continue;
+        }
+
+        if (server->config.enable_stats == ON)
+            calculate_usage(start, wall_start);
+    }
+}
+
+/**
+ * @brief Hands a connection with a complete request to a worker
+ *
+ * Details: The request is queued in the pool lane classify_request() picks for it, unless the pool is over its
+ *          admission budget, in which case the request is answered with 503 and the connection closed (see
+ *          admission.h). If multi-threading is disabled the request is served on the reactor thread instead.
+ *
+ * @param[in] reactor The reactor that owns the connection
+ * @param[in] client The connection
+ */
+static void reactor_dispatch(Reactor *reactor, Http_client *client)
+{
+    shed_reason reason = admission_check(&reactor->server->config, reactor->pool, false);
+    if (reason != ADMIT)
+    {
+        send_overloaded(client->connfd, reason);
+        reactor_close(reactor, client);
+        return;
+    }
+
+    client->state = CONN_BUSY;
+
+    if (reactor->server->config.enable_mt == ON)
+        thread_pool_submit_lane(reactor->pool, &client->task, classify_request(client, &reactor->server->config),
+                                reactor_serve, client);
+    else
+        reactor_serve(client);
+}
+
+/**
+ * @brief Reads from a readable connection
+ *
+ * Details: The connection's one-shot event has fired, so no other thread can be handling it. Whatever part of
+ *          the request has arrived is read and parsed on the reactor thread; only complete requests are
+ *          dispatched to a worker. Incomplete requests keep their input buffer and wait for more data.
+ *
+ * @param[in] reactor The reactor that owns the connection
+ * @param[in] client The readable connection
+ */
+static void reactor_read(Reactor *reactor, Http_client *client)
+{
+    switch (receive_request(client))
+    {
+    case RECV_DONE:
+        reactor_dispatch(reactor, client);
+        break;
+    case RECV_AGAIN:
+        reactor_rearm(reactor, client);
+        break;
+    case RECV_INVALID:
+        send_bad_request(client->connfd);
+        reactor_close(reactor, client);
+        break;
+    case RECV_CLOSED:
+        reactor_close(reactor, client);
+        break;
+    }
+}
+
+/**
+ * @brief Closes every connection whose deadline has passed
+ *
+ * Details: The expired timers are collected and their connections unlinked in a single pass under conn_lock; the
+ *          sockets are closed after the lock has been released. A connection that is being served keeps its last
+ *          timer until the worker re-arms it (so that reactor_dispatch() does not need the lock); if that timer
+ *          fires meanwhile it is simply dropped.
+ *
+ * @param[in] reactor The reactor that owns the connections
+ * @param[in] now_ms The current time (monotonic milliseconds)
+ */
+static void reactor_expire(Reactor *reactor, long now_ms)
+{
+    Http_client *expired = NULL;
+
+    pthread_mutex_lock(&reactor->conn_lock);
+
+    Timer *timer = timer_wheel_advance(&reactor->timers, now_ms);
+    while (timer != NULL)
+    {
+        Timer *next = timer->next;
+        Http_client *client = timer_entry(timer, Http_client, timer);
+
+        if (client->state == CONN_IDLE)
+        {
+            unlink_client(reactor, client);
+            client->next = expired;
+            expired = client;
+        }
+
+        timer = next;
+    }
+
+    pthread_mutex_unlock(&reactor->conn_lock);
+
+    while (expired != NULL)
+    {
+        Http_client *next = expired->next;
+        printf("Timeout, closing connection\n");
+        destroy_client(expired);
+        expired = next;
+    }
+}
+
+/**
+ * @brief Creates a reactor for a listening socket that is already bound
+ *
+ * @param[in] server The server whose configuration is used to serve requests
+ * @param[in] pool The thread pool that requests are dispatched to
+ * @param[in] listenfd The listening socket to accept connections from
+ * @return A pointer to the new reactor, or NULL if it could not be created
+ */
+Reactor *reactor_create(Http_server *server, ThreadPool *pool, int listenfd)
+{
+    Reactor *reactor = calloc(1, sizeof(Reactor));
+    if (reactor == NULL)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    reactor->server = server;
+    reactor->pool = pool;
+    reactor->listenfd = listenfd;
+
+    reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epfd == -1)
+    {
+        perror("epoll_create1");
+        free(reactor);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&reactor->conn_lock, NULL) != 0)
+    {
+        close(reactor->epfd);
+        free(reactor);
+        return NULL;
+    }
+    timer_wheel_init(&reactor->timers, timer_now_ms(), TIMER_TICK_MS);
+
+    /* a NULL data pointer identifies the listening socket */
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = NULL;
+    if (set_nonblocking(listenfd) == -1 || epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, listenfd, &ev) == -1)
+    {
+        perror("epoll_ctl");
+        pthread_mutex_destroy(&reactor->conn_lock);
+        close(reactor->epfd);
+        free(reactor);
+        return NULL;
+    }
+
+    return reactor;
+}
+
+/**
+ * @brief Destroys a reactor and closes every connection it still owns
+ *
+ * Details: The thread pool should be drained with thread_pool_wait() first so that no worker is still
+ *          using one of the connections.
+ *
+ * @param[in] reactor The reactor to be destroyed
+ */
+void reactor_destroy(Reactor *reactor)
+{
+    if (reactor == NULL)
+        return;
+
+    Http_client *client = reactor->conns;
+    while (client != NULL)
+    {
+        Http_client *next = client->next;
+        destroy_client(client);
+        client = next;
+    }
+
+    pthread_mutex_destroy(&reactor->conn_lock);
+    close(reactor->epfd);
+    free(reactor);
+}
+
+/**
+ * @brief Runs the event loop
+ *
+ * Details: Waits for socket events, accepts new connections, dispatches readable connections to the thread pool
+ *          and, every TIMER_TICK_MS milliseconds, closes the connections whose deadline has passed. This function
+ *          only returns if epoll_wait() fails.
+ *
+ * @param[in] reactor The reactor to run
+ */
+void reactor_run(Reactor *reactor)
+{
+    struct epoll_event events[MAX_EVENTS];
+    long now = timer_now_ms();
+
+    for (;;)
+    {
+        // wake up for every tick: workers add timers without waking the reactor
+        int num_events = epoll_wait(reactor->epfd, events, MAX_EVENTS, timer_wheel_timeout(&reactor->timers, now));
+        if (num_events == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            return;
+        }
+
+        for (int i = 0; i < num_events; i++)
+        {
+            Http_client *client = events[i].data.ptr;
+
+            if (client == NULL)
+                reactor_accept(reactor);
+            else if (events[i].events & EPOLLIN)
+                reactor_read(reactor, client);      // a hang up is noticed when recv() returns 0
+            else
+                reactor_close(reactor, client);     // EPOLLHUP or EPOLLERR without any pending data
+        }
+
+        now = timer_now_ms();
+        reactor_expire(reactor, now);
+    }
+}
+
+/**
+ * @brief Serves the requests received on a connection and hands the connection back to the reactor
+ *
+ * Details: Used as the thread pool task for a readable connection. Pipelined requests that arrived with the
+ *          first one are answered too (see serve_connection()). Keep-alive connections are re-armed in epoll;
+ *          every other connection is closed.
+ *
+ * @param[in] arg A pointer to the Http_client to be served
+ * @return This function does not return a value
+ */
+void *reactor_serve(void *arg)
+{
+    Http_client *client = (Http_client *)arg;
+    Reactor *reactor = client->reactor;
+
+    if (serve_connection(client, &reactor->server->config))
+        reactor_rearm(reactor, client);
+    else
+        reactor_close(reactor, client);
+
+    return NULL;
+}
+
+/**
+ * @brief Waits for more data on a connection
+ *
+ * Details: Used for keep-alive connections and for requests that have not been completely received yet.
+ *          Marks the connection idle, sets its timer to the deadline of what it is waiting for and re-enables its
+ *          one-shot event. Re-arming an edge-triggered socket reports data that is already buffered, so a request
+ *          that arrived while the worker was busy is not lost. A connection whose header or body deadline has
+ *          already passed is closed instead. The caller must not touch the connection after this call.
+ *
+ * @param[in] reactor The reactor that owns the connection
+ * @param[in] client The connection to be re-armed
+ */
+void reactor_rearm(Reactor *reactor, Http_client *client)
+{
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+    ev.data.ptr = client;
+
+    long now = timer_now_ms();
+    long deadline = request_deadline(client, now);
+    if (deadline <= now)
+    {
+        printf("Timeout, closing connection\n");
+        reactor_close(reactor, client);
+        return;
+    }
+
+    pthread_mutex_lock(&reactor->conn_lock);
+    client->state = CONN_IDLE;
+    timer_add(&reactor->timers, &client->timer, deadline);
+    int ret = epoll_ctl(reactor->epfd, EPOLL_CTL_MOD, client->connfd, &ev);
+    pthread_mutex_unlock(&reactor->conn_lock);
+
+    if (ret == -1)
+    {
+        perror("epoll_ctl");
+        reactor_close(reactor, client);
+    }
+}
+
+/**
+ * @brief Closes a connection and frees it
+ *
+ * @param[in] reactor The reactor that owns the connection
+ * @param[in] client The connection to be closed
+ */
+void reactor_close(Reactor *reactor, Http_client *client)
+{
+    pthread_mutex_lock(&reactor->conn_lock);
+    unlink_client(reactor, client);
+    pthread_mutex_unlock(&reactor->conn_lock);
+
+    destroy_client(client);
+}
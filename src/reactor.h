@@ -0,0 +1,61 @@
+/**
+ * @file reactor.h
+ * @brief An epoll based event loop that owns every socket of the server
+ * @authors
+ *
+ * Details:
+ * - The reactor owns the listening socket and every client socket. All of them are non-blocking and registered
+ *   with a single edge-triggered epoll instance.
+ * - When the listening socket becomes readable the reactor accepts connections until the backlog is drained.
+ * - Client sockets are registered with EPOLLONESHOT, so at most one thread handles a given connection at a time.
+ *   When a client socket becomes readable the reactor reads and incrementally parses whatever has arrived. Only
+ *   a completely received request is handed to the ThreadPool. Once the worker has answered the request (and any
+ *   requests pipelined behind it) it either re-arms the socket (keep-alive) or closes the connection.
+ * - An idle keep-alive connection is not tied to a thread; it only costs its Http_client structure. The first
+ *   block of its arena (ARENA_BLOCK_SIZE) is only attached while a request is in progress.
+ * - Every connection waiting in epoll has a timer in the reactor's timer wheel (see timerwheel.h) set to its idle,
+ *   header or body deadline (see request_deadline()). Setting and cancelling a timer is O(1), so the cost does not
+ *   grow with the number of connections. Each tick the reactor collects the expired timers and closes their
+ *   connections in one batch; no thread ever waits on a slow client.
+ *
+ * Assumptions/Limitations:
+ * - Exactly one thread calls reactor_run() on a given reactor. Several reactors can run side by side, each with
+ *   its own listening socket and thread pool (see shard.h).
+ * - Responses are written from worker threads. When the socket's send buffer is full the worker waits for it to
+ *   drain, so a slow reader still occupies a worker while its response is being sent.
+ *
+ * @date 2026-10-17
+ */
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <sys/epoll.h>
+#include "server.h"
+#include "admission.h"
+
+#define MAX_EVENTS 256
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Reactor {
+    int epfd;                       /* epoll instance watching the listening socket and all client sockets */
+    int listenfd;                   /* listening socket the reactor accepts connections from */
+    Http_server *server;            /* server whose configuration the reactor uses */
+    ThreadPool *pool;               /* workers that requests are dispatched to */
+    pthread_mutex_t conn_lock;      /* protects the connection list, the timer wheel and the state of idle connections */
+    Http_client *conns;             /* list of every open connection */
+    Timer_wheel timers;             /* deadlines of the connections waiting in epoll */
+    int num_conns;
+    int connection_count;           /* total number of connections accepted */
+} Reactor;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern Reactor *reactor_create(Http_server *server, ThreadPool *pool, int listenfd);
+extern void reactor_destroy(Reactor *reactor);
+extern void reactor_run(Reactor *reactor);
+extern void *reactor_serve(void *arg);
+extern void reactor_rearm(Reactor *reactor, Http_client *client);
+extern void reactor_close(Reactor *reactor, Http_client *client);
+
+#endif
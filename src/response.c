@@ -0,0 +1,135 @@
+/**
+ * @file response.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "server.h"
+
+#define RESPONSE_STR(x) #x
+#define RESPONSE_XSTR(x) RESPONSE_STR(x)
+
+typedef struct {
+    const char *text;
+    size_t len;
+} Header_block;
+
+#define HEADER_BLOCK(text) {text, sizeof(text) - 1}
+
+/* status line, Server and Connection; the keep-alive block ends inside the Keep-Alive header (see below) */
+#define STATUS_BLOCKS(status_line) {                                                                         \
+        HEADER_BLOCK(status_line "\r\nServer: " SERVER_NAME "\r\nConnection: close\r\n"),                   \
+        HEADER_BLOCK(status_line "\r\nServer: " SERVER_NAME "\r\nConnection: keep-alive\r\n"                \
+                     "Keep-Alive: timeout=" RESPONSE_XSTR(KEEP_ALIVE_TIMEOUT)),                             \
+    }
+
+static const Header_block status_blocks[HTTP_STATUSES][2] = {
+    [HTTP_STATUS_OK] = STATUS_BLOCKS("HTTP/1.1 200 OK"),
+    [HTTP_STATUS_NOT_FOUND] = STATUS_BLOCKS("HTTP/1.1 404 Not Found"),
+    [HTTP_STATUS_INTERNAL_ERROR] = STATUS_BLOCKS("HTTP/1.1 500 Internal Server Error"),
+};
+
+static __thread long date_second = -1;          /* second the calling thread's date_header was formatted for */
+static __thread char date_header[DATE_HEADER_SIZE];
+static __thread size_t date_len;
+
+/**
+ * @brief Appends bytes to a header being serialized (whatever does not fit is dropped)
+ */
+static inline void header_append(Header_buf *out, const char *data, size_t len)
+{
+    size_t room = sizeof(out->data) - out->len;
+
+    if (len > room)
+        len = room;
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+}
+
+/**
+ * @brief Appends the decimal representation of a number to a header being serialized
+ */
+static void header_append_number(Header_buf *out, unsigned long value)
+{
+    char digits[24];
+    char *p = digits + sizeof(digits);
+
+    do
+    {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    header_append(out, p, digits + sizeof(digits) - p);
+}
+
+/**
+ * @brief Returns the Date header for the current second
+ *
+ * Details: Each thread keeps its own copy and formats it again only when the second has changed, so the clock
+ *          (a coarse one, read without a system call) is the only cost of most calls and no lock is needed.
+ *
+ * @param[out] len The length of the header
+ * @return The header, including its line ending (valid until the calling thread's next call)
+ */
+const char *http_date(size_t *len)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+
+    if (now.tv_sec != date_second)
+    {
+        struct tm tm;
+        time_t second = now.tv_sec;
+
+        gmtime_r(&second, &tm);
+        date_len = strftime(date_header, sizeof(date_header), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        date_second = now.tv_sec;
+    }
+
+    *len = date_len;
+    return date_header;
+}
+
+/**
+ * @brief Serializes the header of an HTTP response
+ *
+ * @param[out] out The buffer the header is written to
+ * @param[in] res_header The HTTP response header structure
+ * @param[in] content_length The size of the body of the response
+ * @return The length of the header
+ */
+size_t render_response_header(Header_buf *out, const Http_response_header *res_header, long content_length)
+{
+    const Header_block *block = &status_blocks[res_header->status][res_header->keep_alive ? 1 : 0];
+    size_t len;
+
+    out->len = 0;
+    header_append(out, block->text, block->len);
+    if (res_header->keep_alive)
+    {
+        if (res_header->requests_left >= 0)
+        {
+            header_append(out, ", max=", 6);
+            header_append_number(out, res_header->requests_left);
+        }
+        header_append(out, "\r\n", 2);
+    }
+
+    const char *date = http_date(&len);
+    header_append(out, date, len);
+
+    header_append(out, "Content-Length: ", 16);
+    header_append_number(out, content_length > 0 ? content_length : 0);
+    header_append(out, "\r\n", 2);
+
+    if (res_header->content_type != NULL)
+    {
+        header_append(out, "Content-Type: ", 14);
+        header_append(out, res_header->content_type, strlen(res_header->content_type));
+        header_append(out, "\r\n", 2);
+    }
+
+    header_append(out, "\r\n", 2);
+    return out->len;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file response.h
+ * @brief Serialization of HTTP response headers from pre-rendered blocks
+ * @authors
+ *
+ * Details:
+ * - A response header is described by a few small fields (status, connection mode, Keep-Alive max and content
+ *   type) instead of a set of strings that have to be copied for every request.
+ * - The status line, the Server and Connection headers and the fixed part of the Keep-Alive header are rendered
+ *   at compile time, one block per (status, connection mode). Serializing a header copies that block and appends
+ *   the cached Date header, the Keep-Alive max, Content-Length and Content-Type directly into a small output
+ *   buffer (Header_buf); nothing is parsed and printf() is not involved.
+ * - The Date header is formatted once per second and thread (see http_date()).
+ *
+ * Assumptions/Limitations:
+ * - Only the statuses in http_status can be serialized; the fixed 400 and 503 responses are complete strings of
+ *   their own (see send_bad_request() and admission.h).
+ * - A header that does not fit in RESPONSE_HEADER_SIZE bytes is cut short. The fixed part is well below that,
+ *   which leaves more than MAX_CONTENT_TYPE_SIZE bytes for the content type.
+ *
+ * @date 2026-10-17
+ */
+#ifndef RESPONSE_H
+#define RESPONSE_H
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define RESPONSE_HEADER_SIZE 512    /* room for a serialized response header */
+#define DATE_HEADER_SIZE 48         /* "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n" and its terminator */
+#define SERVER_NAME "tinyserver"
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef enum {
+    HTTP_STATUS_OK,                 /* 200 OK */
+    HTTP_STATUS_NOT_FOUND,          /* 404 Not Found */
+    HTTP_STATUS_INTERNAL_ERROR,     /* 500 Internal Server Error */
+    HTTP_STATUSES
+} http_status;
+
+typedef struct {
+    http_status status;
+    int keep_alive;                 /* 1 for Connection: keep-alive (with a Keep-Alive header), 0 for close */
+    int requests_left;              /* max= of the Keep-Alive header, or -1 to leave it out */
+    const char *content_type;       /* a MIME type that outlives the response, or NULL to leave it out */
+} Http_response_header;
+
+typedef struct {
+    size_t len;
+    char data[RESPONSE_HEADER_SIZE];
+} Header_buf;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern const char *http_date(size_t *len);
+extern size_t render_response_header(Header_buf *out, const Http_response_header *res_header, long content_length);
+
+#endif
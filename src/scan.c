@@ -0,0 +1,205 @@
+/**
+ * @file scan.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include <immintrin.h>
+#include "scan.h"
+
+/* characters allowed in a token (RFC 9110 section 5.6.2) */
+static const unsigned char tchar[256] = {
+    ['0' ... '9'] = 1, ['a' ... 'z'] = 1, ['A' ... 'Z'] = 1,
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1,
+    ['+'] = 1, ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+};
+
+/* ----------< Scalar >---------- */
+
+static size_t path_scalar(const char *buf, size_t pos, size_t len)
+{
+    for (; pos < len; pos++)
+    {
+        unsigned char c = buf[pos];
+        if (c <= ' ' || c == 0x7f)
+            break;
+    }
+    return pos;
+}
+
+static size_t name_scalar(const char *buf, size_t pos, size_t len)
+{
+    while (pos < len && tchar[(unsigned char)buf[pos]])
+        pos++;
+    return pos;
+}
+
+static size_t value_scalar(const char *buf, size_t pos, size_t len)
+{
+    for (; pos < len; pos++)
+    {
+        unsigned char c = buf[pos];
+        if ((c < ' ' && c != '\t') || c == 0x7f)
+            break;
+    }
+    return pos;
+}
+
+/* ----------< SSE4.2 >---------- */
+
+/* pairs of inclusive byte ranges; PCMPESTRI reports the first byte that falls into any of them */
+static const char path_ranges[16] = {'\0', ' ', 0x7f, 0x7f};
+static const char name_ranges[16] = {'\0', ' ', '"', '"', '(', ')', ',', ',', '/', '/', ':', '@', '[', ']', '{', (char)0xff};
+static const char value_ranges[16] = {'\0', 0x08, 0x0a, 0x1f, 0x7f, 0x7f};
+
+#define SSE42_SCAN(name, ranges, num_ranges, fallback)                                                         \
+    __attribute__((target("sse4.2"))) static size_t name(const char *buf, size_t pos, size_t len)             \
+    {                                                                                                         \
+        const __m128i set = _mm_loadu_si128((const __m128i *)ranges);                                         \
+        for (; pos + 16 <= len; pos += 16)                                                                    \
+        {                                                                                                     \
+            __m128i block = _mm_loadu_si128((const __m128i *)(buf + pos));                                    \
+            int index = _mm_cmpestri(set, num_ranges, block, 16,                                              \
+                                     _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);           \
+            if (index != 16)                                                                                  \
+                return pos + index;                                                                           \
+        }                                                                                                     \
+        return fallback(buf, pos, len);                                                                       \
+    }
+
+SSE42_SCAN(path_sse42, path_ranges, 4, path_scalar)
+SSE42_SCAN(name_sse42, name_ranges, 16, name_scalar)
+SSE42_SCAN(value_sse42, value_ranges, 6, value_scalar)
+
+/* ----------< AVX2 >---------- */
+
+/* bytes are compared as signed values, so anything >= 0x80 is negative and below every ASCII range */
+#define IN_RANGE(v, lo, hi) \
+    _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((lo) - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), v))
+
+/**
+ * @brief Returns the offset of the first set bit of a byte mask, or -1 if it is empty
+ */
+__attribute__((target("avx2"))) static inline int first_byte(__m256i mask)
+{
+    unsigned int bits = (unsigned int)_mm256_movemask_epi8(mask);
+    return bits ? __builtin_ctz(bits) : -1;
+}
+
+__attribute__((target("avx2"))) static size_t path_avx2(const char *buf, size_t pos, size_t len)
+{
+    for (; pos + 32 <= len; pos += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+        // stop at 0x00-0x20 and 0x7f; bytes >= 0x80 are allowed, as in the scalar version
+        __m256i stop = _mm256_or_si256(IN_RANGE(v, 0x00, 0x20), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+        int index = first_byte(stop);
+        if (index != -1)
+            return pos + index;
+    }
+    return path_scalar(buf, pos, len);
+}
+
+__attribute__((target("avx2"))) static size_t name_avx2(const char *buf, size_t pos, size_t len)
+{
+    for (; pos + 32 <= len; pos += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+        // the characters real header names are made of: letters, digits and '-'
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i ok = _mm256_or_si256(IN_RANGE(lower, 'a', 'z'), IN_RANGE(v, '0', '9'));
+        ok = _mm256_or_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+        int index = first_byte(_mm256_xor_si256(ok, _mm256_set1_epi8(-1)));
+        if (index != -1)
+            return pos + index;
+    }
+    return name_scalar(buf, pos, len);
+}
+
+__attribute__((target("avx2"))) static size_t value_avx2(const char *buf, size_t pos, size_t len)
+{
+    for (; pos + 32 <= len; pos += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + pos));
+        __m256i ctl = IN_RANGE(v, 0x00, 0x1f);
+        ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), ctl);
+        ctl = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+        int index = first_byte(ctl);
+        if (index != -1)
+            return pos + index;
+    }
+    return value_scalar(buf, pos, len);
+}
+
+/* ----------< Selection >---------- */
+
+scan_func scan_path = path_scalar;
+scan_func scan_header_name = name_scalar;
+scan_func scan_header_value = value_scalar;
+
+/**
+ * @brief Picks a scanning implementation
+ *
+ * Details: If the CPU does not support the requested level, the best supported level below it is used.
+ *
+ * @param[in] level The implementation to use
+ * @return The implementation that was actually selected
+ */
+scan_level scan_select(scan_level level)
+{
+    __builtin_cpu_init();
+
+    if (level >= SCAN_AVX2 && __builtin_cpu_supports("avx2"))
+    {
+        scan_path = path_avx2;
+        scan_header_name = name_avx2;
+        scan_header_value = value_avx2;
+        return SCAN_AVX2;
+    }
+
+    if (level >= SCAN_SSE42 && __builtin_cpu_supports("sse4.2"))
+    {
+        scan_path = path_sse42;
+        scan_header_name = name_sse42;
+        scan_header_value = value_sse42;
+        return SCAN_SSE42;
+    }
+
+    scan_path = path_scalar;
+    scan_header_name = name_scalar;
+    scan_header_value = value_scalar;
+    return SCAN_SCALAR;
+}
+
+/**
+ * @brief Picks the fastest scanning implementation the CPU supports
+ *
+ * Details: Should be called once before the server starts accepting connections.
+ *
+ * @return The implementation that was selected
+ */
+scan_level scan_init()
+{
+    return scan_select(SCAN_BEST);
+}
+
+/**
+ * @brief Returns a printable name for a scanning implementation
+ *
+ * @param[in] level The implementation
+ * @return The name of the implementation
+ */
+const char *scan_level_name(scan_level level)
+{
+    switch (level)
+    {
+    case SCAN_AVX2:
+        return "avx2";
+    case SCAN_SSE42:
+        return "sse4.2";
+    case SCAN_SCALAR:
+        return "scalar";
+    default:
+        return "best";
+    }
+}
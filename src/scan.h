@@ -0,0 +1,52 @@
+/**
+ * @file scan.h
+ * @brief SIMD accelerated scanning of HTTP request lines and headers
+ * @authors
+ *
+ * Details:
+ * The request parser spends most of its time walking over the bytes of the path, header names and header
+ * values looking for the byte that ends them (a space, a colon or a CR). These functions find that byte for a
+ * whole block of input at a time:
+ * - SSE4.2: PCMPESTRI with a set of byte ranges checks 16 bytes per instruction.
+ * - AVX2: range comparisons on 32 bytes at a time.
+ * - Scalar: a byte at a time, used when neither instruction set is available and for the last few bytes of
+ *   the buffer.
+ * The implementation is picked once at startup with CPUID (scan_init()), so the cost of parsing a header stays
+ * proportional to the number of delimiters rather than the number of bytes, even for large cookies.
+ *
+ * Every function returns the offset of the first byte in [pos, len) that the parser has to look at, or len if
+ * there is none. The SIMD versions may stop early at a byte that is valid but unusual (for example '|' in a
+ * header name); the parser checks that byte itself and continues scanning after it.
+ *
+ * Assumptions/Limitations:
+ * Bytes are never read past len.
+ *
+ * @date 2026-10-17
+ */
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef enum {
+    SCAN_SCALAR,
+    SCAN_SSE42,
+    SCAN_AVX2,
+    SCAN_BEST           /* the best implementation the CPU supports */
+} scan_level;
+
+typedef size_t (*scan_func)(const char *buf, size_t pos, size_t len);
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern scan_func scan_path;             /* stops at a space, control character or DEL */
+extern scan_func scan_header_name;      /* stops at a colon or any byte that is not a token character */
+extern scan_func scan_header_value;     /* stops at CR, LF or any other control character except HTAB */
+
+extern scan_level scan_init();
+extern scan_level scan_select(scan_level level);
+extern const char *scan_level_name(scan_level level);
+
+#endif
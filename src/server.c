@@ -6,6 +6,7 @@
  */
 
 #include "server.h"
+#include "admission.h"
 
 const char html_start[] = "<html><head><style>"
                           "body {font-family: 'Helvetica Neue', sans-serif; margin:0; padding:0; background-color: #fafafa; color: #333;}"
@@ -58,184 +59,730 @@ void check_err(int val, char *msg)
 }
 
 /**
- * @brief Parses a specific field from a source string and copies it to a destination string
+ * @brief Sends an entire buffer over a non-blocking socket
  *
- * This function takes a source string, a destination string, and a field name as input. It finds
- * the field in the source string, and copies its value to the destination string. If the field is
- * not found, it prints a message and returns.
+ * Client sockets are owned by the reactor and are non-blocking. When the socket's send buffer is full this
+ * function waits (up to SEND_TIMEOUT_MS) for it to become writable again instead of giving up.
  *
- * @param[in] src The source string to parse
- * @param[out] des The destination string where the field value will be copied
- * @param[in] field The field to be parsed from the source string
- * @return This function does not return a value
+ * @param[in] connfd The connection file descriptor
+ * @param[in] buf The data to be sent
+ * @param[in] len The number of bytes to be sent
+ * @return The number of bytes sent, or -1 if there was an error
  */
-void parse_field(char *src, char *des, const char *field)
+ssize_t send_all(const int connfd, const void *buf, size_t len)
 {
-    char *start, *end;
-    // Find the field in the source string
-    start = strstr(src, field);
-    if (start == NULL)
-    {
-        printf("Field not found.\n");
-        return;
-    }
+    return send_all_flags(connfd, buf, len, 0);
+}
 
-    // Skip the field and the following colon and space
-    start += strlen(field) + 2;
+/**
+ * @brief Sends an entire buffer over a non-blocking socket with extra send() flags
+ *
+ * Same as send_all(). With MSG_MORE the kernel holds a partial segment back until more data is written to the
+ * socket.
+ *
+ * @param[in] connfd The connection file descriptor
+ * @param[in] buf The data to be sent
+ * @param[in] len The number of bytes to be sent
+ * @param[in] flags Flags passed to send() in addition to MSG_NOSIGNAL
+ * @return The number of bytes sent, or -1 if there was an error
+ */
+ssize_t send_all_flags(const int connfd, const void *buf, size_t len, int flags)
+{
+    const char *data = buf;
+    size_t sent = 0;
 
-    // Find the end of the field value
-    end = strchr(start, '\n');
-    if (end == NULL)
+    while (sent < len)
     {
-        end = src + strlen(src);
+        ssize_t n = send(connfd, data + sent, len - sent, MSG_NOSIGNAL | flags);
+        if (n >= 0)
+        {
+            sent += n;
+            continue;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        struct pollfd pfd = {.fd = connfd, .events = POLLOUT};
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0)
+            return -1;
     }
 
-    // Copy the field value to the destination string
-    strncpy(des, start, end - start);
-    des[end - start] = '\0'; // Null terminate the destination string
+    return sent;
 }
 
 /**
- * @brief Handles an HTTP request
+ * @brief Sends an entire file over a non-blocking socket
  *
- * This function takes a connection file descriptor and an HTTP request header as input. It
- * reads the request from the connection, parses the request method and path, and fills the
- * request header structure accordingly. If there is an error during the process, it prints
- * an error message and returns -1.
+ * Works like send_all() but uses sendfile() so the file contents never have to be copied into user space.
  *
  * @param[in] connfd The connection file descriptor
- * @param[out] req_header The HTTP request header structure to be filled
- * @return 0 if the request was handled successfully, -1 otherwise
+ * @param[in] fd The file descriptor of the file to be sent
+ * @param[in] file_size The number of bytes to be sent
+ * @return 0 if the whole file was sent, -1 otherwise
  */
-int handle_http_request(const int connfd, Http_request_header *req_header)
+int sendfile_all(const int connfd, int fd, long file_size)
 {
+    off_t offset = 0;
 
-    memset(req_header, 0, sizeof(Http_request_header));
-
-    ssize_t bytes_read = recv(connfd, req_header->buffer, MAX_HEADER_SIZE, 0);
-    if (bytes_read < 0)
+    while (offset < file_size)
     {
-        printf("Error reading from socket\n");
-        return -1;
+        ssize_t n = sendfile(connfd, fd, &offset, file_size - offset);
+        if (n > 0)
+            continue;
+
+        if (n == 0)
+            return -1; // the file was truncated while it was being sent
+
+        if (errno == EINTR)
+            continue;
+
+        struct pollfd pfd = {.fd = connfd, .events = POLLOUT};
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0)
+            return -1;
     }
-    if (bytes_read < 3)
+
+    return 0;
+}
+
+/**
+ * @brief Sends several buffers over a non-blocking socket with as few system calls as possible
+ *
+ * Like send_all(), this waits for the socket to become writable when its send buffer is full. The iovec array
+ * is modified as data is sent.
+ *
+ * @param[in] connfd The connection file descriptor
+ * @param[in, out] iov The buffers to be sent
+ * @param[in] iovcnt The number of buffers
+ * @return The number of bytes sent, or -1 if there was an error
+ */
+ssize_t sendv_all(const int connfd, struct iovec *iov, int iovcnt)
+{
+    size_t sent = 0;
+    struct msghdr msg = {0};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    while (msg.msg_iovlen > 0)
     {
-        printf("Invalid request\n");
-        return -1;
+        ssize_t n = sendmsg(connfd, &msg, MSG_NOSIGNAL);
+        if (n >= 0)
+        {
+            sent += n;
+
+            // skip the buffers that were sent completely and advance into the first one that was not
+            while (msg.msg_iovlen > 0 && (size_t)n >= msg.msg_iov->iov_len)
+            {
+                n -= msg.msg_iov->iov_len;
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            }
+            if (msg.msg_iovlen > 0)
+            {
+                msg.msg_iov->iov_base = (char *)msg.msg_iov->iov_base + n;
+                msg.msg_iov->iov_len -= n;
+            }
+            continue;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        struct pollfd pfd = {.fd = connfd, .events = POLLOUT};
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0)
+            return -1;
     }
-    req_header->buffer[bytes_read] = '\0';
 
-    printf("Request header:\n%s\n", req_header->buffer);
+    return sent;
+}
 
-    // see what the request is (GET, POST, etc)
-    regex_t regex;
-    regmatch_t pmatch[3]; // only need 1 match for file path
-    int match;
+/**
+ * @brief Returns the first byte of the current request in a connection's input buffer
+ *
+ * Details: The parser's views are offsets from this byte. It is only past the start of the buffer while
+ *          pipelined requests that arrived together are being answered one after the other.
+ */
+static inline const char *request_data(const Http_input *in)
+{
+    return in->data + in->start;
+}
+
+/**
+ * @brief Returns how many bytes a connection's input buffer may hold
+ *
+ * Details: The headers of a request must fit in MAX_HEADER_SIZE bytes. Once they are complete the buffer may also
+ *          hold the body announced by Content-Length (which the parser caps at MAX_REQUEST_BODY_SIZE) and up to
+ *          MAX_HEADER_SIZE bytes of a request pipelined after it.
+ */
+static size_t input_limit(Http_input *in)
+{
+    if (in->parser.state != PS_BODY)
+        return in->start + MAX_HEADER_SIZE;
 
-    // ^ means start of string
-    match = regcomp(&regex, "^GET", 0);
-    match = regexec(&regex, req_header->buffer, 2, pmatch, 0);
-    if (match == 0)
+    return in->start + http_parser_request_len(&in->parser) + MAX_HEADER_SIZE;
+}
+
+/**
+ * @brief Runs the parser over the bytes of the current request received so far
+ *
+ * @param[in] in The input buffer of a connection
+ * @return RECV_DONE, RECV_AGAIN or RECV_INVALID
+ */
+static Recv_status parse_input(Http_input *in)
+{
+    switch (http_parser_execute(&in->parser, request_data(in), in->len - in->start))
     {
-        req_header->method = HTTP_GET;
+    case PARSE_DONE:
+        return RECV_DONE;
+    case PARSE_AGAIN:
+        return in->len < input_limit(in) ? RECV_AGAIN : RECV_INVALID; // the request does not fit
+    default:
+        return RECV_INVALID;
     }
+}
 
-    match = regcomp(&regex, "^POST", 0);
-    match = regexec(&regex, req_header->buffer, 2, pmatch, 0);
-    if (match == 0)
+Objpool client_objpool = OBJPOOL_INITIALIZER(sizeof(Http_client), CLIENT_POOL_BATCH, CLIENT_POOL_MAX_FREE);
+Objpool arena_objpool = OBJPOOL_INITIALIZER(ARENA_BLOCK_SIZE, ARENA_POOL_BATCH, ARENA_POOL_MAX_FREE);
+int num_clients;
+
+/**
+ * @brief Creates a connection
+ *
+ * Details: The connection is taken from client_objpool, so under steady load a new connection reuses the memory
+ *          of a closed one. Its arena has no block yet: a block is only attached while a request is being
+ *          received and answered (see get_input() and release_input()), so an idle connection costs no more than
+ *          its Http_client. The connection is freed with free_client() after release_input().
+ *
+ * @return The connection with every field zeroed, or NULL if it could not be allocated
+ */
+Http_client *create_client()
+{
+    Http_client *client = objpool_alloc(&client_objpool);
+    if (client == NULL)
     {
-        req_header->method = HTTP_POST;
+        perror("objpool_alloc");
+        return NULL;
+    }
+
+    memset(client, 0, sizeof(*client));
+    arena_init(&client->arena, NULL, 0);
+    __atomic_add_fetch(&num_clients, 1, __ATOMIC_RELAXED);
 
-        char *body_start = strstr(req_header->buffer, "\r\n\r\n");
-        if (body_start != NULL)
+    return client;
+}
+
+/**
+ * @brief Frees a connection created with create_client()
+ *
+ * @param[in] client The connection (its input must already have been released)
+ */
+void free_client(Http_client *client)
+{
+    __atomic_sub_fetch(&num_clients, 1, __ATOMIC_RELAXED);
+    objpool_free(&client_objpool, client);
+}
+
+/**
+ * @brief Returns a connection's input buffer, allocating it if the connection was idle
+ *
+ * Details: A request starts by attaching an ARENA_BLOCK_SIZE block from arena_objpool to the connection's arena,
+ *          so a request that fits in it is received and answered without any call to malloc().
+ *
+ * @param[in] client The HTTP client
+ * @return The input buffer, or NULL if it could not be allocated
+ */
+static Http_input *get_input(Http_client *client)
+{
+    if (client->in == NULL)
+    {
+        if (client->arena.base == NULL)
         {
-            body_start += 4; // skip past the "\r\n\r\n"
-            char *body = strdup(body_start);
-            // now `body` contains the body of the request
-            strcpy(req_header->body, body);
+            void *block = objpool_alloc(&arena_objpool);
+            if (block == NULL)
+            {
+                perror("objpool_alloc");
+                return NULL;
+            }
+            arena_init(&client->arena, block, ARENA_BLOCK_SIZE);
         }
-        else
+
+        Http_input *in = arena_alloc(&client->arena, sizeof(Http_input));
+        if (in == NULL || (in->data = arena_alloc(&client->arena, INPUT_INITIAL_SIZE)) == NULL)
         {
-            strcpy(req_header->body, " ");
-            printf("Error parsing body\n");
+            perror("arena_alloc");
+            return NULL;
         }
+
+        in->start = 0;
+        in->len = 0;
+        in->size = INPUT_INITIAL_SIZE;
+        in->header_deadline = 0;
+        in->body_deadline = 0;
+        http_parser_init(&in->parser);
+        client->in = in;
     }
 
-    match = regcomp(&regex, "^(GET|POST) ([^ ]*) HTTP", REG_EXTENDED);
-    if (match != 0)
+    return client->in;
+}
+
+/**
+ * @brief Makes room for more bytes in a connection's input buffer
+ *
+ * Details: The buffer is doubled until it can hold needed bytes. Since the parser only keeps offsets into the
+ *          buffer, it can be moved while a request is being parsed.
+ *
+ * @param[in] client The HTTP client
+ * @param[in] needed The number of bytes the buffer must be able to hold
+ * @return 0 on success, -1 if needed is larger than input_limit() or the buffer could not be grown
+ */
+static int grow_input(Http_client *client, size_t needed)
+{
+    Http_input *in = client->in;
+    size_t limit = input_limit(in);
+
+    if (needed <= in->size)
+        return 0;
+    if (needed > limit)
+        return -1;
+
+    size_t size = in->size;
+    while (size < needed)
+        size = size * 2 < limit ? size * 2 : limit;
+
+    char *data = arena_grow(&client->arena, in->data, in->len, size);
+    if (data == NULL)
     {
-        printf("Error compiling regex\n");
+        perror("arena_grow");
         return -1;
     }
 
-    // Execute the regular expression
-    match = regexec(&regex, req_header->buffer, 3, pmatch, 0);
-    if (match != 0)
+    in->data = data;
+    in->size = size;
+    return 0;
+}
+
+/**
+ * @brief Receives as much of a request as is available on a non-blocking socket
+ *
+ * This function reads from the client's socket into the connection's input buffer and feeds the new bytes to
+ * the incremental parser. It stops when a complete request has been received or when the socket has no more
+ * data. A partially received request stays in the input buffer until the next call.
+ *
+ * @param[in] client The HTTP client
+ * @return RECV_DONE if a complete request is ready, RECV_AGAIN if more bytes are needed, RECV_CLOSED if the
+ *         client hung up and RECV_INVALID if the request is malformed or too large
+ */
+Recv_status receive_request(Http_client *client)
+{
+    Http_input *in = get_input(client);
+    if (in == NULL)
+        return RECV_CLOSED;
+
+    for (;;)
     {
-        printf("Error executing regex\n");
-        return -1;
+        if (in->len == in->size && grow_input(client, in->len + 1) == -1)
+            return RECV_INVALID;
+
+        ssize_t bytes_read = recv(client->connfd, in->data + in->len, in->size - in->len, 0);
+        if (bytes_read > 0)
+        {
+            in->len += bytes_read;
+
+            Recv_status status = parse_input(in);
+            if (status != RECV_AGAIN)
+                return status;
+            continue;
+        }
+
+        if (bytes_read == 0)
+            return RECV_CLOSED;
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return RECV_AGAIN;
+
+        printf("Error reading from socket\n");
+        return RECV_CLOSED;
+    }
+}
+
+/**
+ * @brief Adds bytes that have already been received to a connection's request
+ *
+ * Used by the io_uring backend, which receives into its own buffers.
+ *
+ * @param[in] client The HTTP client
+ * @param[in] data The received bytes
+ * @param[in] len The number of received bytes
+ * @return RECV_DONE if a complete request is ready, RECV_AGAIN if more bytes are needed and RECV_INVALID if the
+ *         request is malformed or too large
+ */
+Recv_status feed_request(Http_client *client, const char *data, size_t len)
+{
+    Http_input *in = get_input(client);
+    if (in == NULL)
+        return RECV_CLOSED;
+
+    if (grow_input(client, in->len + len) == -1)
+        return RECV_INVALID;
+
+    memcpy(in->data + in->len, data, len);
+    in->len += len;
+
+    return parse_input(in);
+}
+
+/**
+ * @brief Frees a connection's input buffer and everything else allocated for its request
+ *
+ * Details: The first block of the arena goes back to arena_objpool, so the connection holds no block while idle.
+ *
+ * @param[in] client The HTTP client
+ */
+void release_input(Http_client *client)
+{
+    arena_reset(&client->arena);
+    if (client->arena.base != NULL)
+        objpool_free(&arena_objpool, client->arena.base);
+    arena_init(&client->arena, NULL, 0);
+    client->in = NULL;
+}
+
+/**
+ * @brief Moves on to the next request once the current one has been answered
+ *
+ * Details: Bytes received after the end of the current request belong to the next one (pipelining). If they
+ *          hold a complete request it is parsed where it is, so it can be answered from the same buffer without
+ *          copying. A partial request is moved to the front of the buffer, where the rest of it is received, so
+ *          no new buffer is allocated for it. Without any such bytes the input buffer is released.
+ *
+ * @param[in] client The HTTP client whose current request has been answered
+ * @return RECV_DONE if the next request is already complete, RECV_AGAIN if more bytes are needed and RECV_INVALID
+ *         if the next request is malformed
+ */
+Recv_status next_request(Http_client *client)
+{
+    Http_input *in = client->in;
+    size_t end = in->start + http_parser_request_len(&in->parser);
+    size_t left = in->len - end;
+
+    if (left == 0)
+    {
+        release_input(client);
+        return RECV_AGAIN;
+    }
+
+    in->start = end;
+    http_parser_init(&in->parser);
+
+    Recv_status status = parse_input(in);
+    if (status != RECV_AGAIN)
+        return status;
+
+    // the parser's views are relative to the start of the request, so they stay valid
+    memmove(in->data, in->data + end, left);
+    in->start = 0;
+    in->len = left;
+    in->header_deadline = 0;
+    in->body_deadline = 0;
+
+    return status;
+}
+
+/**
+ * @brief Returns the time by which a connection waiting for data must have received it
+ *
+ * Details: An idle connection gets KEEP_ALIVE_TIMEOUT seconds from now. A request whose headers are incomplete
+ *          gets HEADER_TIMEOUT seconds from the first time this is asked for it, i.e. from when its first bytes
+ *          were read, and a request whose body is incomplete BODY_TIMEOUT seconds from when its headers were
+ *          complete. The last two are recorded in the input buffer, so later reads do not extend them.
+ *
+ * @param[in] client The HTTP client that is about to wait for data
+ * @param[in] now_ms The current time (monotonic milliseconds)
+ * @return The deadline (monotonic milliseconds)
+ */
+long request_deadline(Http_client *client, long now_ms)
+{
+    Http_input *in = client->in;
+
+    if (in == NULL)
+        return now_ms + KEEP_ALIVE_TIMEOUT * 1000L;
+
+    if (in->parser.state != PS_BODY)
+    {
+        if (in->header_deadline == 0)
+            in->header_deadline = now_ms + HEADER_TIMEOUT * 1000L;
+        return in->header_deadline;
     }
 
-    // Extract the path from the request line
-    size_t path_length = pmatch[2].rm_eo - pmatch[2].rm_so;
-    strncpy(req_header->path, req_header->buffer + pmatch[2].rm_so, path_length);
-    req_header->path[path_length] = '\0'; // Null-terminate the path
+    if (in->body_deadline == 0)
+        in->body_deadline = now_ms + BODY_TIMEOUT * 1000L;
+    return in->body_deadline;
+}
+
+/**
+ * @brief Answers a malformed request with 400 Bad Request
+ *
+ * The response is sent without waiting; the caller closes the connection afterwards.
+ *
+ * @param[in] connfd The connection file descriptor
+ */
+void send_bad_request(const int connfd)
+{
+    static const char response[] = "HTTP/1.1 400 Bad Request\r\n"
+                                   "Content-Length: 0\r\n"
+                                   "Connection: close\r\n"
+                                   "Server: tinyserver\r\n\r\n";
+
+    if (send(connfd, response, sizeof(response) - 1, MSG_NOSIGNAL | MSG_DONTWAIT) == -1)
+        perror("send");
+}
 
-    // Clean up
-    regfree(&regex);
+/**
+ * @brief Copies the bytes of a view into a fixed size string
+ *
+ * @param[out] des The destination string
+ * @param[in] size The size of the destination string
+ * @param[in] buf The buffer the view refers to
+ * @param[in] view The view
+ */
+static void copy_view(char *des, size_t size, const char *buf, Http_view view)
+{
+    size_t len = view.len < size - 1 ? view.len : size - 1;
 
-    parse_field(req_header->buffer, req_header->host, "Host");
+    memcpy(des, VIEW_PTR(buf, view), len);
+    des[len] = '\0';
+}
+
+/**
+ * @brief Handles an HTTP request
+ *
+ * This function takes a completely received and parsed request and fills the request header
+ * structure accordingly. If the request uses a method the server does not support, it prints
+ * an error message and returns -1.
+ *
+ * @param[in] client The HTTP client whose input buffer holds the parsed request
+ * @param[out] req_header The HTTP request header structure to be filled
+ * @return 0 if the request was handled successfully, -1 otherwise
+ */
+int handle_http_request(Http_client *client, Http_request_header *req_header)
+{
+    Http_input *input = client->in;
+    Http_parser *parser = &input->parser;
+    const char *buf = request_data(input);
+
+    printf("Request header:\n%.*s\n", (int)parser->header_len, buf);
+
+    // see what the request is (GET, POST, etc)
+    if (VIEW_EQ(buf, parser->method, "GET"))
+    {
+        req_header->method = HTTP_GET;
+    }
+    else if (VIEW_EQ(buf, parser->method, "POST"))
+    {
+        req_header->method = HTTP_POST;
+    }
+    else
+    {
+        printf("Unsupported method\n");
+        return -1;
+    }
+
+    copy_view(req_header->path, sizeof(req_header->path), buf, parser->path);
+    copy_view(req_header->version, sizeof(req_header->version), buf, parser->version);
+    copy_view(req_header->host, sizeof(req_header->host), buf, parser->host);
+    copy_view(req_header->connection, sizeof(req_header->connection), buf, parser->connection);
+
+    // the body is left in the input buffer until a handler asks for it
+    req_header->input = input;
+    req_header->arena = &client->arena;
+    req_header->body_len = parser->content_length > 0 ? parser->content_length : 0;
+    req_header->body = NULL;
+    req_header->file = NULL;
 
     return 0;
 }
 
 /**
- * @brief Sends an HTTP response
+ * @brief Picks the priority lane of the thread pool a completely received request is queued in
+ *
+ * This function only uses what the server already knows without touching the disk: the method, the fd cache's
+ * entry for the target and whether the file cache holds it. Requests answered from memory (cached files, missing
+ * files) go to the fast lane; directory listings, uploads and files too large to be cached go to the bulk lane;
+ * everything else, including targets the server has not seen yet, goes to the normal lane.
+ *
+ * @param[in] client The HTTP client whose input buffer holds the parsed request
+ * @param[in] server_config The server configuration
+ * @return The lane
+ */
+task_lane classify_request(Http_client *client, Server_config *server_config)
+{
+    Http_parser *parser = &client->in->parser;
+    const char *buf = request_data(client->in);
+    char full_path[MAX_ROOT_DIR_SIZE + MAX_PATH_SIZE];
+    task_lane lane = TASK_LANE_NORMAL;
+
+    if (VIEW_EQ(buf, parser->method, "POST"))
+        return TASK_LANE_BULK;
+
+    size_t path_len = parser->path.len < MAX_PATH_SIZE - 1 ? parser->path.len : MAX_PATH_SIZE - 1;
+    snprintf(full_path, sizeof(full_path), "%s%.*s", server_config->root_dir, (int)path_len,
+             VIEW_PTR(buf, parser->path));
+
+    Fd_entry *file = fd_cache_lookup(full_path);
+    if (file == NULL)
+        return path_len > 0 && VIEW_PTR(buf, parser->path)[path_len - 1] == '/' ? TASK_LANE_BULK : TASK_LANE_NORMAL;
+
+    if (!file->exists)
+        lane = TASK_LANE_FAST;
+    else if (S_ISDIR(file->st.st_mode))
+        lane = TASK_LANE_BULK;
+    else if (file_cache_contains(file->path, &file->st))
+        lane = TASK_LANE_FAST;
+    else if (file->st.st_size > CACHE_MAX_ENTRY_SIZE)
+        lane = TASK_LANE_BULK;
+
+    fd_cache_release(file);
+    return lane;
+}
+
+/**
+ * @brief Returns the body of a request as a string
+ *
+ * The body directly follows the blank line after the headers in the connection's input buffer. It is copied
+ * into its own NUL terminated buffer in the request's arena the first time it is needed, so requests without a
+ * body (and handlers that do not look at it) never pay for it.
+ *
+ * @param[in, out] req_header The HTTP request header structure
+ * @return The body, or NULL if it could not be allocated
+ */
+const char *get_request_body(Http_request_header *req_header)
+{
+    if (req_header->body == NULL)
+    {
+        req_header->body = arena_alloc(req_header->arena, req_header->body_len + 1);
+        if (req_header->body == NULL)
+        {
+            perror("arena_alloc");
+            return NULL;
+        }
+
+        memcpy(req_header->body, request_data(req_header->input) + req_header->input->parser.header_len,
+               req_header->body_len);
+        req_header->body[req_header->body_len] = '\0';
+    }
+
+    return req_header->body;
+}
+
+/**
+ * @brief Sends the header of an HTTP response whose body follows separately
  *
  * This function takes a connection file descriptor, an HTTP response header,
  * and a file size as input. It constructs the response header and sends it
  * through the connection. If there is an error during the process, it prints
  * an error message.
+ * The header is sent with MSG_MORE when a body follows: the kernel holds it back
+ * until the body is written (e.g. with sendfile()), so the two leave in the same
+ * segments instead of the header going out on its own.
  *
  * @param[in] connfd The connection file descriptor
  * @param[in] res_header The HTTP response header structure
  * @param[in] file_size The size of the file to be sent in the response
  * @return This function does not return a value
  */
-void send_response(const int connfd, Http_response_header res_header, long file_size)
+void send_response(const int connfd, Http_response_header *res_header, long file_size)
 {
-    char response[MAX_HEADER_SIZE];
+    Header_buf response;
 
     // Construct the response header
-    snprintf(response, sizeof(response),
-             "HTTP/1.1 %s %s\r\n"
-             "Content-Length: %ld\r\n"
-             "Content-Type: %s\r\n"
-             "Connection: %s\r\n"
-             "%s\r\n",
-             res_header.status_code, res_header.status_message,
-             file_size,
-             res_header.content_type,
-             res_header.connection,
-             res_header.additional_headers);
-
-    printf("Response header:\n%s\n", response);
+    render_response_header(&response, res_header, file_size);
+
+    printf("Response header:\n%.*s\n", (int)response.len, response.data);
 
     // Send the response header
-    if (send(connfd, response, strlen(response), 0) == -1)
+    if (send_all_flags(connfd, response.data, response.len, file_size > 0 ? MSG_MORE : 0) == -1)
     {
         perror("send");
     }
 }
 
+/**
+ * @brief Sends an HTTP response whose body is in memory
+ *
+ * The response header and the body are sent together with a single system call (unless the socket's send
+ * buffer fills up), so a small response leaves in a single segment.
+ *
+ * @param[in] connfd The connection file descriptor
+ * @param[in] res_header The HTTP response header structure
+ * @param[in] body The body of the response
+ * @param[in] body_len The size of the body
+ */
+void send_response_body(const int connfd, Http_response_header *res_header, const void *body, size_t body_len)
+{
+    Header_buf response;
+
+    render_response_header(&response, res_header, body_len);
+
+    printf("Response header:\n%.*s\n", (int)response.len, response.data);
+
+    struct iovec iov[2] = {{response.data, response.len}, {(void *)body, body_len}};
+    if (sendv_all(connfd, iov, 2) == -1)
+    {
+        perror("send");
+    }
+}
+
+/**
+ * @brief Sends a file from the file cache
+ *
+ * @param[in] connfd The connection file descriptor
+ * @param[in, out] res_header The HTTP response header structure
+ * @param[in] entry The cache entry holding the file
+ */
+void send_cached_file(const int connfd, Http_response_header *res_header, Cache_entry *entry)
+{
+    res_header->content_type = entry->mime_type;
+    send_response_body(connfd, res_header, entry->data, entry->size);
+}
+
+/**
+ * @brief Reads a whole file into memory
+ *
+ * @param[in] fd The file descriptor
+ * @param[in] size The size of the file
+ * @return A buffer holding the size bytes of the file, or NULL if the file could not be read completely
+ */
+static char *read_file(int fd, size_t size)
+{
+    char *data = malloc(size ? size : 1);
+    size_t done = 0;
+
+    while (data != NULL && done < size)
+    {
+        ssize_t n = pread(fd, data + done, size - done, done);
+        if (n > 0)
+        {
+            done += n;
+        }
+        else if (n == 0 || errno != EINTR) // the file was truncated or could not be read
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+
+    return data;
+}
+
 /**
  * @brief Serves a file over HTTP
  *
  * This function takes a connection file descriptor, an HTTP request header, an HTTP
- * response header, and a server configuration as input. It constructs the path to
- * the requested file, opens the file, gets its size, sends the response header, sends
- * the file, and finally closes the file. If there is an error during the process, it
- * prints an error message and returns.
+ * response header, and a server configuration as input. The file has already been
+ * opened through the fd cache (req_header->file). Small files are read into the file
+ * cache and sent from memory; larger ones are sent with sendfile() after the response
+ * header. If there is an error during the process, it prints an error message and returns.
  *
  * @param[in] connfd The connection file descriptor
  * @param[in] req_header The HTTP request header structure
@@ -243,59 +790,75 @@ void send_response(const int connfd, Http_response_header res_header, long file_
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void serve_file(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void serve_file(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
-    char response[MAX_HEADER_SIZE];
-    char file_path[MAX_PATH_SIZE * 2];
-    struct stat file_stat;
-    int fd;
-    long file_size = 0;
+    Fd_entry *file = req_header->file;
+    long file_size = file->st.st_size;
 
-    memset(&res_header.content_type, 0, sizeof(res_header.content_type));
-    memset(response, 0, sizeof(response));
-    memset(file_path, 0, sizeof(file_path));
+    res_header->content_type = file->mime_type;
 
-    strcpy(res_header.content_type, get_mime_type(req_header.path));
+    printf("Serving file: %s\n", file->path);
 
-    snprintf(file_path, sizeof(file_path), "%s%s", server_config.root_dir, req_header.path);
-    printf("Serving file: %s\n", file_path);
-    // Open the file
-    fd = open(file_path, O_RDONLY);
-    if (fd == -1)
+    // small files are read into the cache so that the next request for them does not touch the file
+    if (file_cache_accepts(file_size))
     {
-        perror("open");
-        return;
+        char *data = read_file(file->fd, file_size);
+        Cache_entry *entry = data != NULL ? file_cache_put(file->path, &file->st, data, file->mime_type) : NULL;
+        if (entry != NULL)
+        {
+            send_cached_file(connfd, res_header, entry);
+            file_cache_release(entry);
+            return;
+        }
     }
 
-    // Get file stats
-    if (fstat(fd, &file_stat) < 0)
+    send_response(connfd, res_header, file_size);
+
+    // Send the file (the descriptor is shared through the fd cache, so it is never closed here)
+    if (sendfile_all(connfd, file->fd, file_size) == -1)
     {
-        perror("fstat");
-        return;
+        perror("sendfile");
     }
+}
 
-    file_size = file_stat.st_size;
+/**
+ * @brief Appends bytes to a page being built in a request's arena
+ *
+ * @param[in] arena The arena of the request
+ * @param[in, out] page The page
+ * @param[in] data The bytes to append
+ * @param[in] len The number of bytes to append
+ * @return 0 on success, -1 if the page could not be grown
+ */
+static int page_append(Arena *arena, Page *page, const char *data, size_t len)
+{
+    if (page->len + len > page->size)
+    {
+        size_t size = page->size ? page->size : BUF_SIZE * 4;
+        while (size < page->len + len)
+            size *= 2;
 
-    send_response(connfd, res_header, file_size);
+        char *grown = page->data ? arena_grow(arena, page->data, page->len, size) : arena_alloc(arena, size);
+        if (grown == NULL)
+            return -1;
 
-    // Send the file
-    if (sendfile(connfd, fd, NULL, file_size) == -1)
-    {
-        perror("sendfile");
-        return;
+        page->data = grown;
+        page->size = size;
     }
 
-    // Close the file
-    close(fd);
+    memcpy(page->data + page->len, data, len);
+    page->len += len;
+    return 0;
 }
 
 /**
  * @brief Serves a directory listing over HTTP
  *
  * This function takes a connection file descriptor, an HTTP request header, an HTTP response header,
- * and a server configuration as input. It constructs the path to the requested directory, opens the
- * directory, reads its entries, and sends a response with an HTML page that lists the directory entries.
- * If there is an error during the process, it prints an error message and returns.
+ * and a server configuration as input. It opens the requested directory (resolved by the handler),
+ * reads its entries, and sends a response with an HTML page that lists the directory entries.
+ * If there is an error during the process, it prints an error message and answers with an empty
+ * 500 Internal Server Error, so that a client on a persistent connection is not left waiting.
  *
  * @param[in] connfd The connection file descriptor
  * @param[in] req_header The HTTP request header structure
@@ -303,33 +866,24 @@ void serve_file(const int connfd, Http_request_header req_header, Http_response_
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void serve_dir(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void serve_dir(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
-    char response[MAX_HEADER_SIZE];
-    char file_path[256];
-    long file_size = 0;
-    char *page_buffer;
-
-    memset(&res_header.content_type, 0, sizeof(res_header.content_type));
-    memset(response, 0, sizeof(response));
-    memset(file_path, 0, sizeof(file_path));
-
-    // Construct the full path
-    char full_path[4096]; // Adjust size as needed
-    snprintf(full_path, sizeof(full_path), "%s%s", server_config.root_dir, req_header.path);
+    Page page = {NULL, 0, 0};
 
     // Open the directory
-    DIR *dir = opendir(full_path);
+    DIR *dir = opendir(req_header->file->path);
     if (dir == NULL)
     {
         perror("opendir");
+        res_header->status = HTTP_STATUS_INTERNAL_ERROR;
+        send_response(connfd, res_header, 0);
         return;
     }
 
-    char html_body[1024 * 1024] = {0}; // 1mb
+    int ret = page_append(req_header->arena, &page, html_start, sizeof(html_start) - 1);
 
     struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
+    while (ret == 0 && (entry = readdir(dir)) != NULL)
     {
         // Skip . and .. entries
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
@@ -339,57 +893,47 @@ void serve_dir(const int connfd, Http_request_header req_header, Http_response_h
 
         // Add a list item with a link to the file
         char item[1024]; // Adjust size as needed
-        if (strcmp(req_header.path, "/") == 0)
+        int item_len;
+        if (strcmp(req_header->path, "/") == 0)
         {
             // If we are in the root directory
-            snprintf(item, sizeof(item), "<li><a href=\"/%s\">%s</a></li>", entry->d_name, entry->d_name);
+            item_len = snprintf(item, sizeof(item), "<li><a href=\"/%s\">%s</a></li>", entry->d_name, entry->d_name);
         }
         else
         {
             // If we are in a subdirectory
-            snprintf(item, sizeof(item), "<li class=\"subdir\"><a href=\"%s/%s\">%s</a></li>", req_header.path, entry->d_name, entry->d_name);
+            item_len = snprintf(item, sizeof(item), "<li class=\"subdir\"><a href=\"%s/%s\">%s</a></li>", req_header->path, entry->d_name, entry->d_name);
         }
-        strncat(html_body, item, sizeof(html_body) - strlen(html_body) - 1);
+        ret = page_append(req_header->arena, &page, item, item_len < (int)sizeof(item) ? (size_t)item_len : sizeof(item) - 1);
     }
 
     // Close the directory
     closedir(dir);
 
-    // Construct the full HTML response
-    char html_response[DIR_LISTING_PAGE_SZ];
-    snprintf(html_response, sizeof(html_response), "%s%s%s", html_start, html_body, html_end);
-
-    // Set the response fields
-    strcpy(res_header.content_type, "text/html");
-    file_size = strlen(html_response);
-
-    size_t buffer_size = strlen(html_start) + strlen(html_body) + strlen(html_end) + 1;
-    page_buffer = malloc(buffer_size);
-    if (page_buffer == NULL)
+    if (ret == 0)
+        ret = page_append(req_header->arena, &page, html_end, sizeof(html_end)); // including the terminator
+    if (ret == -1)
     {
-        fprintf(stderr, "Failed to allocate memory for page_buffer.\n");
+        fprintf(stderr, "Failed to allocate memory for the directory listing.\n");
+        res_header->status = HTTP_STATUS_INTERNAL_ERROR;
+        send_response(connfd, res_header, 0);
         return;
     }
-    snprintf(page_buffer, buffer_size, "%s%s%s", html_start, html_body, html_end);
 
-    send_response(connfd, res_header, file_size);
+    // Set the response fields
+    res_header->content_type = "text/html";
 
-    printf("sending page: %s\n", page_buffer);
-    // Send the file
-    if (send(connfd, page_buffer, strlen(page_buffer), 0) == -1)
-    {
-        perror("send");
-        return;
-    }
+    printf("sending page: %s\n", page.data);
+    send_response_body(connfd, res_header, page.data, page.len - 1);
 }
 
 /**
  * @brief Serves an HTTP request
  *
  * This function takes a connection file descriptor, an HTTP request header, an HTTP response header, and
- * a server configuration as input. It constructs the full path to the requested resource, checks if it's a
- * file or a directory, and calls the appropriate function to serve the resource. If there is an error during
- * the process, it prints an error message and returns.
+ * a server configuration as input. It uses the target resolved by the handler (req_header->file) to check if
+ * it's a file or a directory, and calls the appropriate function to serve the resource. Files in the file cache
+ * are sent from memory. A target that does not exist is answered with 404 Not Found.
  *
  * @param[in] connfd The connection file descriptor
  * @param[in] req_header The HTTP request header structure
@@ -397,30 +941,35 @@ void serve_dir(const int connfd, Http_request_header req_header, Http_response_h
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void serve_request(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void serve_request(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
     // create state machine either in serve file or server dir
-    // Construct the full path
-    char full_path[4096]; // Adjust size as needed
-    snprintf(full_path, sizeof(full_path), "%s%s", server_config.root_dir, req_header.path);
-
-    // Get file or directory information
-    struct stat path_stat;
-    if (stat(full_path, &path_stat) == -1)
+    Fd_entry *file = req_header->file;
+    if (file == NULL || !file->exists)
     {
-        perror("stat");
+        serve_request_404(connfd, req_header, res_header, server_config);
         return;
     }
 
-    if (S_ISDIR(path_stat.st_mode))
+    if (S_ISDIR(file->st.st_mode))
     {
         // current_state = SERVE_DIR;
         serve_dir(connfd, req_header, res_header, server_config);
     }
-    else if (S_ISREG(path_stat.st_mode))
+    else if (S_ISREG(file->st.st_mode))
     {
         // current_state = SERVE_FILE;
-        serve_file(connfd, req_header, res_header, server_config);
+        Cache_entry *entry = file_cache_get(file->path, &file->st);
+        if (entry != NULL)
+        {
+            printf("Serving cached file: %s\n", file->path);
+            send_cached_file(connfd, res_header, entry);
+            file_cache_release(entry);
+        }
+        else
+        {
+            serve_file(connfd, req_header, res_header, server_config);
+        }
     }
 }
 
@@ -437,14 +986,10 @@ void serve_request(const int connfd, Http_request_header req_header, Http_respon
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void serve_request_404(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void serve_request_404(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
-    memset(&res_header.content_type, 0, sizeof(res_header.content_type));
-    strcpy(res_header.status_code, "404");
-    strcpy(res_header.status_message, "Not Found");
-    strcpy(res_header.additional_headers, "Server: tinyserver\r\n");
-    strcpy(res_header.connection, "close");
-    strcpy(req_header.path, "/404.html");
+    res_header->status = HTTP_STATUS_NOT_FOUND;
+    res_header->content_type = "text/html";
 
     // Create the 404 page
     // char *page_404 = "<!DOCTYPE html>\r\n"
@@ -454,20 +999,35 @@ void serve_request_404(const int connfd, Http_request_header req_header, Http_re
     //                  "<p>The requested URL was not found on this server. Please check the URL or contact support if you need assistance.</p>\r\n"
     //                  "</body></html>\r\n";
 
-    // Calculate the size of the 404 page
-    long file_size = strlen(page_404);
+    // Send the header and the 404 page together
+    send_response_body(connfd, res_header, page_404, strlen(page_404));
+}
+/**
+ * @brief Resolves the file or directory a request refers to
+ *
+ * The full path is built once and looked up in the fd cache, which only touches the disk when it does not
+ * already know the path. The result is stored in req_header->file and released by handle_client().
+ *
+ * @param[in, out] req_header The HTTP request header structure
+ * @param[in] server_config The server configuration
+ * @param[in] modified true if the server has just written to the file
+ * @return The target (check its exists flag), or NULL if it could not be resolved
+ */
+static Fd_entry *open_target(Http_request_header *req_header, Server_config *server_config, bool modified)
+{
+    char full_path[MAX_ROOT_DIR_SIZE + MAX_PATH_SIZE];
+    snprintf(full_path, sizeof(full_path), "%s%s", server_config->root_dir, req_header->path);
 
-    // Call send_response
-    send_response(connfd, res_header, file_size);
+    if (modified)
+        fd_cache_invalidate(full_path);
 
-    // Send the 404 page
-    ssize_t len = strlen(page_404);
-    ssize_t bytes_sent = send(connfd, page_404, len, 0);
-    if (bytes_sent < 0)
-    {
-        perror("sending 404 page failed");
-    }
+    if (req_header->file != NULL)
+        fd_cache_release(req_header->file);
+
+    req_header->file = fd_cache_open(full_path);
+    return req_header->file;
 }
+
 /**
  * @brief Handles an HTTP POST request
  *
@@ -482,12 +1042,12 @@ void serve_request_404(const int connfd, Http_request_header req_header, Http_re
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void http_post_handler(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void http_post_handler(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
     printf("POST request\n");
 
     // if it is just a /, then ignore it
-    if (strcmp(req_header.path, "/") == 0)
+    if (strcmp(req_header->path, "/") == 0)
     {
         printf("POST request to /\n");
         serve_request_404(connfd, req_header, res_header, server_config);
@@ -496,25 +1056,33 @@ void http_post_handler(const int connfd, Http_request_header req_header, Http_re
     else
     {
 
-        if (strcmp(get_mime_type(req_header.path), "application/json") == 0)
+        const char *body = get_request_body(req_header);
+        if (body == NULL)
+        {
+            return;
+        }
+
+        if (strcmp(get_mime_type(req_header->path), "application/json") == 0)
         {
             printf("POST JSON request\n");
-            save_json(req_header.path, req_header.body);
-            serve_request(connfd, req_header, res_header, server_config);
+            save_json(req_header->path, body);
         }
         else
         {
             printf("text POST request\n");
-            save_file(req_header.path, req_header.body);
-            serve_request(connfd, req_header, res_header, server_config);
+            save_file(req_header->path, body);
         }
+
+        // the file has just changed, so whatever the caches know about it is stale
+        open_target(req_header, server_config, true);
+        serve_request(connfd, req_header, res_header, server_config);
     }
 }
 
 /**
  * @brief Handles an HTTP GET request
  *
- * This function takes a connection file descriptor, an HTTP request header, an HTTP response header, and a server configuration as input. It checks if the requested file exists. If it does, it serves the file. If it doesn't, it serves a 404 Not Found response.
+ * This function takes a connection file descriptor, an HTTP request header, an HTTP response header, and a server configuration as input. It checks if the requested file exists (through the fd cache, so repeated lookups do not touch the disk). If it does, it serves the file. If it doesn't, it serves a 404 Not Found response.
  *
  * @param[in] connfd The connection file descriptor
  * @param[in] req_header The HTTP request header structure
@@ -522,11 +1090,12 @@ void http_post_handler(const int connfd, Http_request_header req_header, Http_re
  * @param[in] server_config The server configuration
  * @return This function does not return a value
  */
-void http_get_handler(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config)
+void http_get_handler(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config)
 {
     printf("GET request\n");
     // check if target file exists
-    if (file_exists(req_header.path, server_config.root_dir))
+    Fd_entry *file = open_target(req_header, server_config, false);
+    if (file != NULL && file->exists)
     {
         printf("File exists\n");
         serve_request(connfd, req_header, res_header, server_config);
@@ -540,160 +1109,189 @@ void http_get_handler(const int connfd, Http_request_header req_header, Http_res
 }
 
 /**
- * @brief Handles an HTTP client
+ * @brief Decides whether a connection stays open after the current request
  *
- * This function takes an HTTP client and a server configuration as input. It sets up a response
- * header, and then enters a loop where it waits for a request from the client. If a request is received,
- * it handles the request based on its method (GET or POST). If the connection is set to keep-alive, it
- * continues to wait for more requests; otherwise, it closes the connection.
+ * Details: HTTP/1.1 connections are persistent unless the client sends `Connection: close`; HTTP/1.0 connections
+ *          only if it sends `Connection: keep-alive`. The server closes the connection anyway when keep-alive is
+ *          turned off or the connection has reached max_requests requests.
  *
- * @param[in] client The HTTP client to be handled
+ * @param[in] client The HTTP client whose input buffer holds the parsed request
  * @param[in] server_config The server configuration
- * @return This function does not return a value
+ * @return true if the connection should be kept open
  */
-void handle_client_persistent(Http_client *client, Server_config server_config)
+static bool wants_keep_alive(Http_client *client, Server_config *server_config)
 {
-    printf("\033[33mThread %ld\033[0m\n", pthread_self());
+    Http_parser *parser = &client->in->parser;
+    const char *buf = request_data(client->in);
 
-    Http_response_header res_header;
-    bool keep_alive = false;
-    fd_set set;
-    struct timeval timeout;
-
-    memset(&res_header, 0, sizeof(res_header));
-
-    strcpy(res_header.status_code, "200");
-    strcpy(res_header.status_message, "OK");
-    strcpy(res_header.additional_headers, "Keep-Alive: timeout=10\r\nServer: tinyserver\r\n");
-    strcpy(res_header.connection, "close");
-
-    do
-    {
-        // Initialize the file descriptor set.
-        FD_ZERO(&set);
-        FD_SET(client->connfd, &set);
-
-        // Initialize the timeout data structure.
-        timeout.tv_sec = 10;
-        timeout.tv_usec = 0;
+    if (server_config->enable_keep_alive == OFF)
+        return false;
+    if (server_config->max_requests > 0 && client->num_requests >= server_config->max_requests)
+        return false;
 
-        // select returns 0 if timeout, 1 if input available, -1 if error.
-        switch (select(FD_SETSIZE, &set, NULL, NULL, &timeout))
-        {
-        case -1:
-            perror("select");
-            close(client->connfd);
-            return;
-        case 0:
-            printf("Timeout, closing connection\n");
-            close(client->connfd);
-            return;
-        default:
-            Http_request_header req_header;
-
-            if (handle_http_request(client->connfd, &req_header) == -1)
-            {
-                printf("client closed connection or timeout\n");
-                close(client->connfd);
-                return;
-            }
-            // check if the connection is keep-alive
-            if (strncmp(req_header.connection, "keep-alive", 10) == 0)
-            {
-                keep_alive = true;
-                // res_header.connection = "keep-alive";
-                strcpy(res_header.connection, "keep-alive");
-                printf("Connection is keep-alive\n");
-            }
-            else
-            {
-                keep_alive = false;
-                // res_header.connection = "close";
-                strcpy(res_header.connection, "close");
-                memset(&res_header.additional_headers, 0, sizeof(res_header.additional_headers));
-                strcpy(res_header.additional_headers, "Server: tinyserver\r\n");
-                printf("Connection is close\n");
-            }
+    if (VIEW_EQ(buf, parser->version, "HTTP/1.1"))
+        return !http_header_has_token(buf, parser->connection, "close");
 
-            // now it is time to serve the request (respond)
-            if (req_header.method == HTTP_GET)
-            {
-                http_get_handler(client->connfd, req_header, res_header, server_config);
-            }
-            else if (req_header.method == HTTP_POST)
-            {
-                http_post_handler(client->connfd, req_header, res_header, server_config);
-            }
-        }
-    } while (keep_alive);
+    return http_header_has_token(buf, parser->connection, "keep-alive");
 }
 
-void handle_client(Http_client *client, Server_config server_config)
+/**
+ * @brief Handles one request from an HTTP client
+ *
+ * This function takes an HTTP client whose request has been completely received and a server configuration as
+ * input. It sets up a response header and handles the request based on its method (GET or POST). The client's
+ * socket is owned by the event loop; this function never closes it and instead tells the caller whether the
+ * connection should be kept open for another request. The request stays in the input buffer; the caller moves
+ * on with next_request() or closes the connection.
+ *
+ * @param[in] client The HTTP client to be handled
+ * @param[in] server_config The server configuration
+ * @return true if the connection should be kept alive, false if it should be closed
+ */
+bool handle_client(Http_client *client, Server_config *server_config)
 {
     printf("\033[33mThread %ld\033[0m\n", pthread_self());
 
-    Http_response_header res_header;
-    memset(&res_header, 0, sizeof(res_header));
-
-    strcpy(res_header.status_code, "200");
-    strcpy(res_header.status_message, "OK");
-    strcpy(res_header.additional_headers, "Server: tinyserver\r\n");
-    strcpy(res_header.connection, "close");
+    Http_response_header res_header = {HTTP_STATUS_OK, 0, -1, NULL};
+    bool keep_alive = false;
 
     Http_request_header req_header;
 
-    if (handle_http_request(client->connfd, &req_header) == -1)
+    if (handle_http_request(client, &req_header) == -1)
     {
-        printf("client closed connection or timeout\n");
-        close(client->connfd);
-        return;
+        printf("Unsupported request\n");
+        return false;
+    }
+
+    client->num_requests++;
+
+    // check if the connection is keep-alive
+    if (wants_keep_alive(client, server_config))
+    {
+        keep_alive = true;
+        res_header.keep_alive = 1;
+        if (server_config->max_requests > 0)
+            res_header.requests_left = server_config->max_requests - client->num_requests;
+        printf("Connection is keep-alive\n");
+    }
+    else
+    {
+        keep_alive = false;
+        printf("Connection is close\n");
     }
 
     // now it is time to serve the request (respond)
     if (req_header.method == HTTP_GET)
     {
-        http_get_handler(client->connfd, req_header, res_header, server_config);
+        http_get_handler(client->connfd, &req_header, &res_header, server_config);
     }
     else if (req_header.method == HTTP_POST)
     {
-        http_post_handler(client->connfd, req_header, res_header, server_config);
+        http_post_handler(client->connfd, &req_header, &res_header, server_config);
     }
 
-    close(client->connfd);
+    if (req_header.file != NULL)
+        fd_cache_release(req_header.file);
+
+    return keep_alive;
 }
 
 /**
- * @brief A wrapper function for handling an HTTP client in a new thread
+ * @brief Sets or clears TCP_CORK on a connection
+ */
+static void set_cork(int connfd, int on)
+{
+    if (setsockopt(connfd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on)) == -1)
+        perror("setsockopt");
+}
+
+/**
+ * @brief Answers every complete request buffered on a connection, in order
  *
- * This function takes a pointer to a Thread_args structure as input, which contains an HTTP client and
- * a server configuration. It calls the handle_client function to handle the client, and then frees the
- * memory allocated for the Thread_args structure.
+ * Details: Used by the event loops in place of handle_client(). After each request the next one is taken from
+ *          the bytes that arrived with it (see next_request()), so pipelined requests are answered one after the
+ *          other without going back to the event loop. While more than one request is buffered the socket is
+ *          corked, so the responses are coalesced into full segments and sent when the last one is done.
  *
- * @param[in] arg A pointer to a Thread_args structure containing the HTTP client to be handled and the server configuration
- * @return This function does not return a value
+ * @param[in] client The HTTP client whose input buffer holds a complete request
+ * @param[in] server_config The server configuration
+ * @return true if the connection should wait for more requests, false if it should be closed
  */
-void *handle_client_wrapper(void *arg)
+bool serve_connection(Http_client *client, Server_config *server_config)
 {
-    Thread_args *args = (Thread_args *)arg;
-    Http_client *client = args->client;
-    Server_config *server_config = args->server_config;
+    Recv_status status = RECV_DONE;
+    bool corked = false;
+    bool keep_alive;
 
-    if (server_config->enable_keep_alive == ON)
-        handle_client_persistent(client, *server_config);
-    else
-        handle_client(client, *server_config);
+    do
+    {
+        Http_input *in = client->in;
+        if (!corked && in->len > in->start + http_parser_request_len(&in->parser))
+        {
+            set_cork(client->connfd, 1);
+            corked = true;
+        }
+
+        keep_alive = handle_client(client, server_config);
+    } while (keep_alive && (status = next_request(client)) == RECV_DONE);
+
+    if (corked)
+        set_cork(client->connfd, 0);
 
-    free(args); // Don't forget to free the memory when you're done
+    if (status == RECV_INVALID)
+        send_bad_request(client->connfd);
 
-    return NULL;
+    return keep_alive && status == RECV_AGAIN;
+}
+
+/**
+ * @brief Creates a listening socket bound to the configured port
+ *
+ * This function creates a TCP socket, binds it to the port in the server configuration and starts listening
+ * for connections. When the server runs more than one shard, SO_REUSEPORT is set so that every shard can bind
+ * its own socket to the same port and the kernel spreads new connections across them.
+ *
+ * @param[in] server_config The server configuration
+ * @param[out] server_addr The address the socket was bound to
+ * @return The listening socket, or -1 if there was an error
+ */
+int create_listener(Server_config *server_config, SA_IN *server_addr)
+{
+    int sockfd;
+    check_err((sockfd = socket(AF_INET, SOCK_STREAM, 0)), "Socket error");
+    if (sockfd == -1)
+        return -1;
+
+    memset(server_addr, 0, sizeof(*server_addr));
+    server_addr->sin_family = AF_INET;
+    server_addr->sin_addr.s_addr = INADDR_ANY;
+    server_addr->sin_port = htons(atoi(server_config->port));
+
+    int optval = 1;
+    check_err(setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)), "Setsockopt error");
+    // accepted connections inherit TCP_NODELAY: every response is written in one go (or corked), so Nagle's
+    // algorithm would only hold back its last segment until the client's delayed ACK
+    check_err(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval)), "Setsockopt error");
+    if (server_config->num_shards > 1)
+        check_err(setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)), "Setsockopt error");
+
+    if (bind(sockfd, (SA *)server_addr, sizeof(*server_addr)) == -1 || listen(sockfd, BACKLOG) == -1)
+    {
+        perror("Bind/listen error");
+        close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
 }
 
 /**
  * @brief Starts the HTTP server
  *
  * This function takes an HTTP server and command line arguments as input. It sets the server configuration with
- * default or provided values, creates a socket, binds it to the specified port, and starts listening for connections.
- * If there is an error during the process, it prints an error message and returns.
+ * default or provided values and creates the first listening socket. When more than one shard is configured,
+ * the remaining shards create their own listening sockets on the same port (see shard.h).
+ * If there is an error during the process, it prints an error message and exits.
  *
  * @param[in] server The HTTP server to be started
  * @param[in] argc The number of command line arguments
@@ -702,18 +1300,27 @@ void *handle_client_wrapper(void *arg)
  */
 void start_server(Http_server *server, int argc, char *argv[])
 {
-    // Set default values
     // Set default values
     strcpy(server->config.port, DEFAULT_PORT);
     strcpy(server->config.root_dir, DEFAULT_ROOT_DIR);
     server->config.enable_mt = ON;
-    server->config.enable_keep_alive = OFF;
+    server->config.enable_keep_alive = ON;
+    server->config.enable_uring = OFF;
     server->config.num_threads = DEFAULT_NUM_THREADS;
+    server->config.max_threads = 0;
+    server->config.queue_type = TASK_QUEUE_LIST;
+    server->config.num_shards = DEFAULT_NUM_SHARDS;
+    server->config.max_requests = DEFAULT_MAX_REQUESTS;
+    server->config.max_connections = DEFAULT_MAX_CONNECTIONS;
+    server->config.max_queued = DEFAULT_MAX_QUEUED;
+    server->config.max_queue_wait_ms = DEFAULT_MAX_QUEUE_WAIT_MS;
+    server->config.placement.num_cpus = 0;
     server->config.enable_stats = OFF;
+    server->config.cache_size = DEFAULT_CACHE_SIZE;
 
     // Override with command line arguments if provided
     int opt;
-    while ((opt = getopt(argc, argv, "p:r:m:k:t:s:")) != -1)
+    while ((opt = getopt(argc, argv, "p:r:m:k:t:s:n:u:c:q:a:b:l:o:d:w:")) != -1)
     {
         switch (opt)
         {
@@ -735,66 +1342,73 @@ void start_server(Http_server *server, int argc, char *argv[])
         case 's':
             server->config.enable_stats = (strcmp(optarg, "on") == 0) ? ON : OFF;
             break;
+        case 'n':
+            server->config.num_shards = atoi(optarg);
+            break;
+        case 'u':
+            server->config.enable_uring = (strcmp(optarg, "on") == 0) ? ON : OFF;
+            break;
+        case 'c':
+            server->config.cache_size = atol(optarg) * 1024 * 1024;
+            break;
+        case 'a':
+            server->config.max_threads = atoi(optarg);
+            break;
+        case 'l':
+            server->config.max_requests = atoi(optarg);
+            break;
+        case 'o':
+            server->config.max_connections = atoi(optarg);
+            break;
+        case 'd':
+            server->config.max_queued = atoi(optarg);
+            break;
+        case 'w':
+            server->config.max_queue_wait_ms = atoi(optarg);
+            break;
+        case 'q':
+            if (strcmp(optarg, "ring") == 0)
+                server->config.queue_type = TASK_QUEUE_RING;
+            else if (strcmp(optarg, "steal") == 0)
+                server->config.queue_type = TASK_QUEUE_STEAL;
+            else
+                server->config.queue_type = TASK_QUEUE_LIST;
+            break;
+        case 'b':
+            if (affinity_parse(optarg, &server->config.placement) == -1)
+            {
+                fprintf(stderr, "Invalid CPU placement '%s' (expected none, cores or a CPU list such as 0-3,8)\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
         default:
-            fprintf(stderr, "Usage: %s [-p port] [-r root_dir] [-m enable_mt] [-k enable_keep_alive] [-t num_threads] [-s enable_stats]\n", argv[0]);
+            fprintf(stderr, "Usage: %s [-p port] [-r root_dir] [-m enable_mt] [-k enable_keep_alive] [-t num_threads] [-s enable_stats] [-n num_shards] [-u enable_uring] [-c cache_mb] [-q list|ring|steal] [-a max_threads] [-b none|cores|cpu_list] [-l max_requests] [-o max_connections] [-d max_queued] [-w max_queue_wait_ms]\n", argv[0]);
             exit(EXIT_FAILURE);
         }
     }
 
-    check_err((server->sockfd = socket(AF_INET, SOCK_STREAM, 0)), "Socket error");
-
-    server->server_addr.sin_family = AF_INET;
-    server->server_addr.sin_addr.s_addr = INADDR_ANY;
-    server->server_addr.sin_port = htons(atoi(server->config.port));
-
-    int optval = 1;
-    check_err(setsockopt(server->sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)), "Setsockopt error");
-
-    check_err(bind(server->sockfd, (SA *)&server->server_addr, sizeof(server->server_addr)), "Bind error");
-    check_err(listen(server->sockfd, BACKLOG), "Listen error");
+    if (server->config.num_shards < 1)
+        server->config.num_shards = 1;
+    if (server->config.cache_size < 0)
+        server->config.cache_size = 0;
+    if (server->config.max_requests < 0)
+        server->config.max_requests = 0;
+    if (server->config.max_connections < 0)
+        server->config.max_connections = 0;
+    if (server->config.max_queued < 0)
+        server->config.max_queued = 0;
+    if (server->config.max_queue_wait_ms < 0)
+        server->config.max_queue_wait_ms = 0;
+
+    server->sockfd = create_listener(&server->config, &server->server_addr);
+    if (server->sockfd == -1)
+        exit(EXIT_FAILURE);
 
     printf("Server: waiting for connection on port %s...\n", server->config.port);
     printf("You can access it at: \033[32m\033[4mhttp://10.65.255.109:%s/\033[0m\n", server->config.port);
     printf("root dir: %s\n", server->config.root_dir);
 }
 
-/**
- * @brief Accepts a client connection and adds it to the thread pool
- *
- * This function takes an HTTP server, a thread pool, and a pointer to the connection count as input.
- * It accepts a client connection, increments the connection count, and adds a task to the thread pool to
- * handle the client. The task is a call to the handle_client_wrapper function with a Thread_args structure
- * containing the client and the server configuration.
- *
- * @param[in] server The HTTP server
- * @param[in] pool The thread pool
- * @param[out] connection_count A pointer to the connection count
- * @return This function does not return a value
- */
-void accept_client(Http_server *server, ThreadPool *pool, int *connection_count)
-{
-    Http_client *client = malloc(sizeof(Http_client));
-    socklen_t addr_size = sizeof(client->client_addr);
-
-    check_err((client->connfd = accept(server->sockfd, (SA *)&client->client_addr, &addr_size)), "Accept error");
-
-    printf("Server: got connection from %s\n", inet_ntoa(client->client_addr.sin_addr));
-    (*connection_count)++;
-    printf("Server: connection count is %d\n", *connection_count);
-
-    Thread_args *args = malloc(sizeof(Thread_args));
-    args->client = client;
-    args->server_config = &server->config;
-
-    if (server->config.enable_mt == OFF)
-        if (server->config.enable_keep_alive == ON)
-            handle_client_persistent(client, server->config);
-        else
-            handle_client(client, server->config);
-    else
-        thread_pool_add_task(pool, handle_client_wrapper, (void *)args);
-}
-
 void calculate_usage(struct timeval start, struct timeval wall_start)
 {
     struct rusage usage;
@@ -824,6 +1438,31 @@ void calculate_usage(struct timeval start, struct timeval wall_start)
     printf("CPU Usage: %.2lf%%\n", cpu_usage);
     printf("Memory Usage: %ld kB\n", mem_usage);
 
+    if (fd_cache != NULL)
+        printf("Fd Cache: %lu hits, %lu misses\n", fd_cache->hits, fd_cache->misses);
+
+    Cache_stats cache_stats;
+    file_cache_get_stats(&cache_stats);
+    printf("File Cache: %lu hits, %lu misses, %lu evictions, %lu invalidations, %d entries (%zu bytes)\n",
+           cache_stats.hits, cache_stats.misses, cache_stats.evictions, cache_stats.invalidations,
+           cache_stats.entries, cache_stats.bytes);
+
+    Admission_stats admission_stats;
+    admission_get_stats(&admission_stats);
+    printf("Shed: %lu over the connection limit, %lu over the queue depth, %lu over the queue wait (%d open)\n",
+           admission_stats.shed[SHED_CONNECTIONS], admission_stats.shed[SHED_QUEUE_DEPTH],
+           admission_stats.shed[SHED_QUEUE_WAIT], __atomic_load_n(&num_clients, __ATOMIC_RELAXED));
+
+    Objpool *objpools[] = {&client_objpool, &arena_objpool, &task_objpool, &queue_node_objpool};
+    const char *objpool_names[] = {"connections", "arena blocks", "tasks", "queue nodes"};
+    for (size_t i = 0; i < sizeof(objpools) / sizeof(objpools[0]); i++)
+    {
+        Objpool_stats objpool_stats;
+        objpool_get_stats(objpools[i], &objpool_stats);
+        printf("Object Pool (%s): %lu allocs, %lu frees, %lu from malloc, %lu released\n", objpool_names[i],
+               objpool_stats.allocs, objpool_stats.frees, objpool_stats.mallocs, objpool_stats.releases);
+    }
+
     // Create a UDP socket
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0)
@@ -6,17 +6,18 @@
  * Details: 
  * - This library provides the necessary data structures and function prototypes for an HTTP web server program. It 
  *   includes the definitions of various structures such as Http_client, Http_request_header, Http_response_header, 
- *   Server_config, Thread_args, and Http_server.
+ *   Server_config, and Http_server.
  * - Function prototypes for handling HTTP requests and responses, managing server configuration, handling multi-threading, 
  *   serving files and directories, and handling client connections are provided.
  * 
  * Structures:
- * - Http_client: Represents a client connection with its connection file descriptor and client address.
- * - Http_request_header: Represents an HTTP request header with its method, path, version, host, connection, buffer, and body.
- * - Http_response_header: Represents an HTTP response header with its status code, content type, connection, status message, 
- *   and additional headers.
- * - Server_config: Contains flags for multi-threading, number of threads, root directory, and port.
- * - Thread_args: Contains a pointer to an Http_client and a Server_config.
+ * - Http_client: Represents a client connection with its connection file descriptor, client address, the state
+ *   the reactor keeps for it and the arena its requests are allocated from.
+ * - Http_request_header: Represents an HTTP request header with its method, path, version, host and connection. The
+ *   raw request and its body stay in the connection's input buffer; the body is only copied out on demand.
+ * - Http_response_header: Represents an HTTP response header with its status, connection mode, Keep-Alive max and
+ *   content type; it is serialized from pre-rendered blocks (see response.h).
+ * - Server_config: Contains flags for multi-threading, the io_uring backend, number of threads (and the ceiling for autoscaling), the kind of task queue, number of listener shards, requests per connection, the admission limits, the CPUs threads are pinned to, file cache size, root directory, and port.
  * - Http_server: Represents the server with its socket file descriptor, server address, and server configuration.
  * 
  * Function Prototypes:
@@ -28,7 +29,6 @@
  * - Serving files and directories
  * - Handling client connections
  * - Starting the server
- * - Accepting client connections
  * - Printing the server logo
  * 
  * Assumptions/Limitations: 
@@ -39,13 +39,29 @@
  * - It also assumes that the read end of a pipe is 0 and the write end is 1.
  * - It does not handle cases where these limits are exceeded.
  * - For commands such as GET, POST, the request must be properly formatted according to the HTTP/1.1 standard.
- * - The server supports keep-alive connections.
+ *   Requests are parsed incrementally as they arrive (see parser.h); malformed requests are answered with
+ *   400 Bad Request and the connection is closed.
+ * - Connections are persistent as in HTTP/1.1: an HTTP/1.1 connection stays open unless the client sends
+ *   `Connection: close`, an HTTP/1.0 one only if it sends `Connection: keep-alive`. The server closes a connection
+ *   after max_requests requests (-l) or when keep-alive is turned off (-k off).
+ * - Requests may be pipelined. Every complete request that arrived in the same read is parsed and answered in
+ *   order from the same input buffer, with the socket corked so that the responses go out in as few segments as
+ *   possible (see serve_connection()).
+ * - A connection waiting for data has a deadline: KEEP_ALIVE_TIMEOUT seconds for the next request, HEADER_TIMEOUT
+ *   seconds for the headers once a request has started and BODY_TIMEOUT seconds for the body after that. Receiving
+ *   more bytes does not move the header and body deadlines, so a client that trickles its request in is closed
+ *   all the same (see request_deadline()).
+ * - A response goes out in as few segments as possible: an in-memory body is written together with the header in
+ *   one writev() (send_response_body()), and the header of a file sent with sendfile() is written with MSG_MORE so
+ *   that it shares a segment with the start of the file. Client sockets have TCP_NODELAY set, so the end of a
+ *   response is never held back waiting for an ACK.
+ * - Under overload new connections and requests are answered with 503 Service Unavailable instead of being queued
+ *   without bound (see admission.h).
  * - The server supports multi-threading.
  * 
  * Notes:
- * - Due to the nature of supporting "keep-alive" connections, performance if the user chooses < 2 threads 
- *   is suboptimal. This is because the server will wait for the client to close the connection before 
- *   accepting another connection. This is not an issue if the user chooses >= 2 threads.
+ * - Connections are owned by the epoll reactor (see reactor.h). A worker thread is only used while a request is
+ *   being answered, so idle keep-alive connections do not hold on to a thread.
  *
  * Valid Command: 
  * `GET /path HTTP/1.1\r\nHost: hostname\r\nConnection: keep-alive\r\n\r\n`
@@ -73,7 +89,6 @@
 #include <sys/file.h>
 #include <fcntl.h>
 #include <string.h>
-#include <regex.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <sys/stat.h>
@@ -83,15 +98,23 @@
 #include <sys/time.h>
 #include <dirent.h>
 #include <sys/resource.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include "pool.h"
+#include "arena.h"
 #include "mime.h"
 #include "files.h"
 #include "stats.h"
+#include "parser.h"
+#include "cache.h"
+#include "fdcache.h"
+#include "timerwheel.h"
+#include "response.h"
 
 #define DEFAULT_PORT "8080"
 #define DEFAULT_ROOT_DIR "../public"
-#define DIR_LISTING_PAGE_SZ ((1024 * 1024) + 4096)
 #define DEFAULT_NUM_THREADS 8
+#define DEFAULT_NUM_SHARDS 1
 
 #define MAX_BODY_SIZE 1000000
 #define MAX_HEADER_SIZE 100000
@@ -110,6 +133,26 @@
 #define FAIL -1
 #define BUF_SIZE 1024
 #define MAX_THREADS 128
+#define KEEP_ALIVE_TIMEOUT 10       /* seconds a connection may wait for its next request */
+#define HEADER_TIMEOUT 10           /* seconds from the first byte of a request to the end of its headers */
+#define BODY_TIMEOUT 30             /* seconds from the end of the headers to the end of the body */
+#define TIMER_TICK_MS 100           /* resolution of the connection deadlines (see timerwheel.h) */
+#define DEFAULT_MAX_REQUESTS 1000   /* requests answered on a connection before it is closed */
+#define INPUT_INITIAL_SIZE 4096     /* initial size of a connection's input buffer, grown as the request needs */
+#define SEND_TIMEOUT_MS 10000
+#define CLIENT_POOL_BATCH 8         /* connections moved between a thread's cache and client_objpool at a time */
+#define CLIENT_POOL_MAX_FREE 1024   /* closed connections client_objpool keeps for reuse (a few hundred bytes each) */
+#define ARENA_POOL_BATCH 4          /* arena blocks moved between a thread's cache and arena_objpool at a time */
+#define ARENA_POOL_MAX_FREE 64      /* arena blocks arena_objpool keeps for reuse; with the thread caches (up to
+                                       2 * ARENA_POOL_BATCH each) this bounds the memory kept for requests that
+                                       have ended */
+#define DEFAULT_MAX_CONNECTIONS 10000   /* open connections before new ones are turned away (see admission.h) */
+#define DEFAULT_MAX_QUEUED 4096         /* requests waiting for a worker before new ones are turned away */
+#define DEFAULT_MAX_QUEUE_WAIT_MS 1000  /* queue wait above which new requests are turned away */
+
+extern Objpool client_objpool;      /* connections */
+extern Objpool arena_objpool;       /* first blocks of the arenas of connections with a request in progress */
+extern int num_clients;             /* connections currently open (from create_client() to free_client()) */
 
 typedef struct sockaddr_in SA_IN;
 typedef struct sockaddr SA;
@@ -120,9 +163,42 @@ typedef enum {
     // Add more methods here as needed
 } http_method;
 
+typedef enum {
+    CONN_IDLE,      /* waiting in epoll for the next request */
+    CONN_BUSY       /* being served by a worker */
+} Conn_state;
+
+typedef enum {
+    RECV_DONE,      /* a complete request has been received */
+    RECV_AGAIN,     /* the request is incomplete; wait for more bytes */
+    RECV_CLOSED,    /* the client hung up or the socket failed */
+    RECV_INVALID    /* the request is malformed or too large */
+} Recv_status;
+
 typedef struct {
+    Http_parser parser;
+    size_t start;                   /* offset of the current request (earlier bytes were pipelined requests) */
+    size_t len;                     /* number of bytes received so far */
+    size_t size;                    /* size of data (MAX_HEADER_SIZE for the headers, plus the body once known) */
+    char *data;                     /* the request as it was received (allocated from the connection's arena) */
+    long header_deadline;           /* monotonic milliseconds; 0 until set by request_deadline() */
+    long body_deadline;
+} Http_input;
+
+typedef struct Http_client {
     int connfd;
     SA_IN client_addr;
+    struct Reactor *reactor;        /* reactor that owns the connection (epoll backend) */
+    struct Uring *uring;            /* ring that owns the connection (io_uring backend) */
+    Conn_state state;
+    Timer timer;                    /* deadline of the current wait (idle, headers or body) */
+    int num_requests;               /* requests answered on this connection */
+    Http_input *in;                 /* request being received (NULL while the connection is idle) */
+    bool keep_alive;                /* result of the last request (io_uring backend) */
+    Task task;                      /* used to hand the connection to a worker without allocating */
+    Arena arena;                    /* memory for the current request, reset once it has been answered */
+    struct Http_client *prev;       /* neighbours in the reactor's connection list */
+    struct Http_client *next;
 } Http_client;
 
 typedef enum {
@@ -134,34 +210,40 @@ typedef struct {
     http_method method;
     char path[MAX_PATH_SIZE];
     char version[MAX_VERSION_SIZE];
-    char buffer[MAX_HEADER_SIZE];
     char host[MAX_HOST_SIZE];
     char connection[MAX_CONNECTION_SIZE];
-    char body[MAX_BODY_SIZE];
+    const Http_input *input;        /* the raw request; its parser holds views of every header */
+    Arena *arena;                   /* memory that lives until the request has been answered */
+    size_t body_len;                /* number of bytes of body following the headers */
+    char *body;                     /* NUL terminated copy of the body, allocated by get_request_body() */
+    Fd_entry *file;                 /* the resolved target of the request (see fdcache.h) */
 } Http_request_header;
 
 typedef struct {
-    char status_code[MAX_STATUS_CODE_SIZE];
-    char content_type[MAX_CONTENT_TYPE_SIZE];
-    char connection[MAX_CONNECTION_SIZE];
-    char status_message[MAX_STATUS_MESSAGE_SIZE];
-    char additional_headers[MAX_ADDITIONAL_HEADERS_SIZE];
-} Http_response_header;
+    char *data;                     /* allocated from the request's arena */
+    size_t len;
+    size_t size;
+} Page;
 
 typedef struct {
     Switch_t enable_stats;
     Switch_t enable_mt;
     Switch_t enable_keep_alive;
+    Switch_t enable_uring;
     int num_threads;
+    int max_threads;                /* ceiling the thread pools may grow to under load (-a; num_threads if lower) */
+    task_queue_type queue_type;     /* task queue of the thread pools (-q list|ring|steal) */
+    int num_shards;
+    int max_requests;               /* requests answered on a connection before it is closed (-l; 0 for no limit) */
+    int max_connections;            /* open connections before new ones are shed (-o; 0 for no limit) */
+    int max_queued;                 /* queued requests before new ones are shed (-d; 0 for no limit) */
+    int max_queue_wait_ms;          /* queue wait before new requests are shed (-w; 0 for no limit) */
+    Cpu_placement placement;        /* CPUs the reactors and workers are pinned to (-b none|cores|cpu list) */
+    long cache_size;                /* byte budget of the file cache (0 disables it) */
     char root_dir[MAX_ROOT_DIR_SIZE];
     char port[MAX_PORT_SIZE];
 } Server_config;
 
-typedef struct {
-    Http_client *client;
-    Server_config *server_config;
-} Thread_args;
-
 typedef struct {
     int sockfd;
     SA_IN server_addr;
@@ -170,20 +252,34 @@ typedef struct {
 
 
 void check_err(int val, char *msg);
-void parse_field(char *src, char *des, const char *field);
-int handle_http_request(const int connfd, Http_request_header *req_header);
-void send_response(const int connfd, Http_response_header res_header, long file_size);
-void serve_file(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void serve_dir(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void serve_request(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void serve_request_404(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void http_post_handler(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void http_get_handler(const int connfd, Http_request_header req_header, Http_response_header res_header, Server_config server_config);
-void handle_client(Http_client *client, Server_config server_config);
-void handle_client(Http_client *client, Server_config server_config);
-void *handle_client_wrapper(void *arg);
+ssize_t send_all(const int connfd, const void *buf, size_t len);
+ssize_t send_all_flags(const int connfd, const void *buf, size_t len, int flags);
+int sendfile_all(const int connfd, int fd, long file_size);
+ssize_t sendv_all(const int connfd, struct iovec *iov, int iovcnt);
+Http_client *create_client();
+void free_client(Http_client *client);
+Recv_status receive_request(Http_client *client);
+Recv_status feed_request(Http_client *client, const char *data, size_t len);
+void release_input(Http_client *client);
+Recv_status next_request(Http_client *client);
+long request_deadline(Http_client *client, long now_ms);
+void send_bad_request(const int connfd);
+int handle_http_request(Http_client *client, Http_request_header *req_header);
+task_lane classify_request(Http_client *client, Server_config *server_config);
+const char *get_request_body(Http_request_header *req_header);
+void send_response(const int connfd, Http_response_header *res_header, long file_size);
+void send_response_body(const int connfd, Http_response_header *res_header, const void *body, size_t body_len);
+void send_cached_file(const int connfd, Http_response_header *res_header, Cache_entry *entry);
+void serve_file(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+void serve_dir(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+void serve_request(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+void serve_request_404(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+void http_post_handler(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+void http_get_handler(const int connfd, Http_request_header *req_header, Http_response_header *res_header, Server_config *server_config);
+bool handle_client(Http_client *client, Server_config *server_config);
+bool serve_connection(Http_client *client, Server_config *server_config);
+int create_listener(Server_config *server_config, SA_IN *server_addr);
 void start_server(Http_server *server, int argc, char *argv[]);
-void accept_client(Http_server *server, ThreadPool *pool, int *connection_count);
 void print_logo();
 void calculate_usage(struct timeval start, struct timeval wall_start);
 
@@ -0,0 +1,180 @@
+/**
+ * @file shard.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "shard.h"
+
+/**
+ * @brief The function executed by every shard's thread
+ *
+ * @param[in] arg A pointer to the shard
+ * @return This function does not return a value
+ */
+static void *shard_do(void *arg)
+{
+    Shard *shard = (Shard *)arg;
+
+    if (shard->uring != NULL)
+        uring_run(shard->uring);
+    else
+        reactor_run(shard->reactor);
+
+    return NULL;
+}
+
+/**
+ * @brief Prints the CPUs and NUMA node(s) a shard's reactor and workers run on
+ *
+ * @param[in] shard The shard
+ */
+static void print_placement(Shard *shard)
+{
+    ThreadPool *pool = shard->pool;
+    char cpus[256], nodes[64] = "";
+    size_t len = 0;
+    int last_node = -1;
+
+    affinity_format(cpus, sizeof(cpus), pool->cpus, pool->num_cpus);
+    for (int i = 0; i < pool->num_cpus && len < sizeof(nodes); i++)
+    {
+        int node = affinity_node_of(pool->cpus[i]);
+        if (node != last_node)
+            len += snprintf(nodes + len, sizeof(nodes) - len, "%s%d", len > 0 ? "," : "", node);
+        last_node = node;
+    }
+
+    printf("Server: shard %d reactor on CPU %d, workers on CPU(s) %s (NUMA node %s)\n", shard->id, shard->cpu,
+           cpus, nodes);
+}
+
+/**
+ * @brief Creates the listener shards of a server
+ *
+ * Details: Shard 0 uses the listening socket created by start_server(); every other shard creates its own
+ *          SO_REUSEPORT socket on the same port. Each shard gets a private thread pool and reactor.
+ *
+ * @param[in] server The server whose configuration is used
+ * @return An array of server->config.num_shards shards, or NULL if they could not be created
+ */
+Shard *shards_create(Http_server *server)
+{
+    int num_shards = server->config.num_shards;
+    int threads_per_shard = (server->config.num_threads + num_shards - 1) / num_shards;
+    int max_per_shard = (server->config.max_threads + num_shards - 1) / num_shards;
+
+    Shard *shards = calloc(num_shards, sizeof(Shard));
+    if (shards == NULL)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    for (int i = 0; i < num_shards; i++)
+    {
+        SA_IN addr;
+        Shard *shard = &shards[i];
+
+        shard->id = i;
+        shard->listenfd = (i == 0) ? server->sockfd : create_listener(&server->config, &addr);
+        if (shard->listenfd == -1)
+        {
+            shards_destroy(shards, i);
+            return NULL;
+        }
+
+        int num_cpus;
+        const int *cpus = affinity_slice(&server->config.placement, i, num_shards, &num_cpus);
+        shard->cpu = num_cpus > 0 ? cpus[0] : -1;
+
+        shard->pool = thread_pool_create_pinned(threads_per_shard, max_per_shard, server->config.queue_type,
+                                                cpus, num_cpus);
+        if (shard->pool != NULL && server->config.enable_uring == ON)
+        {
+            shard->uring = uring_create(server, shard->pool, shard->listenfd);
+            if (shard->uring == NULL)
+                fprintf(stderr, "Shard %d: io_uring is not available, falling back to epoll\n", i);
+        }
+        if (shard->pool != NULL && shard->uring == NULL)
+            shard->reactor = reactor_create(server, shard->pool, shard->listenfd);
+
+        if (shard->reactor == NULL && shard->uring == NULL)
+        {
+            fprintf(stderr, "Failed to create shard %d\n", i);
+            shards_destroy(shards, i + 1);
+            return NULL;
+        }
+    }
+
+    printf("Server: %d shard(s) with %d thread(s) each (%s)\n", num_shards, threads_per_shard,
+           shards[0].uring != NULL ? "io_uring" : "epoll");
+    if (max_per_shard > threads_per_shard)
+        printf("Server: thread pools scale up to %d thread(s) each\n", max_per_shard);
+    for (int i = 0; i < num_shards && server->config.placement.num_cpus > 0; i++)
+        print_placement(&shards[i]);
+
+    return shards;
+}
+
+/**
+ * @brief Runs every shard and waits for them to stop
+ *
+ * @param[in] shards The shards to run
+ * @param[in] num_shards The number of shards
+ */
+void shards_run(Shard *shards, int num_shards)
+{
+    for (int i = 0; i < num_shards; i++)
+    {
+        pthread_attr_t attr;
+        int err = pthread_attr_init(&attr);
+
+        /* started pinned, so the connections the reactor allocates are first touched on its node */
+        if (err == 0)
+        {
+            err = affinity_set_attr(&attr, shards[i].cpu);
+            if (err == 0)
+                err = pthread_create(&shards[i].thread, &attr, shard_do, &shards[i]);
+            pthread_attr_destroy(&attr);
+        }
+        if (err != 0)
+        {
+            perror("SHARD CREATION FAILED\n");
+            num_shards = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < num_shards; i++)
+    {
+        pthread_join(shards[i].thread, NULL);
+    }
+}
+
+/**
+ * @brief Destroys shards, their thread pools, reactors and listening sockets
+ *
+ * @param[in] shards The shards to be destroyed
+ * @param[in] num_shards The number of shards
+ */
+void shards_destroy(Shard *shards, int num_shards)
+{
+    if (shards == NULL)
+        return;
+
+    for (int i = 0; i < num_shards; i++)
+    {
+        Shard *shard = &shards[i];
+
+        if (shard->pool != NULL)
+            thread_pool_wait(shard->pool);
+        reactor_destroy(shard->reactor);
+        uring_destroy(shard->uring);
+        thread_pool_destroy(shard->pool);
+        if (shard->listenfd != -1)
+            close(shard->listenfd);
+    }
+
+    free(shards);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file shard.h
+ * @brief Per-core listener shards built on SO_REUSEPORT
+ * @authors
+ *
+ * Details:
+ * A shard is a complete, independent copy of the server's front end: its own listening socket, its own reactor
+ * (running on its own thread) and its own private thread pool. Every shard binds its listening socket to the
+ * same port with SO_REUSEPORT, so the kernel load-balances new connections across shards. Shards share no
+ * accept lock, no connection list and no pool_lock; the only shared state is the read-only server configuration.
+ *
+ * With a single shard (the default) the server behaves exactly as one reactor with one thread pool.
+ * When the io_uring backend is enabled (-u on) every shard runs a ring instead of an epoll reactor, falling back
+ * to epoll if the ring cannot be created.
+ *
+ * Assumptions/Limitations:
+ * The configured number of threads (-t) is split evenly between the shards (rounded up), so every shard owns at
+ * least one worker. The autoscaling ceiling (-a) is split the same way. A connection stays on the shard that
+ * accepted it for its whole lifetime.
+ * With a CPU placement (-b) every shard gets its own slice of the CPUs (see affinity_slice()): the reactor thread
+ * is pinned to the first CPU of the slice and the workers are spread over the slice.
+ *
+ * @date 2026-10-17
+ */
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "reactor.h"
+#include "uring.h"
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Shard {
+    int id;
+    int listenfd;                   /* this shard's SO_REUSEPORT listening socket */
+    pthread_t thread;               /* thread running the shard's reactor */
+    int cpu;                        /* CPU the reactor thread is pinned to, or -1 */
+    ThreadPool *pool;               /* workers private to this shard */
+    Reactor *reactor;               /* epoll event loop (NULL when the shard uses io_uring) */
+    Uring *uring;                   /* io_uring event loop (NULL when the shard uses epoll) */
+} Shard;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern Shard *shards_create(Http_server *server);
+extern void shards_run(Shard *shards, int num_shards);
+extern void shards_destroy(Shard *shards, int num_shards);
+
+#endif
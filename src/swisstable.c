@@ -0,0 +1,355 @@
+/**
+ * @file swisstable.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "swisstable.h"
+#include "hash.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define H2(hash) ((int8_t)((hash) & 0x7f))     /* 7 bits stored in the control byte */
+#define H1(hash) ((hash) >> 7)                  /* bits that pick the first group */
+
+/**
+ * @brief Finds the slots of a group whose control byte equals byte
+ *
+ * @return A bit mask with bit i set if slot i of the group matches
+ */
+static inline unsigned int group_match(const int8_t *group, int8_t byte)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_load_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(byte)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+        mask |= (unsigned int)(group[i] == byte) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Finds the slots of a group that are empty or deleted (the only control bytes with the high bit set)
+ */
+static inline unsigned int group_match_free(const int8_t *group)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+        mask |= (unsigned int)(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline const char *slot_key(const SwissSlot *slot)
+{
+    return slot->key_size <= SWISS_INLINE_KEY_SIZE ? slot->inline_key : slot->heap_key;
+}
+
+/**
+ * @brief Finds the slot holding a key
+ *
+ * Details: Groups are probed in triangular order (first group, +1, +2, +3, ...), which visits every group of a
+ *          table whose number of groups is a power of two. The search stops at the first group with an empty slot.
+ *
+ * @return The index of the slot, or -1 if the key is not in the table
+ */
+static long find_slot(SwissTable *st, uint64_t hash, const void *key, int key_size)
+{
+    size_t num_groups = st->capacity / SWISS_GROUP_SIZE;
+    size_t group = H1(hash) & (num_groups - 1);
+
+    for (size_t step = 1; step <= num_groups; step++) {
+        const int8_t *ctrl = st->ctrl + group * SWISS_GROUP_SIZE;
+        unsigned int match = group_match(ctrl, H2(hash));
+
+        while (match != 0) {
+            size_t index = group * SWISS_GROUP_SIZE + __builtin_ctz(match);
+            SwissSlot *slot = &st->slots[index];
+
+            if (slot->hash == hash && slot->key_size == key_size && memcmp(slot_key(slot), key, key_size) == 0) {
+                return index;
+            }
+            match &= match - 1;
+        }
+
+        if (group_match(ctrl, SWISS_EMPTY) != 0) {
+            return -1;
+        }
+        group = (group + step) & (num_groups - 1);
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Finds the first empty or deleted slot in the probe sequence of a hash (there always is one)
+ */
+static size_t find_free(SwissTable *st, uint64_t hash)
+{
+    size_t num_groups = st->capacity / SWISS_GROUP_SIZE;
+    size_t group = H1(hash) & (num_groups - 1);
+
+    for (size_t step = 1;; step++) {
+        unsigned int free_slots = group_match_free(st->ctrl + group * SWISS_GROUP_SIZE);
+        if (free_slots != 0) {
+            return group * SWISS_GROUP_SIZE + __builtin_ctz(free_slots);
+        }
+        group = (group + step) & (num_groups - 1);
+    }
+}
+
+/**
+ * @brief Allocates the control bytes and slots of a table with the given capacity, all empty
+ *
+ * @return 0 on success, -1 if memory allocation failed
+ */
+static int allocate_slots(SwissTable *st, size_t capacity)
+{
+    st->ctrl = aligned_alloc(SWISS_GROUP_SIZE, capacity);
+    st->slots = malloc(capacity * sizeof(SwissSlot));
+    if (st->ctrl == NULL || st->slots == NULL) {
+        free(st->ctrl);
+        free(st->slots);
+        return -1;
+    }
+
+    memset(st->ctrl, SWISS_EMPTY, capacity);
+    st->capacity = capacity;
+    st->num_deleted = 0;
+    return 0;
+}
+
+/**
+ * @brief Moves every entry into new arrays of the given capacity, dropping deleted slots
+ *
+ * @return 0 on success, -1 if memory allocation failed (the table is left unchanged)
+ */
+static int swiss_rehash(SwissTable *st, size_t capacity)
+{
+    SwissTable old = *st;
+
+    if (allocate_slots(st, capacity) == -1) {
+        *st = old;
+        return -1;
+    }
+
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.ctrl[i] < 0) {
+            continue;
+        }
+        size_t index = find_free(st, old.slots[i].hash);
+        st->ctrl[index] = old.ctrl[i];
+        st->slots[index] = old.slots[i];   // inline keys move with the slot, heap keys keep their copy
+    }
+
+    free(old.ctrl);
+    free(old.slots);
+    return 0;
+}
+
+/**
+ * @brief Creates a new SwissTable
+ *
+ * Details: The table starts with enough slots to hold size entries without growing.
+ *
+ * @param[in] size The number of entries expected (the table grows beyond it as needed)
+ * @return A pointer to the newly created table, or NULL if memory allocation failed
+ */
+SwissTable *Swisstable_create(int size)
+{
+    size_t capacity = SWISS_MIN_CAPACITY;
+
+    while (size > 0 && capacity * 7 / 8 < (size_t)size) {
+        capacity *= 2;
+    }
+
+    SwissTable *st = calloc(1, sizeof(SwissTable));
+    if (st == NULL) {
+        return NULL;
+    }
+
+    if (allocate_slots(st, capacity) == -1) {
+        free(st);
+        return NULL;
+    }
+
+    return st;
+}
+
+/**
+ * @brief Destroys a SwissTable
+ *
+ * Details: The copies of the keys are freed; the data is not.
+ *
+ * @param[in] st The table to be destroyed
+ */
+void Swisstable_destroy(SwissTable *st)
+{
+    if (st == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < st->capacity; i++) {
+        if (st->ctrl[i] >= 0 && st->slots[i].key_size > SWISS_INLINE_KEY_SIZE) {
+            free(st->slots[i].heap_key);
+        }
+    }
+
+    free(st->ctrl);
+    free(st->slots);
+    free(st);
+}
+
+/**
+ * @brief Inserts a key-value pair using a string key
+ *
+ * @param[in, out] st A pointer to a table
+ * @param[in] key A pointer to a string key
+ * @param[in] data A pointer to a value
+ * @return The value that was inserted, or NULL if the insertion failed
+ */
+void *Swisstable_put(SwissTable *st, char *key, void *data)
+{
+    return Swisstable_put_bin(st, key, strlen(key), data);
+}
+
+/**
+ * @brief Inserts a key-value pair, or replaces the value of a key that is already in the table
+ *
+ * Details: The key is copied into the table. When live and deleted slots would exceed 7/8 of the capacity the
+ *          table first grows to twice its size (or is only rebuilt in place if most of those slots are deleted).
+ *
+ * @param[in, out] st A pointer to a table
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @param[in] data A pointer to a value
+ * @return The value that was inserted, or NULL if the insertion failed
+ */
+void *Swisstable_put_bin(SwissTable *st, void *key, int key_size, void *data)
+{
+    uint64_t hash = hash_bytes(key, key_size);
+    long found = find_slot(st, hash, key, key_size);
+
+    if (found >= 0) {
+        st->slots[found].data = data;
+        return data;
+    }
+
+    if ((st->num_entries + st->num_deleted + 1) * 8 > st->capacity * 7) {
+        size_t capacity = (size_t)(st->num_entries + 1) * 16 > st->capacity * 7 ? st->capacity * 2 : st->capacity;
+        if (swiss_rehash(st, capacity) == -1) {
+            return NULL;
+        }
+    }
+
+    size_t index = find_free(st, hash);
+    SwissSlot *slot = &st->slots[index];
+
+    if (key_size > SWISS_INLINE_KEY_SIZE) {
+        slot->heap_key = malloc(key_size);
+        if (slot->heap_key == NULL) {
+            return NULL;
+        }
+        memcpy(slot->heap_key, key, key_size);
+    }
+    else {
+        memcpy(slot->inline_key, key, key_size);
+    }
+
+    if (st->ctrl[index] == SWISS_DELETED) {
+        st->num_deleted--;
+    }
+    slot->hash = hash;
+    slot->key_size = key_size;
+    slot->data = data;
+    st->ctrl[index] = H2(hash);
+    st->num_entries++;
+
+    return data;
+}
+
+/**
+ * @brief Retrieves a value using a string key
+ *
+ * @param[in] st A pointer to a table
+ * @param[in] key A pointer to a string key
+ * @return The value associated with the key, or NULL if the key is not found
+ */
+void *Swisstable_get(SwissTable *st, char *key)
+{
+    return Swisstable_get_bin(st, key, strlen(key));
+}
+
+/**
+ * @brief Retrieves a value
+ *
+ * @param[in] st A pointer to a table
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @return The value associated with the key, or NULL if the key is not found
+ */
+void *Swisstable_get_bin(SwissTable *st, void *key, int key_size)
+{
+    long index = find_slot(st, hash_bytes(key, key_size), key, key_size);
+
+    return index >= 0 ? st->slots[index].data : NULL;
+}
+
+/**
+ * @brief Deletes a key-value pair using a string key
+ *
+ * @param[in, out] st A pointer to a table
+ * @param[in] key A pointer to a string key
+ * @return The value that was deleted, or NULL if the key was not found
+ */
+void *Swisstable_delete(SwissTable *st, char *key)
+{
+    return Swisstable_delete_bin(st, key, strlen(key));
+}
+
+/**
+ * @brief Deletes a key-value pair
+ *
+ * Details: The copy of the key is freed; the data is returned to the caller. If the slot's group still has an
+ *          empty slot no probe sequence has ever run past it, so the slot becomes empty again; otherwise it is
+ *          marked deleted.
+ *
+ * @param[in, out] st A pointer to a table
+ * @param[in] key A pointer to a key
+ * @param[in] key_size The size of the key
+ * @return The value that was deleted, or NULL if the key was not found
+ */
+void *Swisstable_delete_bin(SwissTable *st, void *key, int key_size)
+{
+    long index = find_slot(st, hash_bytes(key, key_size), key, key_size);
+
+    if (index < 0) {
+        return NULL;
+    }
+
+    SwissSlot *slot = &st->slots[index];
+    void *data = slot->data;
+
+    if (slot->key_size > SWISS_INLINE_KEY_SIZE) {
+        free(slot->heap_key);
+    }
+
+    if (group_match(st->ctrl + (index & ~(long)(SWISS_GROUP_SIZE - 1)), SWISS_EMPTY) != 0) {
+        st->ctrl[index] = SWISS_EMPTY;
+    }
+    else {
+        st->ctrl[index] = SWISS_DELETED;
+        st->num_deleted++;
+    }
+    st->num_entries--;
+
+    return data;
+}
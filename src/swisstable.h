@@ -0,0 +1,76 @@
+/**
+ * @file swisstable.h
+ * @brief An open-addressing hash table that probes 16 slots at a time
+ * @authors
+ *
+ * Details:
+ * - A SwissTable maps keys of any type to data pointers, like HashTable, with the same put/get/delete functions
+ *   for string and binary keys. Instead of a linked list per bucket it keeps every entry in one flat array of
+ *   slots, so a lookup does not chase pointers.
+ * - Next to the slots is an array of control bytes, one per slot: SWISS_EMPTY, SWISS_DELETED, or the low 7 bits
+ *   of the hash of the key in the slot (keys are hashed with hash_bytes(), see hash.h). Slots are probed in groups
+ *   of SWISS_GROUP_SIZE; the control bytes of a group are compared with the wanted 7 bits in a single SSE2
+ *   instruction, and only slots whose byte matches are looked at. A lookup usually touches one cache line of
+ *   control bytes and one slot.
+ * - Keys of up to SWISS_INLINE_KEY_SIZE bytes (file extensions, short paths) are stored inside the slot; longer
+ *   keys are copied to the heap. The full hash is kept in the slot so that growing the table never hashes a key
+ *   again.
+ * - The table doubles when live and deleted slots reach 7/8 of its capacity. Deleted slots are marked, not emptied,
+ *   so that probe sequences stay intact; growing the table drops them.
+ *
+ * Assumptions/Limitations:
+ * - Unlike Hashtable_put(), Swisstable_put() replaces the data of a key that is already in the table.
+ * - The table owns the copies of its keys, not the data. It is not thread-safe.
+ * - Without SSE2 the groups are scanned one byte at a time with the same layout.
+ *
+ * @date 2026-10-17
+ */
+#ifndef SWISS_TABLE_H
+#define SWISS_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define SWISS_GROUP_SIZE 16
+#define SWISS_INLINE_KEY_SIZE 24
+#define SWISS_MIN_CAPACITY 16
+#define SWISS_EMPTY ((int8_t)-128)
+#define SWISS_DELETED ((int8_t)-2)
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct {
+    uint64_t hash;                  /* full hash of the key */
+    void *data;
+    int key_size;
+    union {
+        char inline_key[SWISS_INLINE_KEY_SIZE];     /* key_size <= SWISS_INLINE_KEY_SIZE */
+        char *heap_key;                             /* longer keys */
+    };
+} SwissSlot;
+
+typedef struct {
+    int8_t *ctrl;                   /* control byte of every slot (16-byte aligned) */
+    SwissSlot *slots;
+    size_t capacity;                /* number of slots (a power of two, at least SWISS_MIN_CAPACITY) */
+    int num_entries;
+    int num_deleted;                /* slots marked SWISS_DELETED */
+} SwissTable;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern SwissTable *Swisstable_create(int size);
+extern void Swisstable_destroy(SwissTable *st);
+
+extern void *Swisstable_put(SwissTable *st, char *key, void *data);
+extern void *Swisstable_put_bin(SwissTable *st, void *key, int key_size, void *data);
+
+extern void *Swisstable_get(SwissTable *st, char *key);
+extern void *Swisstable_get_bin(SwissTable *st, void *key, int key_size);
+
+extern void *Swisstable_delete(SwissTable *st, char *key);
+extern void *Swisstable_delete_bin(SwissTable *st, void *key, int key_size);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file timerwheel.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "timerwheel.h"
+
+#define TIMER_WHEEL_RANGE (1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))   /* ticks the wheel can look ahead */
+
+/**
+ * @brief Links a timer into the slot that covers its deadline
+ *
+ * Details: The timer must not expire before the current tick. Its level is the lowest one whose slots, counted from
+ *          the current tick, reach its deadline; the slot is picked by the bits of the deadline itself, so that it
+ *          is reached (or cascaded) no later than the deadline.
+ *
+ * @param[in, out] wheel The wheel
+ * @param[in, out] timer The timer
+ */
+static void wheel_place(Timer_wheel *wheel, Timer *timer)
+{
+    unsigned long delta = timer->expires - wheel->now;
+    int level = 0;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >> (TIMER_WHEEL_BITS * (level + 1)) != 0)
+        level++;
+
+    Timer **slot = &wheel->slots[level][(timer->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+
+    timer->next = *slot;
+    if (timer->next != NULL)
+        timer->next->pprev = &timer->next;
+    timer->pprev = slot;
+    *slot = timer;
+}
+
+/**
+ * @brief Spreads the current slot of a level over the levels below it
+ *
+ * @param[in, out] wheel The wheel
+ * @param[in] level The level (1 or higher)
+ */
+static void wheel_cascade(Timer_wheel *wheel, int level)
+{
+    Timer **slot = &wheel->slots[level][(wheel->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+    Timer *timer = *slot;
+
+    *slot = NULL;
+    while (timer != NULL)
+    {
+        Timer *next = timer->next;
+        wheel_place(wheel, timer);
+        timer = next;
+    }
+}
+
+/**
+ * @brief Returns the current value of the monotonic clock in milliseconds
+ *
+ * @return The number of milliseconds since an unspecified starting point
+ */
+long timer_now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000L + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Initializes an empty wheel
+ *
+ * @param[out] wheel The wheel
+ * @param[in] now_ms The current time (monotonic milliseconds), which becomes tick 0
+ * @param[in] tick_ms The length of a tick in milliseconds
+ */
+void timer_wheel_init(Timer_wheel *wheel, long now_ms, int tick_ms)
+{
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        for (int i = 0; i < TIMER_WHEEL_SLOTS; i++)
+            wheel->slots[level][i] = NULL;
+    }
+
+    wheel->now = 0;
+    wheel->origin_ms = now_ms;
+    wheel->tick_ms = tick_ms;
+    wheel->num_timers = 0;
+}
+
+/**
+ * @brief Starts a timer, or moves it if it is already pending
+ *
+ * Details: The deadline is rounded up to a tick. A deadline that has already passed fires on the next tick.
+ *
+ * @param[in, out] wheel The wheel
+ * @param[in, out] timer The timer (zeroed or previously used with this wheel)
+ * @param[in] expires_ms The deadline (monotonic milliseconds)
+ */
+void timer_add(Timer_wheel *wheel, Timer *timer, long expires_ms)
+{
+    long ms = expires_ms - wheel->origin_ms;
+    unsigned long expires = ms > 0 ? (unsigned long)(ms + wheel->tick_ms - 1) / wheel->tick_ms : 0;
+
+    if (expires <= wheel->now)
+        expires = wheel->now + 1;
+    else if (expires - wheel->now >= TIMER_WHEEL_RANGE)
+        expires = wheel->now + TIMER_WHEEL_RANGE - 1;
+
+    timer_cancel(wheel, timer);
+    timer->expires = expires;
+    wheel_place(wheel, timer);
+    wheel->num_timers++;
+}
+
+/**
+ * @brief Stops a timer (nothing happens if it is not pending)
+ *
+ * @param[in, out] wheel The wheel
+ * @param[in, out] timer The timer
+ */
+void timer_cancel(Timer_wheel *wheel, Timer *timer)
+{
+    if (!timer_pending(timer))
+        return;
+
+    *timer->pprev = timer->next;
+    if (timer->next != NULL)
+        timer->next->pprev = timer->pprev;
+    timer->pprev = NULL;
+    wheel->num_timers--;
+}
+
+/**
+ * @brief Moves the wheel to the current time and collects the timers that expired
+ *
+ * Details: Every tick since the last call is processed in order. Once no timer is pending the wheel jumps straight
+ *          to the current tick, so a long quiet period costs nothing.
+ *
+ * @param[in, out] wheel The wheel
+ * @param[in] now_ms The current time (monotonic milliseconds)
+ * @return The expired timers linked through their next field (no longer pending), or NULL if there are none
+ */
+Timer *timer_wheel_advance(Timer_wheel *wheel, long now_ms)
+{
+    Timer *expired = NULL;
+
+    if (now_ms < wheel->origin_ms)
+        return NULL;
+
+    unsigned long target = (unsigned long)(now_ms - wheel->origin_ms) / wheel->tick_ms;
+
+    while (wheel->now < target)
+    {
+        if (wheel->num_timers == 0)
+        {
+            wheel->now = target;
+            break;
+        }
+
+        wheel->now++;
+        for (int level = 1;
+             level < TIMER_WHEEL_LEVELS && ((wheel->now >> (TIMER_WHEEL_BITS * (level - 1))) & TIMER_WHEEL_MASK) == 0;
+             level++)
+            wheel_cascade(wheel, level);
+
+        Timer **slot = &wheel->slots[0][wheel->now & TIMER_WHEEL_MASK];
+        Timer *timer = *slot;
+
+        *slot = NULL;
+        while (timer != NULL)
+        {
+            Timer *next = timer->next;
+            timer->pprev = NULL;
+            timer->next = expired;
+            expired = timer;
+            wheel->num_timers--;
+            timer = next;
+        }
+    }
+
+    return expired;
+}
+
+/**
+ * @brief Returns how long the caller may sleep before it has to advance the wheel again
+ *
+ * @param[in] wheel The wheel
+ * @param[in] now_ms The current time (monotonic milliseconds)
+ * @return The number of milliseconds until the next tick starts
+ */
+int timer_wheel_timeout(const Timer_wheel *wheel, long now_ms)
+{
+    long elapsed = now_ms - wheel->origin_ms;
+
+    if (elapsed < 0)
+        return wheel->tick_ms;
+
+    return wheel->tick_ms - (int)(elapsed % wheel->tick_ms);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file timerwheel.h
+ * @brief A hierarchical timer wheel for connection deadlines
+ * @authors
+ *
+ * Details:
+ * - Time is counted in ticks of a fixed length. The wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots;
+ *   a slot of level 0 holds the timers of one tick, a slot of level n those of TIMER_WHEEL_SLOTS^n ticks. A timer
+ *   is put in the lowest level whose range covers its deadline.
+ * - Timers are embedded in the structure they belong to (intrusive), so adding and cancelling one is O(1) and
+ *   never allocates.
+ * - timer_wheel_advance() moves the wheel to the current time. Every TIMER_WHEEL_SLOTS ticks the next slot of the
+ *   level above is spread over the level below (cascading). The timers that expired are handed back as one list,
+ *   so the caller can deal with all of them in a single batch.
+ *
+ * Assumptions/Limitations:
+ * - A timer fires at most one tick late. Deadlines further away than TIMER_WHEEL_SLOTS^TIMER_WHEEL_LEVELS ticks
+ *   are cut down to that.
+ * - The wheel is not thread safe; the caller serializes access to it.
+ *
+ * @date 2026-10-17
+ */
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)   /* slots per level */
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Timer {
+    struct Timer *next;             /* next timer in the slot (or in the list of expired timers) */
+    struct Timer **pprev;           /* link pointing at this timer; NULL while the timer is not pending */
+    unsigned long expires;          /* tick the timer fires at */
+} Timer;
+
+typedef struct {
+    Timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    unsigned long now;              /* last tick processed */
+    long origin_ms;                 /* time of tick 0 (monotonic milliseconds) */
+    int tick_ms;                    /* length of a tick */
+    int num_timers;                 /* number of pending timers */
+} Timer_wheel;
+
+#define timer_entry(timer, type, member) ((type *)((char *)(timer) - offsetof(type, member)))
+
+static inline bool timer_pending(const Timer *timer)
+{
+    return timer->pprev != NULL;
+}
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern long timer_now_ms();
+extern void timer_wheel_init(Timer_wheel *wheel, long now_ms, int tick_ms);
+extern void timer_add(Timer_wheel *wheel, Timer *timer, long expires_ms);
+extern void timer_cancel(Timer_wheel *wheel, Timer *timer);
+extern Timer *timer_wheel_advance(Timer_wheel *wheel, long now_ms);
+extern int timer_wheel_timeout(const Timer_wheel *wheel, long now_ms);
+
+#endif
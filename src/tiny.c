@@ -1,4 +1,5 @@
-#include "server.h"
+#include "shard.h"
+#include "scan.h"
 
 void print_logo()
 {
@@ -28,30 +29,24 @@ int main(int argc, char *argv[])
     start_server(&server, argc, argv);
 
     create_mime_db();
-    // ThreadPool *pool = thread_pool_create(1);
-    ThreadPool *pool = thread_pool_create(server.config.num_threads); // forgot to change back to this in submission
-    int connection_count = 0;
+    create_file_cache(server.config.cache_size);
+    create_fd_cache();
 
-    while (1)
+    printf("Server: header scanning uses %s\n", scan_level_name(scan_init()));
+
+    Shard *shards = shards_create(&server);
+    if (shards == NULL)
     {
-        struct rusage usage;
-        struct timeval start, wall_start;
-
-        // Get the start time
-        getrusage(RUSAGE_SELF, &usage);
-        start = usage.ru_utime;
-        gettimeofday(&wall_start, NULL); // Get the wall start time
-
-        accept_client(&server, pool, &connection_count);
-        
-        if(server.config.enable_stats == ON) 
-            calculate_usage(start, wall_start);
+        fprintf(stderr, "Failed to create the event loop\n");
+        exit(EXIT_FAILURE);
     }
 
+    shards_run(shards, server.config.num_shards);
+
+    destroy_fd_cache();
+    destroy_file_cache();
     destroy_mime_db();
-    thread_pool_wait(pool);
-    thread_pool_destroy(pool);
-    close(server.sockfd);
+    shards_destroy(shards, server.config.num_shards);
 
     return 0;
-}
\ No newline at end of file
+}
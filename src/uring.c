@@ -0,0 +1,666 @@
+/**
+ * @file uring.c
+ * @authors
+ *
+ * @date 2026-10-17
+ */
+#include "uring.h"
+
+/* the low bits of an sqe's user_data say which operation completed (Http_client is at least 8 byte aligned) */
+#define UD_ACCEPT 0
+#define UD_RECV 1
+#define UD_TICK 2
+#define UD_CLOSE 3
+#define UD_WAKEUP 4
+#define UD_CANCEL 5
+#define UD_TAG_MASK 7
+
+#define UD(ptr, tag) ((uint64_t)(uintptr_t)(ptr) | (tag))
+#define UD_CLIENT(ud) ((Http_client *)(uintptr_t)((ud) & ~(uint64_t)UD_TAG_MASK))
+
+static const struct __kernel_timespec tick_timeout = {.tv_sec = 0, .tv_nsec = TIMER_TICK_MS * 1000000L};
+
+/* ----------< System calls >---------- */
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* ----------< Submission queue >---------- */
+
+/**
+ * @brief Publishes queued submissions to the kernel and optionally waits for completions
+ *
+ * @param[in] uring The ring
+ * @param[in] min_complete The number of completions to wait for (0 to not wait)
+ * @return The number of submissions consumed, or -1 if there was an error
+ */
+static int uring_submit(Uring *uring, unsigned min_complete)
+{
+    unsigned to_submit = uring->sq_local_tail - *uring->sq_tail;
+
+    __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+
+    int ret;
+    do
+    {
+        ret = sys_io_uring_enter(uring->ring_fd, to_submit, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret == -1 && errno == EINTR && min_complete == 0);
+
+    return ret;
+}
+
+/**
+ * @brief Returns an empty submission queue entry, flushing the queue to the kernel if it is full
+ *
+ * @param[in] uring The ring
+ * @return A zeroed sqe that will be submitted by the next uring_submit()
+ */
+static struct io_uring_sqe *uring_get_sqe(Uring *uring)
+{
+    while (uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries)
+    {
+        uring_submit(uring, 0);
+    }
+
+    unsigned index = uring->sq_local_tail & *uring->sq_mask;
+    struct io_uring_sqe *sqe = &uring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    uring->sq_array[index] = index;
+    uring->sq_local_tail++;
+
+    return sqe;
+}
+
+/**
+ * @brief Queues a multishot accept on the listening socket
+ *
+ * @param[in] uring The ring
+ */
+static void queue_accept(Uring *uring)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = uring->listenfd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = UD(NULL, UD_ACCEPT);
+}
+
+/**
+ * @brief Queues a read on the eventfd that workers use to wake the ring thread
+ *
+ * @param[in] uring The ring
+ */
+static void queue_wakeup(Uring *uring)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = uring->efd;
+    sqe->addr = (uint64_t)(uintptr_t)&uring->efd_value;
+    sqe->len = sizeof(uring->efd_value);
+    sqe->user_data = UD(NULL, UD_WAKEUP);
+}
+
+/**
+ * @brief Queues the close of a connection's socket and frees the connection
+ *
+ * @param[in] uring The ring
+ * @param[in] client The connection to be closed
+ */
+static void queue_close(Uring *uring, Http_client *client)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = client->connfd;
+    sqe->user_data = UD(NULL, UD_CLOSE);
+
+    timer_cancel(&uring->timers, &client->timer);
+    release_input(client);
+    free_client(client);
+}
+
+/**
+ * @brief Queues a receive for the next request on a connection
+ *
+ * Details: The kernel picks a buffer from the provided buffer ring when data arrives. The connection's timer is set
+ *          to the deadline of what it is waiting for (see request_deadline()); if the header or body deadline has
+ *          already passed the connection is closed instead.
+ *
+ * @param[in] uring The ring
+ * @param[in] client The connection
+ */
+static void queue_recv(Uring *uring, Http_client *client)
+{
+    long now = timer_now_ms();
+    long deadline = request_deadline(client, now);
+    if (deadline <= now)
+    {
+        printf("Timeout, closing connection\n");
+        queue_close(uring, client);
+        return;
+    }
+    timer_add(&uring->timers, &client->timer, deadline);
+
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = client->connfd;
+    sqe->len = URING_BUF_SIZE;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->user_data = UD(client, UD_RECV);
+}
+
+/**
+ * @brief Queues the cancellation of a connection's pending receive
+ *
+ * Details: The receive then completes with -ECANCELED and on_recv() closes the connection. If it has completed
+ *          already the cancellation finds nothing and the connection carries on.
+ *
+ * @param[in] uring The ring
+ * @param[in] client The connection
+ */
+static void queue_cancel(Uring *uring, Http_client *client)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = UD(client, UD_RECV);
+    sqe->user_data = UD(NULL, UD_CANCEL);
+}
+
+/**
+ * @brief Queues a timeout that wakes the ring thread on the next tick of its timer wheel
+ *
+ * @param[in] uring The ring
+ */
+static void queue_tick(Uring *uring)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(uring);
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)(uintptr_t)&tick_timeout;
+    sqe->len = 1;
+    sqe->user_data = UD(NULL, UD_TICK);
+}
+
+/* ----------< Receive buffers >---------- */
+
+/**
+ * @brief Hands a receive buffer back to the kernel
+ *
+ * @param[in] uring The ring
+ * @param[in] buf_id The id of the buffer
+ */
+static void return_buffer(Uring *uring, int buf_id)
+{
+    unsigned mask = URING_NUM_BUFS - 1;
+    struct io_uring_buf *buf = &uring->buf_ring->bufs[uring->buf_tail & mask];
+
+    buf->addr = (uint64_t)(uintptr_t)(uring->bufs + (size_t)buf_id * URING_BUF_SIZE);
+    buf->len = URING_BUF_SIZE;
+    buf->bid = buf_id;
+
+    uring->buf_tail++;
+    __atomic_store_n(&uring->buf_ring->tail, uring->buf_tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Re-queues the receives of connections that ran out of buffers
+ *
+ * Details: A connection whose deadline passed while it was waiting for a buffer is closed (see queue_recv()).
+ *
+ * @param[in] uring The ring
+ */
+static void retry_starved(Uring *uring)
+{
+    Http_client *client = uring->starved;
+    uring->starved = NULL;
+
+    while (client != NULL)
+    {
+        Http_client *next = client->next;
+        queue_recv(uring, client);
+        client = next;
+    }
+}
+
+/* ----------< Completions >---------- */
+
+/**
+ * @brief Finishes a request that a worker has answered
+ *
+ * @param[in] uring The ring
+ * @param[in] client The connection
+ */
+static void finish_request(Uring *uring, Http_client *client)
+{
+    if (client->keep_alive)
+        queue_recv(uring, client);
+    else
+        queue_close(uring, client);
+}
+
+/**
+ * @brief Handles the completion of an accept
+ *
+ * @param[in] uring The ring
+ * @param[in] cqe The completion
+ */
+static void on_accept(Uring *uring, struct io_uring_cqe *cqe)
+{
+    if (cqe->res < 0)
+    {
+        fprintf(stderr, "accept: %s\n", strerror(-cqe->res));
+        // an accept that failed (e.g. out of descriptors) would fail again at once; retry on the next tick
+        if (!(cqe->flags & IORING_CQE_F_MORE))
+            uring->accept_paused = 1;
+        return;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+        queue_accept(uring); // the multishot accept was terminated (or is unsupported); start a new one
+
+    shed_reason reason = admission_check(&uring->server->config, uring->pool, true);
+    if (reason != ADMIT)
+    {
+        send_overloaded(cqe->res, reason);
+        close(cqe->res);
+        return;
+    }
+
+    Http_client *client = create_client();
+    if (client == NULL)
+    {
+        close(cqe->res);
+        return;
+    }
+
+    socklen_t addr_size = sizeof(client->client_addr);
+    client->connfd = cqe->res;
+    client->uring = uring;
+    client->state = CONN_IDLE;
+    getpeername(client->connfd, (SA *)&client->client_addr, &addr_size);
+
+    printf("Server: got connection from %s\n", inet_ntoa(client->client_addr.sin_addr));
+    uring->connection_count++;
+    printf("Server: connection count is %d\n", uring->connection_count);
+
+    queue_recv(uring, client);
+}
+
+/**
+ * @brief Handles the completion of a receive
+ *
+ * @param[in] uring The ring
+ * @param[in] client The connection
+ * @param[in] cqe The completion
+ */
+static void on_recv(Uring *uring, Http_client *client, struct io_uring_cqe *cqe)
+{
+    if (cqe->res == -ENOBUFS)
+    {
+        // every buffer is in use; retried after the next receive or tick, with the timer still running
+        client->next = uring->starved;
+        uring->starved = client;
+        return;
+    }
+
+    timer_cancel(&uring->timers, &client->timer);
+
+    if (cqe->res <= 0)
+    {
+        // the client hung up, timed out or the socket failed
+        if (cqe->flags & IORING_CQE_F_BUFFER)
+            return_buffer(uring, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        queue_close(uring, client);
+        return;
+    }
+
+    // the bytes are parsed into the connection's own input buffer so the receive buffer can be reused at once
+    int buf_id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+    Recv_status status = feed_request(client, uring->bufs + (size_t)buf_id * URING_BUF_SIZE, cqe->res);
+    return_buffer(uring, buf_id);
+
+    if (uring->starved != NULL)
+        retry_starved(uring);
+
+    switch (status)
+    {
+    case RECV_DONE:
+        break;
+    case RECV_AGAIN:
+        queue_recv(uring, client);
+        return;
+    case RECV_INVALID:
+        send_bad_request(client->connfd);
+        queue_close(uring, client);
+        return;
+    case RECV_CLOSED:
+        queue_close(uring, client);
+        return;
+    }
+
+    shed_reason reason = admission_check(&uring->server->config, uring->pool, false);
+    if (reason != ADMIT)
+    {
+        send_overloaded(client->connfd, reason);
+        queue_close(uring, client);
+        return;
+    }
+
+    client->state = CONN_BUSY;
+
+    if (uring->server->config.enable_mt == ON)
+    {
+        thread_pool_submit_lane(uring->pool, &client->task, classify_request(client, &uring->server->config),
+                                uring_serve, client);
+    }
+    else
+    {
+        client->keep_alive = serve_connection(client, &uring->server->config);
+        finish_request(uring, client);
+    }
+}
+
+/**
+ * @brief Handles a wake up from the workers by finishing every answered request
+ *
+ * @param[in] uring The ring
+ * @param[in] cqe The completion of the eventfd read
+ */
+static void on_wakeup(Uring *uring, struct io_uring_cqe *cqe)
+{
+    (void)cqe;
+
+    pthread_mutex_lock(&uring->done_lock);
+    Http_client *client = uring->done;
+    uring->done = NULL;
+    pthread_mutex_unlock(&uring->done_lock);
+
+    while (client != NULL)
+    {
+        Http_client *next = client->next;
+        finish_request(uring, client);
+        client = next;
+    }
+
+    queue_wakeup(uring);
+}
+
+/**
+ * @brief Handles a tick by cancelling the receives of every connection whose deadline has passed
+ *
+ * Details: The expired connections are collected from the timer wheel in one batch. Their cancelled receives
+ *          complete with an error, upon which on_recv() closes them. Connections that ran out of receive
+ *          buffers are retried first, so that they are not left waiting once no receive completes any more,
+ *          and an accept paused after an error is queued again.
+ *
+ * @param[in] uring The ring
+ * @param[in] cqe The completion of the tick's timeout
+ */
+static void on_tick(Uring *uring, struct io_uring_cqe *cqe)
+{
+    (void)cqe;
+
+    if (uring->starved != NULL)
+        retry_starved(uring);
+
+    Timer *timer = timer_wheel_advance(&uring->timers, timer_now_ms());
+    while (timer != NULL)
+    {
+        Timer *next = timer->next;
+        queue_cancel(uring, timer_entry(timer, Http_client, timer));
+        timer = next;
+    }
+
+    if (uring->accept_paused)
+    {
+        uring->accept_paused = 0;
+        queue_accept(uring);
+    }
+
+    queue_tick(uring);
+}
+
+/* ----------< Uring >---------- */
+
+/**
+ * @brief Creates an io_uring instance for a listening socket that is already bound
+ *
+ * Details: Maps the submission and completion queues, registers the provided buffer ring and creates the
+ *          eventfd used by the workers. Returns NULL if the kernel does not support any of these, in which
+ *          case the caller should fall back to the epoll reactor.
+ *
+ * @param[in] server The server whose configuration is used to serve requests
+ * @param[in] pool The thread pool that requests are dispatched to
+ * @param[in] listenfd The listening socket to accept connections from
+ * @return A pointer to the new ring, or NULL if it could not be created
+ */
+Uring *uring_create(Http_server *server, ThreadPool *pool, int listenfd)
+{
+    Uring *uring = calloc(1, sizeof(Uring));
+    if (uring == NULL)
+        return NULL;
+
+    uring->server = server;
+    uring->pool = pool;
+    uring->listenfd = listenfd;
+    uring->ring_fd = -1;
+    uring->efd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    uring->ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+    if (uring->ring_fd == -1)
+    {
+        perror("io_uring_setup");
+        uring_destroy(uring);
+        return NULL;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP))
+    {
+        fprintf(stderr, "io_uring: kernel is too old\n");
+        uring_destroy(uring);
+        return NULL;
+    }
+
+    /* the submission and completion rings share one mapping */
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (uring->cq_ring_size > uring->sq_ring_size)
+        uring->sq_ring_size = uring->cq_ring_size;
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          uring->ring_fd, IORING_OFF_SQ_RING);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       uring->ring_fd, IORING_OFF_SQES);
+    if (uring->sq_ring == MAP_FAILED || uring->sqes == MAP_FAILED)
+    {
+        perror("mmap");
+        uring_destroy(uring);
+        return NULL;
+    }
+    uring->cq_ring = uring->sq_ring;
+
+    char *sq = uring->sq_ring, *cq = uring->cq_ring;
+    uring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    uring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    uring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    uring->sq_entries = params.sq_entries;
+    uring->sq_local_tail = *uring->sq_tail;
+    uring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    uring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    uring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    /* provided buffer ring for receives */
+    size_t ring_bytes = URING_NUM_BUFS * sizeof(struct io_uring_buf);
+    uring->buf_ring = mmap(NULL, ring_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uring->bufs = malloc((size_t)URING_NUM_BUFS * URING_BUF_SIZE);
+    if (uring->buf_ring == MAP_FAILED || uring->bufs == NULL)
+    {
+        perror("buffer ring");
+        uring_destroy(uring);
+        return NULL;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)uring->buf_ring;
+    reg.ring_entries = URING_NUM_BUFS;
+    reg.bgid = URING_BUF_GROUP;
+    if (sys_io_uring_register(uring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+    {
+        perror("io_uring_register");
+        uring_destroy(uring);
+        return NULL;
+    }
+
+    for (int i = 0; i < URING_NUM_BUFS; i++)
+        return_buffer(uring, i);
+
+    uring->efd = eventfd(0, EFD_CLOEXEC);
+    if (uring->efd == -1 || pthread_mutex_init(&uring->done_lock, NULL) != 0)
+    {
+        perror("eventfd");
+        uring_destroy(uring);
+        return NULL;
+    }
+
+    timer_wheel_init(&uring->timers, timer_now_ms(), TIMER_TICK_MS);
+    queue_accept(uring);
+    queue_wakeup(uring);
+    queue_tick(uring);
+
+    return uring;
+}
+
+/**
+ * @brief Destroys a ring
+ *
+ * Details: Closing the ring cancels every outstanding operation. Connections that are still open are not
+ *          tracked by the ring and are released when the process exits.
+ *
+ * @param[in] uring The ring to be destroyed
+ */
+void uring_destroy(Uring *uring)
+{
+    if (uring == NULL)
+        return;
+
+    if (uring->efd != -1)
+    {
+        pthread_mutex_destroy(&uring->done_lock);
+        close(uring->efd);
+    }
+    if (uring->ring_fd != -1)
+        close(uring->ring_fd);
+    if (uring->sq_ring != NULL && uring->sq_ring != MAP_FAILED)
+        munmap(uring->sq_ring, uring->sq_ring_size);
+    if (uring->sqes != NULL && uring->sqes != MAP_FAILED)
+        munmap(uring->sqes, uring->sqes_size);
+    if (uring->buf_ring != NULL && uring->buf_ring != MAP_FAILED)
+        munmap(uring->buf_ring, URING_NUM_BUFS * sizeof(struct io_uring_buf));
+    free(uring->bufs);
+    free(uring);
+}
+
+/**
+ * @brief Runs the ring's event loop
+ *
+ * Details: Each iteration submits every queued operation and waits for at least one completion in a single
+ *          io_uring_enter() call, then handles all available completions. This function only returns if
+ *          io_uring_enter() fails.
+ *
+ * @param[in] uring The ring to run
+ */
+void uring_run(Uring *uring)
+{
+    for (;;)
+    {
+        if (uring_submit(uring, 1) == -1 && errno != EINTR && errno != EBUSY)
+        {
+            perror("io_uring_enter");
+            return;
+        }
+
+        unsigned head = *uring->cq_head;
+        unsigned tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail)
+        {
+            struct io_uring_cqe cqe = uring->cqes[head & *uring->cq_mask];
+            head++;
+            __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+            switch (cqe.user_data & UD_TAG_MASK)
+            {
+            case UD_ACCEPT:
+                on_accept(uring, &cqe);
+                break;
+            case UD_RECV:
+                on_recv(uring, UD_CLIENT(cqe.user_data), &cqe);
+                break;
+            case UD_WAKEUP:
+                on_wakeup(uring, &cqe);
+                break;
+            case UD_TICK:
+                on_tick(uring, &cqe);
+                break;
+            default:
+                break; // cancellations and closes need no further work
+            }
+
+            tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+        }
+    }
+}
+
+/**
+ * @brief Serves one request on a connection and hands the connection back to the ring thread
+ *
+ * Details: Used as the thread pool task for a received request. The ring thread is woken through the eventfd
+ *          so that it can return the receive buffer and wait for the next request or close the connection.
+ *
+ * @param[in] arg A pointer to the Http_client to be served
+ * @return This function does not return a value
+ */
+void *uring_serve(void *arg)
+{
+    Http_client *client = (Http_client *)arg;
+    Uring *uring = client->uring;
+    uint64_t one = 1;
+
+    client->keep_alive = serve_connection(client, &uring->server->config);
+
+    pthread_mutex_lock(&uring->done_lock);
+    client->next = uring->done;
+    uring->done = client;
+    pthread_mutex_unlock(&uring->done_lock);
+
+    if (write(uring->efd, &one, sizeof(one)) == -1)
+        perror("eventfd");
+
+    return NULL;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file uring.h
+ * @brief An optional io_uring backend for accepting connections and reading requests
+ * @authors
+ *
+ * Details:
+ * - This is an alternative to the epoll reactor (see reactor.h) that is selected at runtime with `-u on`. If the
+ *   kernel does not support io_uring (or it is disabled), the server prints a message and falls back to epoll.
+ * - The ring is driven directly through the io_uring_setup/io_uring_enter/io_uring_register system calls, so no
+ *   extra library is needed.
+ * - Every loop iteration submits all queued work (accepts, receives, closes) and collects all completions with a
+ *   single io_uring_enter() call, instead of one system call per operation.
+ * - Connections are accepted with a multishot accept. Requests are received with buffer selection from a
+ *   provided buffer ring, so an idle connection does not pin a receive buffer.
+ * - A connection waiting for data has a timer in the ring's timer wheel (see timerwheel.h) set to its idle, header
+ *   or body deadline (see request_deadline()). A timeout wakes the ring thread every TIMER_TICK_MS milliseconds to
+ *   advance the wheel; the receives of all expired connections are cancelled, which closes them.
+ * - Received bytes are copied into the connection's input buffer and parsed on the ring thread, and the receive
+ *   buffer goes straight back to the kernel. A completely received request is handed to the ThreadPool. When the
+ *   worker is done it puts the connection on a done list and wakes the ring through an eventfd; the ring thread
+ *   then either waits for the next request or closes the connection.
+ * - Connections and requests over the admission budget are answered with 503 from the ring thread (see
+ *   admission.h).
+ *
+ * Assumptions/Limitations:
+ * - Only the ring thread touches the submission queue, completion queue and buffer ring.
+ * - Responses are still written by the worker threads with send()/sendfile(): they are produced on pool threads
+ *   while a ring has a single submitter, and sendfile() is already zero-copy.
+ * - Per-connection CPU/memory statistics (-s on) are only reported by the epoll reactor.
+ *
+ * @date 2026-10-17
+ */
+#ifndef URING_H
+#define URING_H
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+#include "server.h"
+#include "admission.h"
+
+#define URING_ENTRIES 1024
+#define URING_NUM_BUFS 64           /* must be a power of two */
+#define URING_BUF_SIZE 65536
+#define URING_BUF_GROUP 0
+
+/* ----------{ STRUCTURES AND TYPES }---------- */
+
+typedef struct Uring {
+    int ring_fd;
+    Http_server *server;            /* server whose configuration the ring uses */
+    ThreadPool *pool;               /* workers that requests are dispatched to */
+    int listenfd;                   /* listening socket the ring accepts connections from */
+    int efd;                        /* eventfd used by workers to wake up the ring thread */
+    uint64_t efd_value;             /* target of the pending eventfd read */
+
+    /* submission queue */
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;         /* tail including entries not yet published to the kernel */
+    struct io_uring_sqe *sqes;
+
+    /* completion queue */
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+
+    /* provided receive buffers */
+    struct io_uring_buf_ring *buf_ring;
+    char *bufs;
+    unsigned short buf_tail;
+
+    pthread_mutex_t done_lock;      /* protects the done list */
+    Http_client *done;              /* connections whose request has been answered by a worker */
+    Http_client *starved;           /* connections waiting for a free receive buffer */
+    Timer_wheel timers;             /* deadlines of the connections waiting for data */
+    int connection_count;           /* total number of connections accepted */
+    int accept_paused;              /* the accept failed and is queued again on the next tick */
+} Uring;
+
+/* ----------{ FUNCTION PROTOTYPES }---------- */
+
+extern Uring *uring_create(Http_server *server, ThreadPool *pool, int listenfd);
+extern void uring_destroy(Uring *uring);
+extern void uring_run(Uring *uring);
+extern void *uring_serve(void *arg);
+
+#endif